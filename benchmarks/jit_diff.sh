@@ -0,0 +1,32 @@
+#!/bin/sh
+# Differential test for --jit and --trace-jit: runs every example and
+# benchmark script with the tree interpreter, then with each engine under
+# each of them and both, and reports any script whose output (stdout and
+# stderr) differs.
+#
+# Usage: benchmarks/jit_diff.sh <path-to-interpreter> [engine...]
+bin=${1:?usage: $0 <path-to-interpreter> [engine...]}
+shift
+engines=${*:-"tree vm closure"}
+dir=$(dirname "$0")
+expected=$(mktemp)
+actual=$(mktemp)
+trap 'rm -f "$expected" "$actual"' EXIT
+
+failed=0
+for script in "$dir"/../examples/*.grm "$dir"/*.grm; do
+    "$bin" "$script" --engine=tree --cache=off >"$expected" 2>&1
+    for engine in $engines; do
+        for flags in "--jit" "--trace-jit" "--jit --trace-jit"; do
+            # shellcheck disable=SC2086
+            "$bin" "$script" --engine="$engine" --cache=off $flags >"$actual" 2>&1
+            if ! cmp -s "$expected" "$actual"; then
+                echo "DIFF $(basename "$script") --engine=$engine $flags"
+                diff "$expected" "$actual" | head -n 10
+                failed=1
+            fi
+        done
+    done
+done
+[ $failed = 0 ] && echo "no differences"
+exit $failed
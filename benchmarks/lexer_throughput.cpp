@@ -0,0 +1,242 @@
+// Tokenizer throughput in MB/s on large generated sources, once per
+// character scanner the CPU supports and once lexing in parallel.
+//
+// Usage: lexer_throughput [megabytes-per-input]
+//        lexer_throughput --check [file...]
+//
+// --check compares the parallel lexer with the sequential one, token for
+// token and error for error, on the given files and on random inputs.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/LexScanner.h"
+#include "core/Tokenizer.h"
+
+// Ordinary code: nested blocks, short identifiers, numbers and operators.
+static std::string generateCode(size_t bytes) {
+    std::string out;
+    for (size_t i = 0; out.size() < bytes; ++i) {
+        std::string n = std::to_string(i);
+        out += "def function_" + n + "(alpha, beta_value, count):\n";
+        out += "    total = alpha * 2.5 + beta_value - " + n + "\n";
+        out += "    for index in range(count):\n";
+        out += "        if index % 3 == 0 and not total > 1000000:\n";
+        out += "            total = total + index * 0.125\n";
+        out += "        else:\n";
+        out += "            items = [index, total, \"label\", None, True]\n";
+        out += "    return total\n";
+        out += "result_" + n + " = function_" + n + "(1, 2, 10)\n";
+    }
+    return out;
+}
+
+// Long comment lines between short statements.
+static std::string generateComments(size_t bytes) {
+    std::string out;
+    for (size_t i = 0; out.size() < bytes; ++i) {
+        out += "# Comment line " + std::to_string(i) +
+               ": explains what the following assignment does, in far more words than needed.\n";
+        out += "    # indented comments do not open a block, whatever their column\n";
+        out += "value = " + std::to_string(i) + "\n";
+    }
+    return out;
+}
+
+// Long string literals with an occasional escape.
+static std::string generateStrings(size_t bytes) {
+    std::string out;
+    for (size_t i = 0; out.size() < bytes; ++i) {
+        out += "message = \"Record " + std::to_string(i) +
+               " was processed successfully and written to the output table\"\n";
+        out += "path = 'C:\\\\data\\\\archive\\\\file_" + std::to_string(i) +
+               ".txt holds the \\'raw\\' export of this record'\n";
+    }
+    return out;
+}
+
+static bool sameToken(const Token& a, const Token& b) {
+    if (a.type != b.type || a.offset != b.offset || a.length != b.length) return false;
+    if (a.type == TokenType::Number) return std::memcmp(&a.number, &b.number, sizeof(a.number)) == 0;
+    if (a.type == TokenType::Identifier) return a.symbol == b.symbol;
+    return true;
+}
+
+struct Lexed {
+    std::vector<Token> tokens;
+    std::string error;
+};
+
+// Tokens up to the end of input or the first error. threads == 0 lexes on
+// demand.
+static Lexed tokenize(const std::string& source, unsigned threads = 0,
+                      size_t chunkBytes = Tokenizer::kParallelChunkBytes) {
+    Lexed lexed;
+    try {
+        Tokenizer tokenizer(source);
+        if (threads > 0) tokenizer.lexInParallel(threads, chunkBytes);
+        do {
+            lexed.tokens.push_back(tokenizer.nextToken());
+        } while (lexed.tokens.back().type != TokenType::EndOfInput);
+    } catch (const std::runtime_error& e) {
+        lexed.error = e.what();
+    }
+    return lexed;
+}
+
+static bool sameResult(const Lexed& a, const Lexed& b) {
+    return a.error == b.error && a.tokens.size() == b.tokens.size() &&
+           std::equal(a.tokens.begin(), a.tokens.end(), b.tokens.begin(), sameToken);
+}
+
+// Best of three runs, in MB/s.
+static double measure(const std::string& source, unsigned threads = 0) {
+    double best = 0;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        Tokenizer tokenizer(source);
+        if (threads > 0) tokenizer.lexInParallel(threads);
+        while (tokenizer.nextToken().type != TokenType::EndOfInput) {
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::max(best, source.size() / 1e6 / elapsed.count());
+    }
+    return best;
+}
+
+// Random mix of the constructs that matter at chunk boundaries: indentation
+// (including inconsistent), blank and comment lines, string literals with
+// escapes, newlines and '#' inside, numbers, and the odd invalid character.
+static std::string generateRandom(std::mt19937& rng) {
+    static const char* const kIndents[] = {"", "", "    ", "        ", "  ", "\t", "            "};
+    static const char* const kPieces[] = {
+        "x", "total_1", "if", "else", "def", "while", "and", "not", "None", "True", "12", "3.25", ".5",
+        "1.2.3", "+", "-=", "**", "==", "(", ")", "[", "]", ":", ",", ".", " ", " ", "\t",
+        "\"plain\"", "'single'", "\"esc \\\" quote\"", "'tab\\t'", "\"two\nlines\"",
+        "'# not a comment'", "\"ends in backslash \\\\\"", "\"line\\\ncontinued\"",
+    };
+    std::uniform_int_distribution<size_t> indent(0, std::size(kIndents) - 1);
+    std::uniform_int_distribution<size_t> piece(0, std::size(kPieces) - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::string out;
+    size_t lines = 20 + rng() % 200;
+    for (size_t line = 0; line < lines; ++line) {
+        int kind = percent(rng);
+        if (kind < 8) {
+            out += "\n";
+            continue;
+        }
+        out += kIndents[indent(rng)];
+        if (kind < 16) {
+            out += "# comment with \"quote' and # inside\n";
+            continue;
+        }
+        size_t count = 1 + rng() % 8;
+        for (size_t i = 0; i < count; ++i) {
+            out += kPieces[piece(rng)];
+            out += ' ';
+        }
+        if (percent(rng) == 0) out += "$";
+        if (percent(rng) < 10) out += "# trailing";
+        out += percent(rng) < 5 ? "\r\n" : "\n";
+    }
+    if (percent(rng) < 10) out += "\"unterminated";
+    return out;
+}
+
+static int runCheck(int argc, char* argv[]) {
+    std::vector<std::pair<std::string, std::string>> sources;
+    for (int i = 2; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::cerr << "Could not open " << argv[i] << std::endl;
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        sources.emplace_back(argv[i], text.str());
+    }
+    std::mt19937 rng(2024);
+    for (int i = 0; i < 500; ++i) sources.emplace_back("random #" + std::to_string(i), generateRandom(rng));
+
+    int failures = 0;
+    for (const auto& [name, source] : sources) {
+        Lexed expected = tokenize(source);
+        for (unsigned threads : {1u, 3u}) {
+            for (size_t chunkBytes : {size_t(1), size_t(7), size_t(64), size_t(1000), Tokenizer::kParallelChunkBytes}) {
+                if (!sameResult(expected, tokenize(source, threads, chunkBytes))) {
+                    std::cerr << name << ": parallel lexing differs with " << threads << " threads, "
+                              << chunkBytes << "-byte chunks" << std::endl;
+                    ++failures;
+                }
+            }
+        }
+    }
+    std::cout << sources.size() << " inputs checked, " << failures << " mismatches" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--check") return runCheck(argc, argv);
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    size_t bytes = megabytes * 1000 * 1000;
+    struct Input {
+        const char* name;
+        std::string source;
+    };
+    std::vector<Input> inputs = {
+        {"code", generateCode(bytes)},
+        {"comments", generateComments(bytes)},
+        {"strings", generateStrings(bytes)},
+    };
+    std::vector<std::string> scanners;
+    for (const char* name : {"scalar", "sse2", "avx2"}) {
+        if (selectLexScanner(name)) scanners.push_back(name);
+    }
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string parallel = std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+
+    std::cout << "input       MB     tokens";
+    for (const std::string& scanner : scanners) std::cout << "  " << std::string(10 - scanner.size(), ' ') << scanner;
+    std::cout << "  " << std::string(10 - parallel.size(), ' ') << parallel << "   (MB/s)" << std::endl;
+    int status = 0;
+    for (const Input& input : inputs) {
+        selectLexScanner(scanners.front());
+        Lexed expected = tokenize(input.source);
+        std::cout.width(8);
+        std::cout << std::left << input.name << std::right;
+        std::cout.width(6);
+        std::cout << input.source.size() / 1000000;
+        std::cout.width(11);
+        std::cout << expected.tokens.size();
+        for (const std::string& scanner : scanners) {
+            selectLexScanner(scanner);
+            if (!sameResult(expected, tokenize(input.source))) {
+                std::cerr << "\n" << scanner << " scanner produced different tokens for " << input.name << std::endl;
+                status = 1;
+            }
+            double rate = measure(input.source);
+            std::cout.width(12);
+            std::cout << static_cast<int>(rate);
+        }
+        // Parallel lexing with the default scanner
+        selectLexScanner(scanners.back());
+        if (!sameResult(expected, tokenize(input.source, threads))) {
+            std::cerr << "\nparallel lexing produced different tokens for " << input.name << std::endl;
+            status = 1;
+        }
+        std::cout.width(12);
+        std::cout << static_cast<int>(measure(input.source, threads));
+        std::cout << std::endl;
+    }
+    return status;
+}
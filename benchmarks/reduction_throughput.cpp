@@ -0,0 +1,156 @@
+// Throughput of the list reductions in millions of elements per second,
+// once per kernel set the CPU supports, on arrays that fit in L1, in L2 and
+// only in memory. Each set is checked against the scalar one first: min
+// and max must agree exactly, sum and dot up to rounding, and a NaN must
+// make min and max NaN. Then the matrix product in GFLOP/s, on square and
+// odd shapes, which every set must compute to the same bits as a plain
+// triple loop.
+//
+// Usage: reduction_throughput [repeat-scale]
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/NumericKernels.h"
+
+enum class Op { Sum, Min, Max, Dot };
+
+static double run(Op op, const std::vector<double>& a, const std::vector<double>& b) {
+    const NumericKernels& kernels = numericKernels();
+    switch (op) {
+    case Op::Sum: return kernels.sum(a.data(), a.size());
+    case Op::Min: return kernels.min(a.data(), a.size());
+    case Op::Max: return kernels.max(a.data(), a.size());
+    case Op::Dot: return kernels.dot(a.data(), b.data(), a.size());
+    }
+    return 0;
+}
+
+static bool agrees(Op op, double expected, double actual) {
+    if (op == Op::Min || op == Op::Max) return expected == actual || (std::isnan(expected) && std::isnan(actual));
+    return std::fabs(expected - actual) <= 1e-9 * std::fabs(expected) + 1e-12;
+}
+
+static double measure(Op op, const std::vector<double>& a, const std::vector<double>& b, size_t repeats) {
+    volatile double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repeats; ++i) sink = sink + run(op, a, b);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(a.size()) * repeats / elapsed.count() / 1e6;
+}
+
+// c = a * b for row-major n x m and m x p, one element at a time
+static std::vector<double> naiveMatmul(const std::vector<double>& a, const std::vector<double>& b, size_t n, size_t m,
+                                       size_t p) {
+    std::vector<double> c(n * p);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < p; ++j) {
+            double total = 0;
+            for (size_t k = 0; k < m; ++k) total += a[i * m + k] * b[k * p + j];
+            c[i * p + j] = total;
+        }
+    }
+    return c;
+}
+
+static int matmulBenchmark(const std::vector<std::string>& kernels, double scale, std::mt19937_64& random) {
+    struct Shape {
+        size_t n, m, p;
+    };
+    const Shape shapes[] = {{37, 53, 41}, {64, 64, 64}, {256, 256, 256}, {300, 517, 263}, {512, 512, 512}};
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    int status = 0;
+
+    std::cout << "\nmatmul      ";
+    for (const std::string& kernel : kernels) std::cout << std::string(12 - kernel.size(), ' ') << kernel;
+    std::cout << "   (GFLOP/s)" << std::endl;
+    for (const Shape& shape : shapes) {
+        std::vector<double> a(shape.n * shape.m), b(shape.m * shape.p);
+        for (double& x : a) x = uniform(random);
+        for (double& x : b) x = uniform(random);
+        std::vector<double> expected = naiveMatmul(a, b, shape.n, shape.m, shape.p);
+        double flops = 2.0 * shape.n * shape.m * shape.p;
+        size_t repeats = static_cast<size_t>(scale * 2e9 / flops) + 1;
+        std::string name = std::to_string(shape.n) + "x" + std::to_string(shape.m) + "x" + std::to_string(shape.p);
+        std::cout << std::left << std::setw(12) << name << std::right;
+        for (const std::string& kernel : kernels) {
+            selectNumericKernels(kernel);
+            std::vector<double> c(shape.n * shape.p);
+            numericKernels().matmul(a.data(), b.data(), c.data(), shape.n, shape.m, shape.p);
+            if (c != expected) {
+                std::cerr << "\n" << kernel << " matmul differs from the triple loop on " << name << std::endl;
+                status = 1;
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < repeats; ++i) {
+                numericKernels().matmul(a.data(), b.data(), c.data(), shape.n, shape.m, shape.p);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << std::setw(12) << std::fixed << std::setprecision(1) << flops * repeats / elapsed.count() / 1e9;
+        }
+        std::cout << std::endl;
+    }
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    double scale = argc > 1 ? std::strtod(argv[1], nullptr) : 1.0;
+    std::vector<std::string> kernels;
+    for (const char* name : {"scalar", "sse2", "avx2"}) {
+        if (selectNumericKernels(name)) kernels.push_back(name);
+    }
+    struct Size {
+        const char* name;
+        size_t count;
+    };
+    const Size sizes[] = {{"1K", 1000}, {"32K", 32000}, {"8M", 8000000}};
+    const std::pair<const char*, Op> ops[] = {{"sum", Op::Sum}, {"min", Op::Min}, {"max", Op::Max}, {"dot", Op::Dot}};
+
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> uniform(-1000.0, 1000.0);
+    int status = 0;
+
+    std::cout << "op    size";
+    for (const std::string& kernel : kernels) std::cout << std::string(12 - kernel.size(), ' ') << kernel;
+    std::cout << "   (M elements/s)" << std::endl;
+    for (const Size& size : sizes) {
+        // Odd lengths as well, so the checks cover the scalar tails
+        std::vector<double> a(size.count + 3), b(size.count + 3);
+        for (double& x : a) x = uniform(random);
+        for (double& x : b) x = uniform(random);
+        size_t repeats = static_cast<size_t>(scale * 2e8 / size.count) + 1;
+        for (const auto& [name, op] : ops) {
+            selectNumericKernels("scalar");
+            double expected = run(op, a, b);
+            std::cout << name << std::string(8 - std::string(size.name).size(), ' ') << size.name;
+            for (const std::string& kernel : kernels) {
+                selectNumericKernels(kernel);
+                if (!agrees(op, expected, run(op, a, b))) {
+                    std::cerr << "\n" << kernel << " " << name << " differs from scalar on " << size.name << std::endl;
+                    status = 1;
+                }
+                std::cout.width(12);
+                std::cout << static_cast<long>(measure(op, a, b, repeats));
+            }
+            std::cout << std::endl;
+        }
+        // A NaN anywhere makes min and max NaN
+        for (size_t at : {size_t(0), size.count / 2, a.size() - 1}) {
+            std::vector<double> withNaN = a;
+            withNaN[at] = std::nan("");
+            for (const std::string& kernel : kernels) {
+                selectNumericKernels(kernel);
+                if (!std::isnan(run(Op::Min, withNaN, b)) || !std::isnan(run(Op::Max, withNaN, b))) {
+                    std::cerr << kernel << " min or max missed a NaN at " << at << std::endl;
+                    status = 1;
+                }
+            }
+        }
+    }
+    if (matmulBenchmark(kernels, scale, random) != 0) status = 1;
+    return status;
+}
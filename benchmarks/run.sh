@@ -0,0 +1,22 @@
+#!/bin/sh
+# Runs every benchmark script with each engine and reports the
+# interpretation time printed by --timing.
+#
+# Usage: benchmarks/run.sh <path-to-interpreter> [engine...]
+set -e
+bin=${1:?usage: $0 <path-to-interpreter> [engine...]}
+shift
+engines=${*:-"tree vm closure"}
+dir=$(dirname "$0")
+
+printf "%-28s" "script"
+for engine in $engines; do printf "%12s" "$engine"; done
+printf "\n"
+for script in "$dir"/*.grm "$dir"/../examples/nested_loops.grm; do
+    printf "%-28s" "$(basename "$script")"
+    for engine in $engines; do
+        ms=$("$bin" "$script" --timing --engine="$engine" | sed -n 's/^\[Interpretation time\]: \([0-9]*\) ms$/\1/p')
+        printf "%9s ms" "$ms"
+    done
+    printf "\n"
+done
@@ -1,152 +1,176 @@
 #ifndef AST_H
 #define AST_H
 
-#include <string>
+#include <cstdint>
 #include <vector>
-#include <memory>
+#include "core/Symbol.h"
+#include "core/Token.h"
 
-// Forward declarations
-struct Expr;
-struct Stmt;
+// The AST is flat: every expression and statement of a program lives in one
+// of two contiguous arrays owned by an Ast, and nodes refer to each other by
+// 32-bit index. Variable-length children (block statements, call arguments,
+// list elements) are runs in a shared index array. Names and string literals
+// are Symbols. Passes dispatch on each node's kind tag instead of its dynamic
+// type.
 
-// --- Expression nodes ---
-struct Expr {
-    virtual ~Expr() = default;
-};
-
-struct NumberExpr : Expr {
-    double value;
-    NumberExpr(double v) : value(v) {}
-};
-
-struct StringExpr : Expr {
-    std::string value;
-    StringExpr(const std::string& v) : value(v) {}
-};
-
-struct VariableExpr : Expr {
-    std::string name;
-    VariableExpr(const std::string& n) : name(n) {}
-};
+using NodeIndex = uint32_t;
+constexpr NodeIndex kNoNode = UINT32_MAX;
 
-struct BinaryExpr : Expr {
-    std::unique_ptr<Expr> left;
-    std::unique_ptr<Expr> right;
-    std::string op;
-    BinaryExpr(std::unique_ptr<Expr> l, std::string o, std::unique_ptr<Expr> r)
-        : left(std::move(l)), op(std::move(o)), right(std::move(r)) {}
-};
+// A run of consecutive entries in Ast::statementLists or
+// Ast::expressionLists.
+struct NodeList {
+    uint32_t start = 0;
+    uint32_t count = 0;
 
-struct UnaryExpr : Expr {
-    std::string op;
-    std::unique_ptr<Expr> operand;
-    UnaryExpr(std::string o, std::unique_ptr<Expr> e)
-        : op(std::move(o)), operand(std::move(e)) {}
+    bool empty() const { return count == 0; }
 };
 
-struct AssignExpr : Expr {
-    std::string name;
-    std::unique_ptr<Expr> value;
-    AssignExpr(const std::string& n, std::unique_ptr<Expr> v)
-        : name(n), value(std::move(v)) {}
-};
+// Storage location of a name, filled in by Resolver. Locals live in slots of
+// a function frame: depth counts frames outward from the current function
+// (0 = its own frame). Globals are looked up by name in the global scope.
+struct Binding {
+    static constexpr int Global = -1;
+    int depth = Global;
+    int slot = -1;
 
-struct ListExpr : Expr {
-    std::vector<std::unique_ptr<Expr>> elements;
-    ListExpr(std::vector<std::unique_ptr<Expr>> elems)
-        : elements(std::move(elems)) {}
+    bool is_global() const { return depth == Global; }
 };
 
-struct IndexExpr : Expr {
-    std::unique_ptr<Expr> collection;
-    std::unique_ptr<Expr> index;
-    IndexExpr(std::unique_ptr<Expr> coll, std::unique_ptr<Expr> idx)
-        : collection(std::move(coll)), index(std::move(idx)) {}
-};
-
-struct CallExpr : Expr {
-    std::unique_ptr<Expr> callee;
-    std::vector<std::unique_ptr<Expr>> arguments;
-    CallExpr(std::unique_ptr<Expr> c, std::vector<std::unique_ptr<Expr>> args)
-        : callee(std::move(c)), arguments(std::move(args)) {}
-};
+struct JitFunction;
+struct JitLoop;
+class TraceLoop;
 
-struct MemberAccessExpr : Expr {
-    std::unique_ptr<Expr> object;
-    std::string member;
-    MemberAccessExpr(std::unique_ptr<Expr> obj, const std::string& mem)
-        : object(std::move(obj)), member(mem) {}
+// --- Expression nodes ---
+enum class ExprKind : uint8_t {
+    Number,
+    String,
+    Variable,
+    Binary,
+    Unary,
+    Assign,
+    List,
+    Index,
+    Call,
+    MemberAccess,
+};
+
+// Fields used by each kind:
+//   Number        number
+//   String        name (the literal's text)
+//   Variable      name, binding
+//   Binary        op, left, right
+//   Unary         op, left (operand)
+//   Assign        name, binding, left (value)
+//   List          items (elements)
+//   Index         left (collection), right (index)
+//   Call          left (callee), items (arguments)
+//   MemberAccess  left (object), name (member)
+struct Expr {
+    ExprKind kind;
+    TokenType op = TokenType::EndOfInput;
+    Symbol name;
+    NodeIndex left = kNoNode;
+    NodeIndex right = kNoNode;
+    NodeList items;
+    Binding binding;
+    double number = 0;
 };
 
 // --- Statement nodes ---
+enum class StmtKind : uint8_t {
+    Expression,
+    Assign,
+    If,
+    While,
+    For,
+    Block,
+    Break,
+    Continue,
+    FunctionDef,
+    Return,
+};
+
+// Fields used by each kind:
+//   Expression   expr
+//   Assign       name, binding, expr (value)
+//   If           expr (condition), body (then branch), orelse (else branch)
+//   While        expr (condition), body
+//   For          name (loop variable), binding, expr (iterable), body
+//   Block        body
+//   FunctionDef  name, binding, function (index into Ast::functions)
+//   Return       expr, or kNoNode for a bare return; tailCall if expr is a
+//                call whose result the function returns as is (Resolver)
+// A top-level While or For may also have jit: its native code, set by Jit
+// under --jit. Under --trace-jit, a While or For may have trace: its hot
+// loop state, set by Tracer. Neither is part of the AST cache.
 struct Stmt {
-    virtual ~Stmt() = default;
-};
-
-struct ExpressionStmt : Stmt {
-    std::unique_ptr<Expr> expr;
-    ExpressionStmt(std::unique_ptr<Expr> e) : expr(std::move(e)) {}
-};
-
-struct AssignStmt : Stmt {
-    std::string name;
-    std::unique_ptr<Expr> value;
-    AssignStmt(const std::string& n, std::unique_ptr<Expr> v)
-        : name(n), value(std::move(v)) {}
-};
-
-struct IfStmt : Stmt {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Stmt>> thenBranch;
-    std::vector<std::unique_ptr<Stmt>> elseBranch;
-    IfStmt(std::unique_ptr<Expr> cond,
-           std::vector<std::unique_ptr<Stmt>> thenB,
-           std::vector<std::unique_ptr<Stmt>> elseB)
-        : condition(std::move(cond)),
-          thenBranch(std::move(thenB)),
-          elseBranch(std::move(elseB)) {}
-};
-
-struct WhileStmt : Stmt {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Stmt>> body;
-    WhileStmt(std::unique_ptr<Expr> cond, std::vector<std::unique_ptr<Stmt>> b)
-        : condition(std::move(cond)), body(std::move(b)) {}
-};
-
-struct ForStmt : Stmt {
-    std::string var;
-    std::unique_ptr<Expr> iterable;
-    std::vector<std::unique_ptr<Stmt>> body;
-    ForStmt(const std::string& v, std::unique_ptr<Expr> iter, std::vector<std::unique_ptr<Stmt>> b)
-        : var(v), iterable(std::move(iter)), body(std::move(b)) {}
-};
-
-struct BlockStmt : Stmt {
-    std::vector<std::unique_ptr<Stmt>> statements;
-    BlockStmt(std::vector<std::unique_ptr<Stmt>> stmts)
-        : statements(std::move(stmts)) {}
-};
-
-struct BreakStmt : Stmt {
-    BreakStmt() = default;
-};
-
-struct ContinueStmt : Stmt {
-    ContinueStmt() = default;
-};
-
-struct FunctionDefStmt : Stmt {
-    std::string name;
-    std::vector<std::string> parameters;
-    std::vector<std::unique_ptr<Stmt>> body;
-    FunctionDefStmt(const std::string& n, std::vector<std::string> params, std::vector<std::unique_ptr<Stmt>> b)
-        : name(n), parameters(std::move(params)), body(std::move(b)) {}
-};
-
-struct ReturnStmt : Stmt {
-    std::unique_ptr<Expr> value;
-    ReturnStmt(std::unique_ptr<Expr> v) : value(std::move(v)) {}
+    StmtKind kind;
+    bool tailCall = false;
+    Symbol name;
+    Binding binding;
+    NodeIndex expr = kNoNode;
+    NodeList body;
+    NodeList orelse;
+    uint32_t function = 0;
+    const JitLoop* jit = nullptr;
+    TraceLoop* trace = nullptr;
+};
+
+// Everything about a function definition that outlives executing it.
+// Function objects point here, so Ast::functions must not grow once the
+// program runs.
+struct FunctionDecl {
+    Symbol name;
+    std::vector<Symbol> parameters;
+    std::vector<Symbol> locals;  // slot names, parameters first (Resolver)
+    NodeList body;
+    bool hasNestedFunctions = false;  // its frame can be captured (Resolver)
+    // Size of the result cache its function objects get, 0 for none. Set
+    // by PurityAnalyzer under --auto-memo; not part of the AST cache.
+    uint32_t memoCapacity = 0;
+    // Native code, set by Jit under --jit; not part of the AST cache.
+    const JitFunction* jit = nullptr;
+};
+
+// Read-only view of a NodeList. Invalidated when the list array grows.
+class NodeSpan {
+public:
+    NodeSpan(const NodeIndex* first, uint32_t count) : m_first(first), m_count(count) {}
+    const NodeIndex* begin() const { return m_first; }
+    const NodeIndex* end() const { return m_first + m_count; }
+    uint32_t size() const { return m_count; }
+    NodeIndex operator[](uint32_t i) const { return m_first[i]; }
+
+private:
+    const NodeIndex* m_first;
+    uint32_t m_count;
+};
+
+class Ast {
+public:
+    std::vector<Expr> expressions;
+    std::vector<Stmt> statements;
+    std::vector<NodeIndex> expressionLists;
+    std::vector<NodeIndex> statementLists;
+    std::vector<FunctionDecl> functions;
+    NodeList program;  // top-level statements
+
+    Expr& expr(NodeIndex index) { return expressions[index]; }
+    const Expr& expr(NodeIndex index) const { return expressions[index]; }
+    Stmt& stmt(NodeIndex index) { return statements[index]; }
+    const Stmt& stmt(NodeIndex index) const { return statements[index]; }
+
+    NodeIndex addExpr(const Expr& expr);
+    NodeIndex addStmt(const Stmt& stmt);
+    NodeList addExpressionList(const std::vector<NodeIndex>& items);
+    NodeList addStatementList(const std::vector<NodeIndex>& items);
+
+    NodeSpan expressionList(NodeList list) const {
+        return NodeSpan(expressionLists.data() + list.start, list.count);
+    }
+    NodeSpan statementList(NodeList list) const {
+        return NodeSpan(statementLists.data() + list.start, list.count);
+    }
 };
 
 #endif // AST_H
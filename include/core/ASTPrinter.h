@@ -0,0 +1,11 @@
+#ifndef AST_PRINTER_H
+#define AST_PRINTER_H
+
+#include <ostream>
+#include "core/AST.h"
+
+// Writes the AST as an indented tree, one node per line, including the
+// variable bindings assigned by Resolver. Used by --dump-ast.
+void printAst(const Ast& ast, std::ostream& out);
+
+#endif // AST_PRINTER_H
@@ -0,0 +1,40 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "core/AST.h"
+
+// On-disk copy of a script's optimized and resolved AST, so that later runs
+// of an unchanged script skip tokenizing, parsing, optimizing and resolving.
+//
+// The cache file is keyed by a hash of the source text, the interpreter
+// version, the file format version and the optimization level; any mismatch
+// is a miss. By default it lives next to the script, in
+// __grmcache__/<name>.o<level>.grmc; with a cache directory, every script
+// gets a file there named after its path. Loading maps the file and copies
+// its node arrays straight into an Ast; names are stored once and interned
+// on load.
+class AstCache {
+public:
+    // cacheDir empty: next to the script.
+    AstCache(const std::string& scriptPath, std::string_view source, int optLevel,
+             const std::string& cacheDir = "");
+
+    const std::string& path() const { return m_path; }
+
+    // Fills ast and returns true if the cache file matches this source.
+    bool load(Ast& ast) const;
+    // Writes the cache file. Returns false if it could not be written, which
+    // only means the next run parses again.
+    bool store(const Ast& ast) const;
+
+private:
+    std::string m_path;
+    uint64_t m_sourceHash;
+    uint64_t m_sourceSize;
+    int m_optLevel;
+};
+
+#endif // AST_CACHE_H
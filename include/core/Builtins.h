@@ -0,0 +1,16 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <string>
+#include "core/Environment.h"
+
+// Installs print(), range(), len(), memo(), list(), the reductions sum(),
+// min(), max(), mean() and dot(), and the array builtins array(), zeros(),
+// transpose() and matmul() into the given (global) environment.
+void registerBuiltins(Environment& env);
+
+// True for builtins whose result depends only on their arguments and that
+// have no side effects.
+bool isPureBuiltin(const std::string& name);
+
+#endif // BUILTINS_H
@@ -0,0 +1,155 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/AST.h"
+#include "core/InlineCache.h"
+#include "objects/Value.h"
+
+// Instruction set of the stack VM. Every instruction is a one-byte opcode,
+// optionally followed by a single 32-bit little-endian operand (see
+// opcodeHasOperand).
+enum class OpCode : uint8_t {
+    Constant,       // [index]  push constants[index]
+    LoadGlobal,     // [name]   push global names[name], through globalCaches[name]
+    StoreGlobal,    // [name]   pop and define global names[name], through globalStores[name]
+    LoadLocal,      // [slot]   push a slot of the current frame
+    StoreLocal,     // [slot]   pop into a slot of the current frame
+    LoadEnclosing,  // [depth << 24 | slot] push a slot of an enclosing frame
+    UpdateName,     // [name]   assign top of stack to an existing binding
+    Pop,
+
+    // Binary operators: pop right, pop left, push result
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Modulo,
+    Power,
+    Equal,
+    NotEqual,
+    Less,
+    Greater,
+    LessEqual,
+    GreaterEqual,
+    And,
+    Or,
+
+    // Unary operators: pop operand, push result
+    Negate,
+    Not,
+
+    Jump,           // [target] unconditional jump
+    JumpIfFalse,    // [target] pop condition, jump if falsy
+    GetIter,        // pop iterable, push iterable and its iterator (a range: next value and the range)
+    ForIter,        // [target] push next item, or pop iterator pair and jump
+    BuildList,      // [count]  pop count items, push list
+    Index,          // pop index, pop collection, push item
+    IndexRow,       // first half of a[i][j]: pop i; a 2-D array stays with its resolved row
+                    // index pushed, anything else is replaced by a[i] with undefined pushed
+    IndexElement,   // pop j, pop the pair IndexRow left, push a[i][j]
+    Member,         // [name]   pop object, push member
+    Call,           // [site]   pop callSites[site].argc arguments and the callee, push result
+    TailCall,       // [site]   like Call, but a user function replaces the current frame;
+                    //          always followed by Return, which a builtin's result takes
+    MakeFunction,   // [proto]  push a function closing over the current scope
+    NativeLoop,     // [site]   run nativeLoops[site] and jump past the loop that follows,
+                    //          or fall into it if the native code declines
+    TraceLoop,      // [site]   loop head under --trace-jit: count the pass, run traceLoops[site]
+                    //          when hot and jump past the loop if that finished it
+    Return,         // pop result and leave the current frame
+    Halt,
+};
+
+inline bool opcodeHasOperand(OpCode op) {
+    switch (op) {
+        case OpCode::Constant:
+        case OpCode::LoadGlobal:
+        case OpCode::StoreGlobal:
+        case OpCode::LoadLocal:
+        case OpCode::StoreLocal:
+        case OpCode::LoadEnclosing:
+        case OpCode::UpdateName:
+        case OpCode::Jump:
+        case OpCode::JumpIfFalse:
+        case OpCode::ForIter:
+        case OpCode::BuildList:
+        case OpCode::Member:
+        case OpCode::Call:
+        case OpCode::TailCall:
+        case OpCode::MakeFunction:
+        case OpCode::NativeLoop:
+        case OpCode::TraceLoop:
+            return true;
+        default:
+            return false;
+    }
+}
+
+struct CallSite {
+    uint32_t argc;
+    CallCache cache;
+};
+
+// A top-level loop compiled by Jit, and the offset just past its bytecode.
+struct NativeLoopSite {
+    const JitLoop* loop;
+    uint32_t exit;
+};
+
+// A loop traced by Tracer, and the offset just past its bytecode. A for
+// loop has its iterator pair on the stack while it runs.
+struct TraceLoopSite {
+    TraceLoop* loop;
+    uint32_t exit;
+    bool isFor;
+};
+
+struct Chunk {
+    std::vector<uint8_t> code;
+    std::vector<Value> constants;
+    std::vector<Symbol> names;
+    std::vector<NativeLoopSite> nativeLoops;
+    std::vector<TraceLoopSite> traceLoops;
+    // Inline caches, filled in while the program runs. Global reads and
+    // stores have one per name: every read (store) of a name in the chunk
+    // shares it.
+    mutable std::vector<CallSite> callSites;
+    mutable std::vector<GlobalReadCache> globalCaches;
+    mutable std::vector<GlobalNumberStore> globalStores;
+
+    void emit(OpCode op) { code.push_back(static_cast<uint8_t>(op)); }
+
+    // Emits an instruction with an operand and returns the operand offset,
+    // so that forward jumps can be patched later.
+    size_t emit(OpCode op, uint32_t operand) {
+        emit(op);
+        size_t at = code.size();
+        code.resize(at + sizeof(uint32_t));
+        patch(at, operand);
+        return at;
+    }
+
+    void patch(size_t at, uint32_t operand) {
+        std::memcpy(&code[at], &operand, sizeof(uint32_t));
+    }
+};
+
+// Compiled form of a function definition.
+struct FunctionProto {
+    Symbol name;
+    std::vector<Symbol> parameters;
+    const FunctionDecl* definition;  // AST outlives the compiled program
+    Chunk chunk;
+};
+
+struct Program {
+    Chunk main;
+    std::vector<std::unique_ptr<FunctionProto>> functions;
+};
+
+#endif // BYTECODE_H
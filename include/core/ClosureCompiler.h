@@ -0,0 +1,68 @@
+#ifndef CLOSURE_COMPILER_H
+#define CLOSURE_COMPILER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/AST.h"
+#include "core/Completion.h"
+#include "core/Environment.h"
+#include "core/FrameStack.h"
+#include "objects/Value.h"
+
+class FunctionObject;
+
+// Executable form of a user function body, referenced from FunctionObject.
+struct CompiledFunction {
+    std::function<Completion()> body;
+};
+
+// Execution engine that converts every Expr/Stmt once into a tree of
+// pre-bound C++ callables. Node kinds and operators are decided while
+// building the tree, so running it needs no per-node dispatch. The Ast
+// must outlive the functions created by the program.
+class ClosureCompiler {
+public:
+    using ExprFn = std::function<Value()>;
+    using StmtFn = std::function<Completion()>;
+
+    ClosureCompiler();
+    StmtFn compile(const Ast& ast);
+    void run(const StmtFn& program);
+
+private:
+    const Ast* m_ast = nullptr;
+    std::shared_ptr<Environment> m_global_env;
+    std::shared_ptr<Environment> m_current_env;
+    Value m_return_value; // set by a statement completing with Return
+    // Call left by a return in tail position; callFunction makes it in
+    // place of the call that returned
+    Value m_tail_callee;
+    FunctionObject* m_tail_function = nullptr;
+    std::vector<Value> m_tail_arguments;
+    FrameStack m_frames;
+    std::vector<std::unique_ptr<CompiledFunction>> m_functions;
+
+    StmtFn compileBlock(NodeList statements);
+    StmtFn compileStmt(NodeIndex index);
+    StmtFn compileIf(const Stmt& stmt);
+    StmtFn compileLoop(const Stmt& stmt, StmtFn loop);
+    StmtFn compileWhile(const Stmt& stmt);
+    StmtFn compileFor(const Stmt& stmt);
+    StmtFn compileFunctionDef(const Stmt& stmt);
+    StmtFn compileReturn(const Stmt& stmt);
+    StmtFn compileTailCall(const Expr& call);
+    StmtFn compileDefine(Symbol name, const Binding& binding, ExprFn value);
+
+    ExprFn compileExpr(NodeIndex index);
+    ExprFn compileBinary(const Expr& expr);
+    ExprFn compileUnary(const Expr& expr);
+    ExprFn compileVariable(const Expr& expr);
+    ExprFn compileAssign(const Expr& expr);
+    ExprFn compileCall(const Expr& expr);
+
+    Value callFunction(FunctionObject* func, const std::vector<Value>& arguments);
+};
+
+#endif // CLOSURE_COMPILER_H
@@ -0,0 +1,71 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/AST.h"
+#include "core/Bytecode.h"
+
+// Lowers the AST produced by Parser into bytecode for the VM.
+class Compiler {
+public:
+    std::unique_ptr<Program> compile(const Ast& ast);
+
+private:
+    struct LoopContext {
+        bool isFor;                     // for-loops keep an iterator pair on the stack
+        size_t continueTarget;
+        std::vector<size_t> breakJumps; // operands to patch with the loop exit
+    };
+
+    const Ast* m_ast = nullptr;
+    Program* m_program = nullptr;
+    Chunk* m_chunk = nullptr;
+    bool m_inFunction = false;
+    std::vector<LoopContext> m_loops;
+    std::unordered_map<uint64_t, uint32_t> m_numberConstants;  // keyed by bit pattern, so -0 != 0
+    std::unordered_map<Symbol, uint32_t> m_stringConstants;
+    std::unordered_map<Symbol, uint32_t> m_nameIndices;
+
+    void compileBlock(NodeList statements);
+    void compileStmt(NodeIndex index);
+    void compileIf(const Stmt& stmt);
+    void compileLoop(const Stmt& stmt);
+    void compileWhile(const Stmt& stmt);
+    void compileFor(const Stmt& stmt);
+    static constexpr size_t kNoTrace = SIZE_MAX;
+    size_t emitTraceLoop(const Stmt& stmt, bool isFor);
+    void compileFunctionDef(const Stmt& stmt);
+    void compileReturn(const Stmt& stmt);
+    void compileBreak();
+    void compileContinue();
+    void compileExpr(NodeIndex index);
+    void compileBinary(const Expr& expr);
+    void compileUnary(const Expr& expr);
+    void compileCall(const Expr& expr, OpCode op);
+    void compileLoad(Symbol name, const Binding& binding);
+    void compileStore(Symbol name, const Binding& binding);
+
+    uint32_t numberConstant(double value);
+    uint32_t stringConstant(Symbol value);
+    uint32_t nameIndex(Symbol name);
+    uint32_t currentOffset() const;
+    void patchJump(size_t operand);
+
+    // Switches code generation to a fresh chunk; constant and name
+    // deduplication tables are per chunk.
+    struct ChunkState {
+        Chunk* chunk;
+        bool inFunction;
+        std::vector<LoopContext> loops;
+        std::unordered_map<uint64_t, uint32_t> numberConstants;
+        std::unordered_map<Symbol, uint32_t> stringConstants;
+        std::unordered_map<Symbol, uint32_t> nameIndices;
+    };
+    ChunkState enterChunk(Chunk* chunk, bool inFunction);
+    void leaveChunk(ChunkState& saved);
+};
+
+#endif // COMPILER_H
@@ -0,0 +1,30 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <cstdint>
+#include <stdexcept>
+
+// How a statement finished. Loops consume Break/Continue and calls consume
+// Return; every other statement hands a non-Normal completion straight to
+// its caller. The value of a Return is kept by the engine executing it.
+enum class Completion : uint8_t {
+    Normal,
+    Break,
+    Continue,
+    Return,
+};
+
+// Reports a Break/Continue/Return that reached a function body or the top
+// level, using the same messages as the bytecode compiler.
+inline void checkEscapedCompletion(Completion completion, bool inFunction) {
+    switch (completion) {
+    case Completion::Break: throw std::runtime_error("'break' outside loop");
+    case Completion::Continue: throw std::runtime_error("'continue' outside loop");
+    case Completion::Return:
+        if (!inFunction) throw std::runtime_error("'return' outside function");
+        break;
+    case Completion::Normal: break;
+    }
+}
+
+#endif // COMPLETION_H
@@ -2,23 +2,73 @@
 #define ENVIRONMENT_H
 
 #include <unordered_map>
-#include <string>
 #include <memory>
-#include "objects/Object.h"
+#include <vector>
+#include "core/Symbol.h"
+#include "objects/Value.h"
 
+// A scope. The global scope keys values by name; function frames store their
+// locals in a flat slot array laid out by Resolver. Name-based access works
+// on both and is used for globals, for locals read before their first
+// assignment, and for error messages. Names are Symbols, so lookups reuse
+// the hash computed at interning and compare by address.
 class Environment {
 private:
-    std::unordered_map<std::string, ObjectPtr> values;
+    std::unordered_map<Symbol, Value> values;
+    std::vector<Value> slots;
+    const std::vector<Symbol>* slotNames = nullptr;
     std::shared_ptr<Environment> parent;
+    // Bumped whenever a name in `values` is bound for the first time or
+    // rebound to another object. Storing a number over a number keeps it.
+    uint64_t bindingVersion = 1;
+
+    Value* findSlot(Symbol name);
+    void store(Value& target, Value value);
 
 public:
     Environment();
     Environment(std::shared_ptr<Environment> parent);
+    Environment(std::shared_ptr<Environment> parent, const std::vector<Symbol>& slotNames);
+
+    void set(Symbol name, Value value);
+    const Value& get(Symbol name);
+    void update(Symbol name, Value value);
+    bool has(Symbol name);
+    // Turns this frame into a fresh one for a call of a function with the
+    // given closure and slot layout, keeping its storage. Used by FrameStack
+    // and by tail calls, once nothing else refers to the frame.
+    void recycle(const std::shared_ptr<Environment>& closure, const std::vector<Symbol>& names) {
+        slots.assign(names.size(), Value::undefined());
+        slotNames = &names;
+        if (!values.empty()) values.clear();
+        parent = closure;
+    }
+    // Drops every value and the parent, keeping the slot storage for reuse.
+    void release() {
+        slots.clear();
+        slotNames = nullptr;
+        if (!values.empty()) values.clear();
+        parent.reset();
+    }
+    // The entry for name among the values keyed by name, or nullptr. Its
+    // address is kept until the scope is recycled or released.
+    Value* entry(Symbol name) {
+        auto it = values.find(name);
+        return it != values.end() ? &it->second : nullptr;
+    }
+    // Inline caches stay valid while this is unchanged; see GlobalReadCache.
+    uint64_t version() const { return bindingVersion; }
+
+    Value& slot(int index) { return slots[index]; }
+    Symbol slotName(int index) const { return (*slotNames)[index]; }
+    const std::shared_ptr<Environment>& enclosing() const { return parent; }
 
-    void set(const std::string& name, ObjectPtr value);
-    ObjectPtr get(const std::string& name);
-    void update(const std::string& name, ObjectPtr value);
-    bool has(const std::string& name);
+    // Walks depth scopes outward.
+    Environment* ancestor(int depth) {
+        Environment* env = this;
+        while (depth-- > 0) env = env->parent.get();
+        return env;
+    }
 };
 
 #endif // ENVIRONMENT_H
@@ -0,0 +1,30 @@
+#ifndef EXECUTABLE_MEMORY_H
+#define EXECUTABLE_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pages holding generated machine code. They are written while only
+// writable and then made executable, so they are never both.
+class ExecutableMemory {
+public:
+    ExecutableMemory() = default;
+    ~ExecutableMemory() { release(); }
+    ExecutableMemory(const ExecutableMemory&) = delete;
+    ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+    // Copies code into fresh pages, replacing any held before. Returns
+    // false, holding nothing, if the system refuses.
+    bool assign(const std::vector<uint8_t>& code);
+    void release();
+
+    uint8_t* data() const { return static_cast<uint8_t*>(m_pages); }
+    size_t size() const { return m_size; }
+
+private:
+    void* m_pages = nullptr;
+    size_t m_size = 0;
+};
+
+#endif // EXECUTABLE_MEMORY_H
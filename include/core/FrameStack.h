@@ -0,0 +1,51 @@
+#ifndef FRAME_STACK_H
+#define FRAME_STACK_H
+
+#include <memory>
+#include <vector>
+#include "core/Environment.h"
+#include "objects/FunctionObject.h"
+#include "objects/ObjectPool.h"
+
+// Activation records for user function calls. Only a nested function
+// definition can capture a frame (Resolver flags those functions), so every
+// other call gets its frame from a stack of reusable environments: their
+// slot arrays keep their capacity, and the frame is handed out as a
+// non-owning shared_ptr whose copies cost no reference counting. Frames of
+// functions that define functions come from the object pool as before.
+class FrameStack {
+public:
+    // Points `frame` at a fresh frame for a call of func: chained to its
+    // closure, every slot unassigned. `onStack` tells whether `frame` is a
+    // stack frame and is updated for the new one. When a tail call replaces
+    // the frame `frame` refers to, that frame is released first, or
+    // recycled if it is a pooled frame that nothing else holds.
+    void enter(const FunctionObject& func, std::shared_ptr<Environment>& frame, bool& onStack) {
+        bool toStack = !func.get_decl().hasNestedFunctions;
+        if (onStack && toStack) {
+            frame->recycle(func.get_closure(), func.get_locals());
+            return;
+        }
+        if (onStack) leave();
+        onStack = toStack;
+        if (onStack) {
+            if (m_depth == m_frames.size()) m_frames.push_back(std::make_unique<Environment>());
+            Environment* env = m_frames[m_depth++].get();
+            env->recycle(func.get_closure(), func.get_locals());
+            frame = std::shared_ptr<Environment>(std::shared_ptr<Environment>(), env);
+        } else if (frame.use_count() == 1) {
+            frame->recycle(func.get_closure(), func.get_locals());
+        } else {
+            frame = makePooled<Environment>(func.get_closure(), func.get_locals());
+        }
+    }
+
+    // Releases the innermost stack frame and what its slots refer to.
+    void leave() { m_frames[--m_depth]->release(); }
+
+private:
+    std::vector<std::unique_ptr<Environment>> m_frames;
+    size_t m_depth = 0;  // frames in use
+};
+
+#endif // FRAME_STACK_H
@@ -0,0 +1,82 @@
+#ifndef INLINE_CACHE_H
+#define INLINE_CACHE_H
+
+#include <cstdint>
+#include "core/Environment.h"
+#include "objects/FunctionObject.h"
+#include "objects/Value.h"
+
+// Per-site caches used by all three engines for reading globals and for
+// calling functions.
+
+struct InlineCacheStats {
+    uint64_t globalHits = 0;
+    uint64_t globalMisses = 0;
+    uint64_t callHits = 0;
+    uint64_t callMisses = 0;
+};
+
+// Process-wide counters, printed by --stats.
+inline InlineCacheStats& inlineCacheStats() {
+    static InlineCacheStats stats;
+    return stats;
+}
+
+// A global variable read. Remembers where the name's value lives in the
+// global scope, checked against the scope's binding version: while nothing
+// has been bound or rebound to another object since, a read is one compare
+// and a load.
+struct GlobalReadCache {
+    uint64_t version = 0;  // never a valid binding version
+    const Value* slot = nullptr;
+
+    const Value& read(Environment& globals, Symbol name) {
+        if (version == globals.version()) {
+            ++inlineCacheStats().globalHits;
+            return *slot;
+        }
+        ++inlineCacheStats().globalMisses;
+        slot = &globals.get(name);
+        version = globals.version();
+        return *slot;
+    }
+};
+
+// A global stored into again and again, such as a counted loop's variable.
+// A number stored over a number leaves the binding version alone, so once
+// the name is bound such a store goes straight to its entry; any other
+// store takes the full path.
+struct GlobalNumberStore {
+    Value* slot = nullptr;
+
+    void store(Environment& globals, Symbol name, Value value) {
+        if (slot && slot->is_number() && value.is_number()) {
+            *slot = value;
+            return;
+        }
+        globals.set(name, std::move(value));
+        slot = globals.entry(name);
+    }
+};
+
+// A call site. Remembers the last callee that was a function, so calling
+// the same object again skips the type check. Holds a reference to it, so
+// the address cannot be reused by another object while cached.
+struct CallCache {
+    Value callee;
+    FunctionObject* function = nullptr;
+
+    // The callee as a function, or nullptr if it is not one.
+    FunctionObject* resolve(const Value& value) {
+        if (value.is_object() && function && value.as_object() == callee.as_object()) {
+            ++inlineCacheStats().callHits;
+            return function;
+        }
+        ++inlineCacheStats().callMisses;
+        function = value.as<FunctionObject>();
+        callee = function ? value : Value();
+        return function;
+    }
+};
+
+#endif // INLINE_CACHE_H
@@ -5,52 +5,52 @@
 #include <string>
 #include <unordered_map>
 #include "core/AST.h"
+#include "core/Completion.h"
 #include "core/Environment.h"
+#include "core/FrameStack.h"
+#include "core/InlineCache.h"
+#include "core/Quickening.h"
 #include "objects/FunctionObject.h"
-#include "objects/Object.h"
-
-class BreakException : public std::exception {
-    const char* what() const noexcept override;
-};
-class ContinueException : public std::exception {
-    const char* what() const noexcept override;
-};
-
-class ReturnException : public std::exception {
-public:
-    ObjectPtr value;
-    ReturnException(ObjectPtr v);
-    const char* what() const noexcept override;
-};
+#include "objects/Value.h"
 
 class Interpreter {
 public:
     Interpreter();
-    void run(const std::vector<std::unique_ptr<Stmt>>& statements);
+    void run(const Ast& ast);
 private:
+    const Ast* m_ast = nullptr;
     std::shared_ptr<Environment> m_global_env;
     std::shared_ptr<Environment> m_current_env;
+    Value m_return_value; // set by a statement completing with Return
+    // Call left by a return in tail position; callFunction makes it in
+    // place of the call that returned
+    Value m_tail_callee;
+    FunctionObject* m_tail_function = nullptr;
+    std::vector<Value> m_tail_arguments;
+    FrameStack m_frames;
+    // Inline caches of global reads, and the quickened binary operations,
+    // indexes and calls; m_cacheSites maps each such expression to its entry
+    std::vector<uint32_t> m_cacheSites;
+    std::vector<GlobalReadCache> m_globalCaches;
+    std::vector<QuickSite> m_quickSites;
+    std::vector<QuickCall> m_callSites;
     
-    void visit(const Stmt* stmt);
-    void visitExpressionStmt(const ExpressionStmt* stmt);
-    void visitAssignStmt(const AssignStmt* stmt);
-    void visitIfStmt(const IfStmt* stmt);
-    void visitWhileStmt(const WhileStmt* stmt);
-    void visitForStmt(const ForStmt* stmt);
-    void visitBlockStmt(const BlockStmt* stmt);
-    void visitFunctionDefStmt(const FunctionDefStmt* stmt);
-    void visitReturnStmt(const ReturnStmt* stmt);
-    ObjectPtr eval(const Expr* expr);
-    
-    // Built-in functions
-    void setupBuiltinFunctions();
-    ObjectPtr callFunction(ObjectPtr callee, const std::vector<ObjectPtr>& arguments);
+    Completion visit(NodeIndex index);
+    Completion visitBlock(NodeList statements);
+    Completion visitWhileStmt(const Stmt& stmt);
+    Completion visitForStmt(const Stmt& stmt);
+    void visitFunctionDefStmt(const Stmt& stmt);
+    Completion visitReturnStmt(const Stmt& stmt);
+    Completion visitTailCall(NodeIndex call);
+    Value eval(NodeIndex index);
+    std::vector<Value> evalArguments(NodeList items);
+
+    // Variable access through the slots assigned by Resolver
+    const Value& lookup(Symbol name, const Binding& binding);
+    void define(Symbol name, const Binding& binding, Value value);
+    void assign(Symbol name, const Binding& binding, Value value);
     
-    // Helper methods for operation evaluation
-    ObjectPtr evaluateNumberOperation(double left, double right, const std::string& op);
-    ObjectPtr evaluateStringOperation(const std::string& left, const std::string& right, const std::string& op);
-    ObjectPtr evaluateStringNumberOperation(const std::string& str, double num, const std::string& op);
-    bool isTruthy(ObjectPtr value);
+    Value callFunction(FunctionObject* func, const std::vector<Value>& arguments);
 };
 
 #endif // INTERPRETER_H
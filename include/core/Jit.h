@@ -0,0 +1,108 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "core/AST.h"
+#include "core/Environment.h"
+#include "core/ExecutableMemory.h"
+#include "objects/Value.h"
+
+// Baseline compiler from the resolved AST to x86-64 machine code, enabled by
+// --jit. It takes user functions and top-level loops that only compute with
+// numbers:
+//   a function qualifies when it defines no functions, is not memoized,
+//     reads only its own locals, each after it is certainly assigned, and
+//     calls only global functions that qualify themselves (bound once by a
+//     global 'def'), with the right number of arguments;
+//   a top-level while or for loop qualifies when it reads and assigns only
+//     globals and makes no calls.
+// Both may use arithmetic, comparison and logical operators, 'if', 'while',
+// 'break', 'continue' and 'for' over range(...) when the program never
+// rebinds 'range'. Values stay unboxed doubles in the native frame.
+//
+// Whether the values really are numbers is checked on entry: the arguments
+// of a call, and the globals a loop uses. Anything else runs interpreted,
+// as does a function whose native code recurses deeper than the native
+// stack allows (it is pure, so running it again is safe).
+//
+// Compiled code is only generated on x86-64 (System V or Windows calling
+// convention); elsewhere compile() leaves everything interpreted.
+
+enum class JitStatus : int {
+    Done = 0,
+    TooDeep = 1,   // gave up: recursion past the native depth limit
+    ZeroStep = 2,  // range() with a zero step
+};
+
+struct JitFunction {
+    using Entry = int (*)(const double* arguments, double* result);
+
+    Entry entry = nullptr;
+    uint32_t arity = 0;
+    // Global names of the functions its code calls, directly or not, with
+    // the declarations they must hold; checked until they all do.
+    std::vector<std::pair<Symbol, const FunctionDecl*>> callees;
+    mutable bool ready = false;
+    mutable bool disabled = false;  // gave up once; interpreted from now on
+
+    // Runs the native code. Returns false, with nothing done, if an
+    // argument is not a number, a callee is not defined yet, or the native
+    // code gave up; the caller then interprets the call.
+    bool call(Environment& globals, const Value* arguments, size_t count, Value& result) const;
+};
+
+struct JitLoop {
+    using Entry = int (*)(double* variables);
+
+    Entry entry = nullptr;
+    // The globals the loop uses, in the order entry sees them, and whether
+    // each must be bound before the loop (it is read before the loop
+    // certainly assigns it).
+    std::vector<Symbol> variables;
+    std::vector<bool> required;
+
+    // Runs the loop on the globals and writes them back. Returns false, with
+    // nothing done, if one of them is bound to something other than a
+    // number or a required one is unbound.
+    bool run(Environment& globals) const;
+};
+
+// Totals of the run, printed by --stats.
+struct JitStats {
+    uint64_t functions = 0;  // compiled
+    uint64_t loops = 0;      // compiled
+    uint64_t codeBytes = 0;
+    uint64_t nativeCalls = 0;
+    uint64_t loopRuns = 0;
+    uint64_t fallbacks = 0;  // calls and loops handed back to the interpreter
+};
+
+inline JitStats& jitStats() {
+    static JitStats stats;
+    return stats;
+}
+
+class Jit {
+public:
+    Jit();
+    ~Jit();
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // True where compile() generates code.
+    static bool available();
+
+    // Compiles what qualifies and points FunctionDecl::jit and Stmt::jit at
+    // the result, which lives as long as this Jit.
+    void compile(Ast& ast);
+
+private:
+    std::vector<std::unique_ptr<JitFunction>> m_functions;
+    std::vector<std::unique_ptr<JitLoop>> m_loops;
+    ExecutableMemory m_code;
+};
+
+#endif // JIT_H
@@ -0,0 +1,30 @@
+#ifndef LEX_SCANNER_H
+#define LEX_SCANNER_H
+
+#include <string>
+
+// Character-class scanners for the tokenizer's hot loops. Each returns the
+// first position in [p, end) that does not belong to the run (or end).
+// Vector versions look at 16 (SSE2) or 32 (AVX2) bytes per step; the best
+// one the CPU supports is picked on first use.
+struct LexScanner {
+    const char* name;
+    // Spaces, tabs and carriage returns
+    const char* (*skipBlanks)(const char* p, const char* end);
+    // [A-Za-z0-9_]
+    const char* (*skipIdentifier)(const char* p, const char* end);
+    // [0-9]
+    const char* (*skipDigits)(const char* p, const char* end);
+    // Position of the next '\n'
+    const char* (*findNewline)(const char* p, const char* end);
+    // Position of the next quote, backslash or '\n' inside a string literal
+    const char* (*findStringStop)(const char* p, const char* end, char quote);
+};
+
+const LexScanner& lexScanner();
+
+// Forces a scanner by name ("scalar", "sse2" or "avx2"). Returns false if
+// the CPU or the build does not support it. Used by the lexer benchmark.
+bool selectLexScanner(const std::string& name);
+
+#endif // LEX_SCANNER_H
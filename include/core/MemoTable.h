@@ -0,0 +1,54 @@
+#ifndef MEMO_TABLE_H
+#define MEMO_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "objects/Value.h"
+
+// Results of a memoized function keyed by its arguments, evicting the least
+// recently used entry beyond a fixed size. Only numbers and strings are
+// cached, as arguments or as results: they compare by value and never
+// change, so a cached call cannot be told apart from a real one. Any other
+// call goes through uncached.
+class MemoTable {
+public:
+    static constexpr size_t kDefaultCapacity = 65536;
+
+    explicit MemoTable(size_t capacity) : m_capacity(capacity) {}
+
+    // Encodes arguments into key. Returns false if one of them cannot be
+    // cached.
+    static bool makeKey(const Value* arguments, size_t count, std::string& key);
+
+    // Cached result for key, or nullptr (counted as a hit or a miss).
+    const Value* find(const std::string& key);
+    // Records a result for key unless it cannot be cached.
+    void store(const std::string& key, const Value& result);
+
+private:
+    struct Entry {
+        std::string key;
+        Value result;
+    };
+    size_t m_capacity;
+    std::list<Entry> m_entries;  // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;  // views of Entry::key
+};
+
+// Totals over every table of the run, printed by --stats.
+struct MemoStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+inline MemoStats& memoStats() {
+    static MemoStats stats;
+    return stats;
+}
+
+#endif // MEMO_TABLE_H
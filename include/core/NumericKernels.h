@@ -0,0 +1,33 @@
+#ifndef NUMERIC_KERNELS_H
+#define NUMERIC_KERNELS_H
+
+#include <cstddef>
+#include <string>
+
+// Kernels over packed arrays of numbers, behind the sum(), min(), max(),
+// mean(), dot() and matmul() builtins. Vector versions work on 2 (SSE2) or
+// 4 (AVX2) doubles per step, with several independent accumulators; the
+// best one the CPU supports is picked on first use. Sums are added up in a
+// different order by each version, so their last bits may differ between
+// versions (never between engines or runs). matmul is the exception: every
+// version adds the products of each element in the same order, so they
+// agree to the bit.
+struct NumericKernels {
+    const char* name;
+    double (*sum)(const double* p, size_t n);
+    // For n > 0. NaN if any element is NaN.
+    double (*min)(const double* p, size_t n);
+    double (*max)(const double* p, size_t n);
+    double (*dot)(const double* a, const double* b, size_t n);
+    // c (n x p) += a (n x m) * b (m x p), all row-major without gaps.
+    void (*matmul)(const double* a, const double* b, double* c, size_t n, size_t m, size_t p);
+};
+
+const NumericKernels& numericKernels();
+
+// Forces the kernels by name ("scalar", "sse2" or "avx2"). Returns false if
+// the CPU or the build does not support them. Used by the reduction
+// benchmark.
+bool selectNumericKernels(const std::string& name);
+
+#endif // NUMERIC_KERNELS_H
@@ -0,0 +1,86 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "core/Token.h"
+#include "objects/ArrayObject.h"
+#include "objects/IteratorObject.h"
+#include "objects/Value.h"
+
+// Runtime semantics shared by every execution engine, so that all of them
+// produce identical results and identical error messages.
+
+// Binary operators, in the order they appear in TokenType. Assign,
+// PlusAssign and MinusAssign fall inside this range but are not operators.
+constexpr bool isBinaryOperator(TokenType type) {
+    return type >= TokenType::Plus && type <= TokenType::Or && type != TokenType::Assign &&
+           type != TokenType::PlusAssign && type != TokenType::MinusAssign;
+}
+
+// Number-number kernel of each binary operator. Engines with their own
+// number fast path instantiate these directly.
+template <TokenType Op> struct NumberKernel;
+template <> struct NumberKernel<TokenType::Plus> { static double apply(double a, double b) { return a + b; } };
+template <> struct NumberKernel<TokenType::Minus> { static double apply(double a, double b) { return a - b; } };
+template <> struct NumberKernel<TokenType::Star> { static double apply(double a, double b) { return a * b; } };
+template <> struct NumberKernel<TokenType::Slash> { static double apply(double a, double b) { return a / b; } };
+template <> struct NumberKernel<TokenType::Percent> { static double apply(double a, double b) { return std::fmod(a, b); } };
+template <> struct NumberKernel<TokenType::Power> { static double apply(double a, double b) { return std::pow(a, b); } };
+template <> struct NumberKernel<TokenType::Equal> { static double apply(double a, double b) { return a == b ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::NotEqual> { static double apply(double a, double b) { return a != b ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::Less> { static double apply(double a, double b) { return a < b ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::Greater> { static double apply(double a, double b) { return a > b ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::LessEqual> { static double apply(double a, double b) { return a <= b ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::GreaterEqual> { static double apply(double a, double b) { return a >= b ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::And> { static double apply(double a, double b) { return (a && b) ? 1.0 : 0.0; } };
+template <> struct NumberKernel<TokenType::Or> { static double apply(double a, double b) { return (a || b) ? 1.0 : 0.0; } };
+
+// Dispatches through a table with one kernel per (operator, left operand
+// type, right operand type).
+Value evaluateBinaryOperation(const Value& left, const Value& right, TokenType op);
+Value evaluateUnaryOperation(const Value& operand, TokenType op);
+
+// The element index (a number, negative from the end) refers to in a
+// collection of size elements; throws if there is none.
+inline size_t resolveIndex(const Value& index, size_t size) {
+    if (index.is_number()) {
+        int idx = static_cast<int>(index.as_number());
+        if (idx < 0) idx += static_cast<int>(size);
+        if (idx < 0 || idx >= static_cast<int>(size))
+            throw std::runtime_error("Index out of range");
+        return static_cast<size_t>(idx);
+    }
+    throw std::runtime_error("Index must be a number");
+}
+
+Value evaluateIndex(const Value& collection, const Value& index);
+
+// a[i][j] on a 2-D array, without making a view of row i. Once a and i are
+// evaluated, matrixRow returns the array and sets row, or nullptr if a is
+// not a 2-D array (then the engine indexes generically). After evaluating
+// j, matrixElement reads the element. Errors are those of evaluateIndex.
+// Inline, as every a[i][j] on lists of lists goes through matrixRow too.
+inline const ArrayObject* matrixRow(const Value& collection, const Value& index, size_t& row) {
+    // Compares the addresses of the type_infos, as comparing them as values
+    // tells different types apart with a strcmp of their names. Should a
+    // type have two type_infos, a miss only costs the row view.
+    if (!collection.is_object() || &typeid(*collection.as_object()) != &typeid(ArrayObject)) return nullptr;
+    auto array = static_cast<const ArrayObject*>(collection.as_object().get());
+    if (array->dims() != 2) return nullptr;
+    row = resolveIndex(index, array->rows());
+    return array;
+}
+
+inline double matrixElement(const ArrayObject& matrix, size_t row, const Value& index) {
+    return matrix.at(row, resolveIndex(index, matrix.cols()));
+}
+
+Value evaluateMemberAccess(const Value& object, const std::string& member);
+std::shared_ptr<IteratorObject> makeIterator(const Value& iterable);
+
+bool isTruthy(const Value& value);
+
+#endif // OPERATIONS_H
@@ -0,0 +1,39 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <vector>
+#include "core/AST.h"
+#include "objects/Value.h"
+
+// Rewrites the parsed AST in place before Resolver runs.
+//   level 0: no changes
+//   level 1: constant folding, pruning of constant if/while branches,
+//            removal of statements after return/break/continue, and
+//            identities (x * 1, x - 0, ...) on operands known to be numbers
+//   level 2: level 1, plus the identities (including x + 0) on any operand,
+//            which assumes they are numbers and can hide a type error
+class Optimizer {
+public:
+    explicit Optimizer(int level) : m_level(level) {}
+    void optimize(Ast& ast);
+
+private:
+    int m_level;
+    Ast* m_ast = nullptr;
+
+    void optimizeBlock(NodeList& statements);
+    // Appends the optimized form of a statement to out. Returns false when
+    // the statements following it can never run.
+    bool optimizeStmt(NodeIndex index, std::vector<NodeIndex>& out);
+    bool spliceBranch(NodeList branch, std::vector<NodeIndex>& out);
+
+    void optimizeExpr(NodeIndex index);
+    void foldBinary(NodeIndex index);
+    void foldUnary(NodeIndex index);
+    bool simplifyIdentity(NodeIndex index);
+    bool isNumeric(NodeIndex index) const;
+    bool literalValue(NodeIndex index, Value& out) const;
+    bool replaceWithLiteral(NodeIndex index, const Value& value);
+};
+
+#endif // OPTIMIZER_H
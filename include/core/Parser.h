@@ -1,22 +1,24 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <memory>
 #include <unordered_map>
 #include <vector>
 #include "core/AST.h"
 #include "core/Token.h"
+#include "core/Tokenizer.h"
 
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens);
+    // Pulls tokens from the tokenizer on demand; only a few are held at a time.
+    Parser(Tokenizer& tokenizer);
 
-    std::vector<std::unique_ptr<Stmt>> parse();
+    // Builds the flat AST of the whole program.
+    Ast parse();
 
 private:
     // Pratt parser function types
-    using PrefixParseFn = std::unique_ptr<Expr> (Parser::*)();
-    using InfixParseFn = std::unique_ptr<Expr> (Parser::*)(std::unique_ptr<Expr>);
+    using PrefixParseFn = NodeIndex (Parser::*)();
+    using InfixParseFn = NodeIndex (Parser::*)(NodeIndex);
     
     struct ParseRule {
         PrefixParseFn prefix;
@@ -26,48 +28,56 @@ private:
     
     static const std::unordered_map<TokenType, ParseRule> s_parseRules;
     
-    const std::vector<Token>& m_tokens;
-    size_t m_current;
+    // Ring buffer over the token stream holding the previous token, the
+    // current one and one token of lookahead. Positions are absolute.
+    static constexpr size_t kTokenWindow = 4;
+    Tokenizer& m_tokenizer;
+    std::vector<Token> m_window;
+    size_t m_current = 0;  // position of peek()
+    size_t m_fetched = 0;  // tokens pulled from the tokenizer so far
+    Ast m_ast;
 
     // Statement parsing
-    std::unique_ptr<Stmt> parseStatement();
-    std::unique_ptr<Stmt> parseFunctionDef();
-    std::unique_ptr<Stmt> parseIf();
-    std::unique_ptr<Stmt> parseWhile();
-    std::unique_ptr<Stmt> parseFor();
-    std::unique_ptr<Stmt> parseBlock();
-    std::unique_ptr<Stmt> parseExpressionStatement();
-    std::unique_ptr<Stmt> parseAssignment();
-    std::unique_ptr<Stmt> parseReturn();
+    NodeIndex parseStatement();
+    NodeIndex parseFunctionDef();
+    NodeIndex parseIf();
+    NodeIndex parseWhile();
+    NodeIndex parseFor();
+    NodeList parseBlock();
+    NodeIndex parseExpressionStatement();
+    NodeIndex parseAssignment();
+    NodeIndex parseReturn();
 
     // Expression parsing with Pratt parser
-    std::unique_ptr<Expr> parseExpression(int precedence = 0);
-    std::unique_ptr<Expr> parsePrecedence();
+    NodeIndex parseExpression(int precedence = 0);
+    NodeIndex parsePrecedence();
     
     // Prefix parsers
-    std::unique_ptr<Expr> parseNumber();
-    std::unique_ptr<Expr> parseString();
-    std::unique_ptr<Expr> parseVariable();
-    std::unique_ptr<Expr> parseBoolean();
-    std::unique_ptr<Expr> parseNone();
-    std::unique_ptr<Expr> parseGrouping();
-    std::unique_ptr<Expr> parseList();
-    std::unique_ptr<Expr> parseUnary();
+    NodeIndex parseNumber();
+    NodeIndex parseString();
+    NodeIndex parseVariable();
+    NodeIndex parseBoolean();
+    NodeIndex parseNone();
+    NodeIndex parseGrouping();
+    NodeIndex parseList();
+    NodeIndex parseUnary();
     
     // Infix parsers
-    std::unique_ptr<Expr> parseBinary(std::unique_ptr<Expr> left);
-    std::unique_ptr<Expr> parseCall(std::unique_ptr<Expr> left);
-    std::unique_ptr<Expr> parseIndex(std::unique_ptr<Expr> left);
-    std::unique_ptr<Expr> parseMemberAccess(std::unique_ptr<Expr> left);
+    NodeIndex parseBinary(NodeIndex left);
+    NodeIndex parseCall(NodeIndex left);
+    NodeIndex parseIndex(NodeIndex left);
+    NodeIndex parseMemberAccess(NodeIndex left);
     
-    std::vector<std::unique_ptr<Expr>> parseArguments();
+    NodeList parseArguments();
 
     // Helpers
     bool match(TokenType type);
     bool check(TokenType type) const;
     const Token& advance();
     const Token& peek() const;
+    const Token& peekNext();
     const Token& previous() const;
+    void fetch(size_t position);
     bool isAtEnd() const;
     int getPrecedence(TokenType type) const;
     void skipNewlines();
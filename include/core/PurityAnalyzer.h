@@ -0,0 +1,39 @@
+#ifndef PURITY_ANALYZER_H
+#define PURITY_ANALYZER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "core/AST.h"
+
+// Picks the functions --auto-memo caches, after Resolver has run, and sets
+// their FunctionDecl::memoCapacity. A function is picked when it is
+//   pure: it assigns only its own locals, defines no functions, reads no
+//     enclosing function's locals and no globals except functions bound
+//     once by a global 'def' and builtins the program never rebinds, and
+//     calls only pure functions and pure builtins (not print);
+//   recursive: it reaches itself through its calls. A pure function that
+//     does not is cheaper to call again than to look up.
+// Arguments are still checked at every call: only numbers and strings are
+// cached (see MemoTable).
+class PurityAnalyzer {
+public:
+    explicit PurityAnalyzer(uint32_t memoCapacity) : m_memoCapacity(memoCapacity) {}
+    void analyze(Ast& ast);
+
+private:
+    uint32_t m_memoCapacity;
+    const Ast* m_ast = nullptr;
+    std::unordered_map<Symbol, int> m_globalBindings;        // binding sites per global name
+    std::unordered_map<Symbol, uint32_t> m_globalFunctions;  // global defs, by name
+    std::vector<std::vector<uint32_t>> m_callees;            // user functions each one calls
+
+    bool checkBlock(NodeList statements, uint32_t function);
+    bool checkStmt(NodeIndex index, uint32_t function);
+    bool checkExpr(NodeIndex index, uint32_t function);
+    bool isStableFunction(Symbol name) const;
+    bool isPureBuiltin(Symbol name) const;
+    bool reaches(uint32_t from, uint32_t target, std::vector<bool>& visited) const;
+};
+
+#endif // PURITY_ANALYZER_H
@@ -0,0 +1,143 @@
+#ifndef QUICKENING_H
+#define QUICKENING_H
+
+#include <cstdint>
+#include <vector>
+#include "core/InlineCache.h"
+#include "core/Operations.h"
+#include "core/Token.h"
+#include "objects/FunctionObject.h"
+#include "objects/ListObject.h"
+#include "objects/ObjectPool.h"
+#include "objects/StringObject.h"
+#include "objects/Value.h"
+
+// Self-specializing expression sites ("quickening") of the AST engines.
+// A binary operation, an index or a call starts out generic. After it runs,
+// it rewrites itself into the form that fits the operand types it saw:
+// number arithmetic straight through the operator's kernel, string
+// concatenation, indexing a list, calling a builtin. A specialized form
+// checks its operands with one compare each and skips the generic dispatch.
+// When that guard fails, the site deoptimizes back to the generic form and
+// specializes again on what it sees next; a site that has deoptimized
+// kMaxDeopts times, or whose operands fit no specialized form, stays
+// generic.
+
+enum class QuickForm : uint8_t {
+    Generic,
+    NumberBinary,  // number op number
+    StringConcat,  // string + string
+    ListIndex,     // list[number]
+    BuiltinCall,   // the builtin the site called last
+};
+
+// Totals of the run, printed by --stats.
+struct QuickStats {
+    uint64_t quickened = 0;    // sites specialized, again after a deopt included
+    uint64_t deoptimized = 0;  // guards that failed
+    uint64_t generic = 0;      // sites left generic for good
+};
+
+inline QuickStats& quickStats() {
+    static QuickStats stats;
+    return stats;
+}
+
+// The state shared by every kind of site.
+class QuickState {
+public:
+    static constexpr uint8_t kMaxDeopts = 4;
+
+    QuickForm form() const { return m_form; }
+
+protected:
+    QuickForm m_form = QuickForm::Generic;
+    uint8_t m_deopts = 0;
+
+    bool mayQuicken() const { return m_deopts < kMaxDeopts; }
+    void quicken(QuickForm form) {
+        m_form = form;
+        ++quickStats().quickened;
+    }
+    void deoptimize() {
+        m_form = QuickForm::Generic;
+        ++quickStats().deoptimized;
+        if (++m_deopts == kMaxDeopts) ++quickStats().generic;
+    }
+    // Nothing to specialize on: generic from now on.
+    void stayGeneric() {
+        m_deopts = kMaxDeopts;
+        ++quickStats().generic;
+    }
+};
+
+// A binary operation or an index.
+class QuickSite : public QuickState {
+public:
+    using NumberKernelFn = double (*)(double, double);
+
+    Value binary(const Value& left, const Value& right, TokenType op) {
+        if (m_form == QuickForm::NumberBinary) {
+            if (left.is_number() && right.is_number()) return m_kernel(left.as_number(), right.as_number());
+            deoptimize();
+        } else if (m_form == QuickForm::StringConcat) {
+            const StringObject* a = left.as_exact<StringObject>();
+            const StringObject* b = a ? right.as_exact<StringObject>() : nullptr;
+            if (b) return makePooled<StringObject>(a->value + b->value);
+            deoptimize();
+        }
+        Value result = evaluateBinaryOperation(left, right, op);
+        if (mayQuicken()) quickenBinary(left, right, op);
+        return result;
+    }
+
+    Value index(const Value& collection, const Value& index) {
+        if (m_form == QuickForm::ListIndex) {
+            const ListObject* list = collection.as_exact<ListObject>();
+            if (list && index.is_number()) {
+                int size = static_cast<int>(list->size());
+                int i = static_cast<int>(index.as_number());
+                if (i < 0) i += size;
+                if (i >= 0 && i < size) return list->at(i);
+                return evaluateIndex(collection, index);  // the error
+            }
+            deoptimize();
+        }
+        Value result = evaluateIndex(collection, index);
+        if (mayQuicken()) quickenIndex(collection, index);
+        return result;
+    }
+
+private:
+    NumberKernelFn m_kernel = nullptr;
+
+    void quickenBinary(const Value& left, const Value& right, TokenType op);
+    void quickenIndex(const Value& collection, const Value& index);
+};
+
+// A call. Generic calls resolve the callee through the site's CallCache;
+// once a call reaches a builtin, calling that same object again goes
+// straight to its function.
+class QuickCall : public QuickState {
+public:
+    CallCache cache;
+
+    // Calls callee, through generic(function, arguments) for anything but
+    // the builtin the site is specialized on.
+    template <typename Generic>
+    Value call(const Value& callee, const std::vector<Value>& arguments, Generic&& generic) {
+        if (m_form == QuickForm::BuiltinCall) {
+            if (callee.is_object() && callee.as_object() == cache.callee.as_object()) {
+                return cache.function->get_builtin()(arguments);
+            }
+            deoptimize();
+        }
+        FunctionObject* function = cache.resolve(callee);
+        if (function && function->get_type() == FunctionObject::FunctionType::BUILTIN && mayQuicken()) {
+            quicken(QuickForm::BuiltinCall);
+        }
+        return generic(function, arguments);
+    }
+};
+
+#endif // QUICKENING_H
@@ -0,0 +1,35 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <unordered_map>
+#include <vector>
+#include "core/AST.h"
+
+// Static pass run between parsing and execution. Assigns every name used
+// inside a function either a (depth, slot) pair in a function frame or marks
+// it global. A function's locals are its parameters plus every name it
+// assigns, loops over or defines, so frames can be flat slot arrays.
+class Resolver {
+public:
+    void resolve(Ast& ast);
+
+private:
+    struct Scope {
+        FunctionDecl* function;
+        std::unordered_map<Symbol, int> slots;
+    };
+    Ast* m_ast = nullptr;
+    std::vector<Scope> m_scopes;  // enclosing functions, innermost last
+
+    void resolveBlock(NodeList statements);
+    void resolveStmt(NodeIndex index);
+    void resolveExpr(NodeIndex index);
+    void resolveFunction(FunctionDecl& function);
+
+    void declareLocals(NodeList statements, Scope& scope);
+    void declare(Symbol name, Scope& scope);
+    Binding lookup(Symbol name) const;
+    Binding local(Symbol name) const;
+};
+
+#endif // RESOLVER_H
@@ -0,0 +1,33 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <string>
+#include <string_view>
+
+// Read-only view of a file's bytes: a script, or an AST cache. On POSIX
+// systems the file is mapped into memory, so it is never copied; elsewhere,
+// or when mapping fails (empty files, pipes), it is read into an owned
+// buffer.
+class SourceFile {
+public:
+    SourceFile() = default;
+    ~SourceFile();
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // Returns false if the file cannot be opened or read.
+    bool open(const std::string& path);
+
+    std::string_view text() const { return m_text; }
+    bool isMapped() const { return m_mapped != nullptr; }
+
+private:
+    void* m_mapped = nullptr;
+    size_t m_mappedSize = 0;
+    std::string m_buffer;  // fallback storage
+    std::string_view m_text;
+
+    bool readFallback(const std::string& path);
+};
+
+#endif // SOURCE_FILE_H
@@ -0,0 +1,50 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// An interned identifier or string literal. Every distinct text is stored
+// once per process together with its hash, and a Symbol is a pointer to that
+// entry: symbols compare by address and hash without touching the text.
+// Entries are never freed, so symbols stay valid for the whole run.
+class Symbol {
+public:
+    // The empty string.
+    Symbol();
+
+    static Symbol intern(std::string_view text);
+    // The symbol with the given id(); ids come from interned symbols only.
+    static Symbol fromId(uint32_t id);
+    // Number of distinct symbols interned so far.
+    static size_t count();
+
+    const std::string& text() const { return m_entry->text; }
+    size_t hash() const { return m_entry->hash; }
+    uint32_t id() const { return m_entry->id; }  // dense, in interning order
+
+    bool operator==(Symbol other) const { return m_entry == other.m_entry; }
+    bool operator!=(Symbol other) const { return m_entry != other.m_entry; }
+
+    struct Entry {
+        std::string text;
+        size_t hash;
+        uint32_t id;
+    };
+
+private:
+    explicit Symbol(const Entry* entry) : m_entry(entry) {}
+    const Entry* m_entry;
+};
+
+namespace std {
+template <>
+struct hash<Symbol> {
+    size_t operator()(Symbol symbol) const noexcept { return symbol.hash(); }
+};
+}
+
+#endif // SYMBOL_H
@@ -1,11 +1,11 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
 #include <ostream>
-#include <string>
-#include <variant>
+#include "core/Symbol.h"
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     // Literals
     Number,
     String,
@@ -69,18 +69,35 @@ enum class TokenType {
 };
 
 
+// 16 bytes. The token's text is the source span [offset, offset + length);
+// Tokenizer::lexeme returns it. Numbers carry their value and identifiers
+// their symbol id inline. String literals are decoded only on request, by
+// Tokenizer::stringValue.
 struct Token {
-    TokenType type;
-    std::string text; // The actual text from input
-    std::variant<std::monostate, double, std::string> value; // For numbers, strings, identifiers
+    static constexpr uint32_t kMaxLength = (1u << 24) - 1;
 
-    Token(TokenType t, const std::string& txt);
-    Token(TokenType t, const std::string& txt, double num);
-    Token(TokenType t, const std::string& txt, const std::string& str);
+    uint32_t offset;
+    uint32_t length : 24;
+    TokenType type : 8;
+    union {
+        double number;    // Number
+        uint32_t symbol;  // Identifier: Symbol id
+    };
+
+    Token() : Token(TokenType::EndOfInput, 0, 0) {}
+    Token(TokenType t, uint32_t off, uint32_t len) : offset(off), length(len), type(t), number(0) {}
+    Token(TokenType t, uint32_t off, uint32_t len, double num) : offset(off), length(len), type(t), number(num) {}
+    Token(TokenType t, uint32_t off, uint32_t len, Symbol sym)
+        : offset(off), length(len), type(t), symbol(sym.id()) {}
+
+    Symbol symbolValue() const { return Symbol::fromId(symbol); }
 };
+static_assert(sizeof(Token) == 16, "Token should stay 16 bytes");
 
 
 const char* tokenTypeToString(TokenType type);
+// Source spelling of an operator token, e.g. "+" or "and".
+const char* operatorSymbol(TokenType type);
 
 std::ostream& operator<<(std::ostream& os, const Token& token);
 
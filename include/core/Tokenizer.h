@@ -1,14 +1,35 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
-#include <queue>
+#include <cstdint>
+#include <exception>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
+#include "core/LexScanner.h"
 #include "core/Token.h"
 
+struct SourceLocation {
+    uint32_t line;    // 1-based
+    uint32_t column;  // 1-based, in bytes
+};
+
+// Produces tokens one at a time from a view of the source. The source
+// must outlive the tokenizer and every token it returned; it is not copied.
 class Tokenizer {
 public:
-    Tokenizer(const std::string& input);
+    // Default chunk size for lexInParallel.
+    static constexpr size_t kParallelChunkBytes = 1 << 20;
+
+    Tokenizer(std::string_view input);
+
+    // Lexes the whole input now and serves later nextToken calls from the
+    // result. The input is cut into chunks of about chunkBytes at newlines,
+    // which up to `threads` threads lex at once (0: one per hardware
+    // thread). Tokens and lexical errors come out exactly as when lexing on
+    // demand. Call before the first nextToken.
+    void lexInParallel(unsigned threads, size_t chunkBytes = kParallelChunkBytes);
 
     // Get the next token (consumes it)
     Token nextToken();
@@ -19,28 +40,67 @@ public:
     // Check if at end of input
     bool isAtEnd() const;
 
+    // Source text of a token. INDENT, DEDENT, NEWLINE and end of input have
+    // no meaningful text and get a label instead.
+    std::string_view lexeme(const Token& token) const;
+    // Value of a String token with its escape sequences processed.
+    Symbol stringValue(const Token& token) const;
+    // Line and column of a source offset the tokenizer has already passed.
+    SourceLocation location(uint32_t offset) const;
+
 private:
-    std::string m_input;
+    std::string_view m_input;
     size_t m_pos;
-    size_t m_line;
-    size_t m_col;
+    const LexScanner& m_scan;
+    std::vector<uint32_t> m_lineStarts; // offset of each line start seen so far
     Token m_peekedToken;
     bool m_hasPeeked;
 
     // Indentation handling
     std::vector<int> m_indentStack; // stack of indentation levels
-    std::queue<Token> m_pendingIndents; // queue of INDENT/DEDENT tokens to emit
+    bool m_pendingIndent = false;   // an INDENT is due before the next token
+    int m_pendingDedents = 0;       // DEDENTs due before the next token
     bool m_atLineStart = true; // are we at the start of a new line?
 
+    // Identifier names met by a chunk lexer, numbered per chunk so that
+    // worker threads never touch the process-wide symbol table.
+    struct LocalNames {
+        std::unordered_map<std::string_view, uint32_t> ids;
+        std::vector<std::string_view> texts;
+    };
+    struct LexedRange;
+
+    // Chunk lexers leave indentation to the stitch step: every non-blank
+    // line gets one Indent token whose symbol field holds the line's width.
+    bool m_deferIndentation = false;
+    int m_lineIndent = 0;
+    LocalNames* m_localNames = nullptr;
+
+    // lexInParallel result
+    bool m_buffered = false;
+    std::vector<Token> m_tokens;
+    size_t m_nextToken = 0;
+    std::exception_ptr m_error; // raised once m_tokens is used up
+
     void skipWhitespace();
     char peekChar() const;
     char getChar();
     bool matchChar(char expected);
+    // Moves to a position returned by a LexScanner routine.
+    void skipTo(const char* p) { m_pos = static_cast<size_t>(p - m_input.data()); }
+    const char* cursor() const { return m_input.data() + m_pos; }
+    const char* inputEnd() const { return m_input.data() + m_input.size(); }
+    bool takePending(Token& token);
+    Token makeToken(TokenType type, size_t start) const;
     Token lexNumber();
     Token lexIdentifierOrKeyword();
     Token lexString();
     Token lexOperatorOrDelimiter();
     void processIndentation();
+    void applyIndentation(int indent);
+    void closeIndentation();
+    void lexRange(LexedRange& out, size_t from, size_t until) const;
+    bool appendRange(const LexedRange& range, size_t first);
 };
 
 #endif // TOKENIZER_H
@@ -0,0 +1,116 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "core/AST.h"
+#include "core/Environment.h"
+#include "objects/RangeObject.h"
+#include "objects/Value.h"
+
+// Tracing compiler for hot loops, enabled by --trace-jit. Every engine
+// counts the passes through the head of each while loop, and of each for
+// loop over a range. Once a loop gets hot, the next iteration is recorded
+// as a linear trace along the path the current values take. Recording
+// walks the body on those values without side effects. It puts a guard on
+// every branch the iteration takes and stops at anything other than number
+// arithmetic, variable reads and assignments, 'if' and 'continue'.
+//
+// The trace is then optimized before code is generated:
+//   constants are folded and propagated, and equal subexpressions are
+//     computed once;
+//   type guards are eliminated: everything a trace stores is a number, so
+//     the variables it reads are checked once on entry rather than at
+//     every read;
+//   guards on constants, guards repeating an earlier one, and anything
+//     else nothing depends on are dropped;
+//   code that only depends on variables the loop never assigns is run
+//     once, before the loop;
+//   registers are allocated to the values carried around the loop and to
+//     the temporaries of each iteration.
+//
+// The trace runs iterations as x86-64 code until the loop ends or a guard
+// fails. A failing guard is a side exit: the variables are written back as
+// they were at the start of that iteration, and the engine runs it
+// instead. When one guard accounts for a good share of the iterations, the
+// loop is recorded again with both branches of that 'if' in the trace:
+// each assignment in them selects, without branching, between its new
+// value and the old one. Only loops whose body holds no other loop or
+// function definition are considered. Loops that keep failing to record,
+// or whose traces keep exiting early, are left to the engine.
+
+// Totals of the run, printed by --stats.
+struct TraceStats {
+    uint64_t compiled = 0;
+    uint64_t codeBytes = 0;
+    uint64_t aborted = 0;      // recordings that met something a trace cannot run
+    uint64_t blacklisted = 0;  // loops left to the engine for good
+    uint64_t entered = 0;
+    uint64_t finished = 0;     // runs that ended the loop
+    uint64_t sideExits = 0;    // runs that handed an iteration back
+    uint64_t merged = 0;       // branches recorded again with both sides
+    uint64_t declined = 0;     // entries refused: a variable was not a number
+    uint64_t iterations = 0;   // loop iterations run natively
+    uint64_t guards = 0;       // type and branch guards recorded
+    uint64_t guardsEliminated = 0;
+};
+
+inline TraceStats& traceStats() {
+    static TraceStats stats;
+    return stats;
+}
+
+struct Trace;
+
+// The tracing state of one loop statement.
+class TraceLoop {
+public:
+    TraceLoop(const Ast& ast, const Stmt& loop);
+    ~TraceLoop();
+    TraceLoop(const TraceLoop&) = delete;
+    TraceLoop& operator=(const TraceLoop&) = delete;
+
+    // Counts a pass through the loop head. True when run() should be
+    // called: the loop is hot, or already has a trace.
+    bool tick() { return ++m_count >= m_threshold; }
+
+    // Runs the loop natively from its head, recording and compiling a trace
+    // first if there is none. frame is the engine's current scope; counter
+    // is the state of a for loop over a range (nullptr for a while loop)
+    // and is advanced past the iterations run. Returns true if the loop has
+    // finished, false if the engine should run the next iteration itself.
+    bool run(Environment& globals, Environment& frame, RangeCounter* counter);
+
+private:
+    const Ast& m_ast;
+    const Stmt& m_loop;
+    uint32_t m_count = 0;
+    uint32_t m_threshold;
+    uint32_t m_attempts = 0;   // recordings and traces given up on
+    uint32_t m_shortRuns = 0;  // consecutive runs that got nowhere
+    std::unique_ptr<Trace> m_trace;
+    std::vector<NodeIndex> m_merged;  // 'if' statements whose branches the trace merges
+    // Reused by every run: the values the trace works on, and where each
+    // variable lives
+    std::vector<double> m_values;
+    std::vector<Value*> m_slots;
+
+    void shortRun();
+    void retry();
+};
+
+class Tracer {
+public:
+    // True where traces can be compiled.
+    static bool available();
+
+    // Gives every loop that may be traced a TraceLoop, which lives as long
+    // as this Tracer, and points Stmt::trace at it.
+    void attach(Ast& ast);
+
+private:
+    std::vector<std::unique_ptr<TraceLoop>> m_loops;
+};
+
+#endif // TRACER_H
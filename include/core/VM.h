@@ -0,0 +1,47 @@
+#ifndef VM_H
+#define VM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/Bytecode.h"
+#include "core/Environment.h"
+#include "core/FrameStack.h"
+#include "core/MemoTable.h"
+#include "objects/Value.h"
+
+// Stack-based virtual machine executing the bytecode produced by Compiler.
+class VM {
+public:
+    VM();
+    void run(const Program& program);
+
+private:
+    struct CallFrame {
+        const Chunk* chunk;
+        const uint8_t* ip;
+        size_t stackBase;
+        std::shared_ptr<Environment> env;
+        bool onStack;  // env is one of m_frameStack
+    };
+
+    const Program* m_program = nullptr;
+    std::shared_ptr<Environment> m_global_env;
+    std::vector<Value> m_stack;
+    std::vector<CallFrame> m_frames;
+    FrameStack m_frameStack;
+    // Memoized calls in progress, innermost last
+    struct MemoCall {
+        size_t frame;  // index in m_frames
+        std::shared_ptr<MemoTable> table;
+        std::string key;
+    };
+    std::vector<MemoCall> m_memoCalls;
+
+    void execute();
+    void callBuiltin(const FunctionObject& func, size_t calleeSlot);
+    bool lookupMemo(const FunctionObject& func, size_t calleeSlot);
+    bool callNative(const FunctionObject& func, size_t calleeSlot);
+};
+
+#endif // VM_H
@@ -0,0 +1,167 @@
+#ifndef X86_ASSEMBLER_H
+#define X86_ASSEMBLER_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Where code generated by X86Assembler can run: x86-64 with the System V or
+// Windows calling convention.
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__unix__) || defined(__APPLE__) || defined(_WIN32))
+#define JIT_X86_64 1
+#endif
+
+// Just enough of an x86-64 encoder for Jit and Tracer: scalar double
+// arithmetic in xmm0-xmm15, 64-bit moves through the low eight general
+// registers, memory operands addressed off a base register, and rel32 jumps
+// and calls to labels that are patched by finish().
+class X86Assembler {
+public:
+    enum Reg : uint8_t { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7 };
+    enum Xmm : uint8_t {
+        XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
+        XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15,
+    };
+    // Condition codes of Jcc, as the low nibble of its opcode
+    enum Cond : uint8_t {
+        Below = 0x2, AboveEqual = 0x3, Equal = 0x4, NotEqual = 0x5,
+        BelowEqual = 0x6, Above = 0x7, Parity = 0xA, Greater = 0xF,
+    };
+    // cmpsd predicates; NotEqual is true for unordered operands
+    enum Compare : uint8_t { CmpEqual = 0, CmpLess = 1, CmpLessEqual = 2, CmpNotEqual = 4 };
+
+    using Label = uint32_t;
+
+    const std::vector<uint8_t>& code() const { return m_code; }
+    size_t size() const { return m_code.size(); }
+
+    Label newLabel() {
+        m_labels.push_back(-1);
+        return static_cast<Label>(m_labels.size() - 1);
+    }
+    void bind(Label label) { m_labels[label] = static_cast<int64_t>(m_code.size()); }
+    bool bound(Label label) const { return m_labels[label] >= 0; }
+
+    // Resolves every jump and call to a label. All of them must be bound.
+    void finish() {
+        for (const Fixup& fixup : m_fixups) {
+            int32_t rel = static_cast<int32_t>(m_labels[fixup.label] - static_cast<int64_t>(fixup.offset + 4));
+            std::memcpy(&m_code[fixup.offset], &rel, sizeof(rel));
+        }
+        m_fixups.clear();
+    }
+
+    // Overwrites the imm32 at offset (as returned by subRsp).
+    void patch32(size_t offset, int32_t value) { std::memcpy(&m_code[offset], &value, sizeof(value)); }
+
+    // --- General registers ---
+    void push(Reg reg) { byte(0x50 + reg); }
+    void pop(Reg reg) { byte(0x58 + reg); }
+    void movRegReg(Reg dst, Reg src) { rexW(); byte(0x89); byte(0xC0 | (src << 3) | dst); }
+    void movImm64(Reg dst, uint64_t value) {
+        rexW();
+        byte(0xB8 + dst);
+        bytes(&value, sizeof(value));
+    }
+    void movLoad(Reg dst, Reg base, int32_t disp) { rexW(); byte(0x8B); mem(dst, base, disp); }
+    void movStore(Reg base, int32_t disp, Reg src) { rexW(); byte(0x89); mem(src, base, disp); }
+    // Returns the offset of the imm32, for patch32.
+    size_t subRsp(int32_t amount) {
+        rexW();
+        byte(0x81);
+        byte(0xEC);
+        size_t offset = m_code.size();
+        bytes(&amount, sizeof(amount));
+        return offset;
+    }
+    void addRsp(int32_t amount) {
+        rexW();
+        byte(0x81);
+        byte(0xC4);
+        bytes(&amount, sizeof(amount));
+    }
+    void xorEax() { byte(0x31); byte(0xC0); }
+    void movEax(uint32_t value) { byte(0xB8); bytes(&value, sizeof(value)); }
+    void testEax() { byte(0x85); byte(0xC0); }
+    // inc, dec and cmp of the qword at [base] ([base + disp] for inc)
+    void incMem(Reg base, int32_t disp = 0) { rexW(); byte(0xFF); mem(0, base, disp); }
+    void decMem(Reg base) { rexW(); byte(0xFF); mem(1, base, 0); }
+    void cmpMem(Reg base, int32_t value) { rexW(); byte(0x81); mem(7, base, 0); bytes(&value, sizeof(value)); }
+
+    // --- SSE2 scalar doubles ---
+    void movsdLoad(Xmm dst, Reg base, int32_t disp) { sse(0xF2, 0x10, dst); mem(dst, base, disp); }
+    void movsdStore(Reg base, int32_t disp, Xmm src) { sse(0xF2, 0x11, src); mem(src, base, disp); }
+    void movupdLoad(Xmm dst, Reg base, int32_t disp) { sse(0x66, 0x10, dst); mem(dst, base, disp); }
+    void movupdStore(Reg base, int32_t disp, Xmm src) { sse(0x66, 0x11, src); mem(src, base, disp); }
+    void movqFromReg(Xmm dst, Reg src) {
+        byte(0x66);
+        byte(0x48 | (dst >> 3) << 2);
+        byte(0x0F);
+        byte(0x6E);
+        byte(0xC0 | (dst & 7) << 3 | src);
+    }
+    void addsd(Xmm dst, Xmm src) { sseRR(0xF2, 0x58, dst, src); }
+    void mulsd(Xmm dst, Xmm src) { sseRR(0xF2, 0x59, dst, src); }
+    void subsd(Xmm dst, Xmm src) { sseRR(0xF2, 0x5C, dst, src); }
+    void divsd(Xmm dst, Xmm src) { sseRR(0xF2, 0x5E, dst, src); }
+    void movapd(Xmm dst, Xmm src) { sseRR(0x66, 0x28, dst, src); }
+    void andpd(Xmm dst, Xmm src) { sseRR(0x66, 0x54, dst, src); }
+    void andnpd(Xmm dst, Xmm src) { sseRR(0x66, 0x55, dst, src); }
+    void orpd(Xmm dst, Xmm src) { sseRR(0x66, 0x56, dst, src); }
+    void xorpd(Xmm dst, Xmm src) { sseRR(0x66, 0x57, dst, src); }
+    void ucomisd(Xmm a, Xmm b) { sseRR(0x66, 0x2E, a, b); }
+    void cmpsd(Xmm dst, Xmm src, Compare predicate) {
+        sseRR(0xF2, 0xC2, dst, src);
+        byte(predicate);
+    }
+
+    // --- Control flow ---
+    void jmp(Label target) { byte(0xE9); fixup(target); }
+    void jcc(Cond cond, Label target) { byte(0x0F); byte(0x80 | cond); fixup(target); }
+    void call(Label target) { byte(0xE8); fixup(target); }
+    void callReg(Reg target) { byte(0xFF); byte(0xD0 | target); }
+    void leave() { byte(0xC9); }
+    void ret() { byte(0xC3); }
+
+private:
+    struct Fixup {
+        size_t offset;  // of the rel32
+        Label label;
+    };
+    std::vector<uint8_t> m_code;
+    std::vector<int64_t> m_labels;  // code offset, or -1 while unbound
+    std::vector<Fixup> m_fixups;
+
+    void byte(uint8_t value) { m_code.push_back(value); }
+    void bytes(const void* data, size_t count) {
+        const uint8_t* first = static_cast<const uint8_t*>(data);
+        m_code.insert(m_code.end(), first, first + count);
+    }
+    void rexW() { byte(0x48); }
+    // Prefix, REX for xmm8-xmm15 (r in the reg field, b in r/m), opcode
+    void sse(uint8_t prefix, uint8_t opcode, uint8_t r, uint8_t b = 0) {
+        byte(prefix);
+        if (r >= 8 || b >= 8) byte(0x40 | (r >> 3) << 2 | b >> 3);
+        byte(0x0F);
+        byte(opcode);
+    }
+    void sseRR(uint8_t prefix, uint8_t opcode, uint8_t dst, uint8_t src) {
+        sse(prefix, opcode, dst, src);
+        byte(0xC0 | (dst & 7) << 3 | (src & 7));
+    }
+    // ModRM (and SIB for rsp) for [base + disp], with reg in the reg field
+    void mem(uint8_t reg, Reg base, int32_t disp) {
+        uint8_t mod = disp == 0 && base != RBP ? 0 : disp >= -128 && disp <= 127 ? 1 : 2;
+        byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | base));
+        if (base == RSP) byte(0x24);
+        if (mod == 1) byte(static_cast<uint8_t>(static_cast<int8_t>(disp)));
+        if (mod == 2) bytes(&disp, sizeof(disp));
+    }
+    void fixup(Label target) {
+        m_fixups.push_back({m_code.size(), target});
+        int32_t placeholder = 0;
+        bytes(&placeholder, sizeof(placeholder));
+    }
+};
+
+#endif // X86_ASSEMBLER_H
@@ -0,0 +1,76 @@
+#ifndef ARRAY_OBJECT_H
+#define ARRAY_OBJECT_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "objects/IteratorObject.h"
+#include "objects/Object.h"
+#include "objects/Value.h"
+
+// A 1-D or 2-D array of numbers: a view of a contiguous buffer of doubles,
+// with a shape and a stride (in elements) per dimension. Arrays are never
+// modified once built, so a row or a transpose is a view that shares the
+// buffer of the array it comes from; only arrays made by array(), zeros()
+// or an operation own a fresh, row-major buffer.
+class ArrayObject : public Object {
+public:
+    using Buffer = std::vector<double>;
+
+    // A row-major rows x cols array over buffer, which holds rows * cols
+    // numbers.
+    ArrayObject(std::shared_ptr<const Buffer> buffer, size_t rows, size_t cols);
+    // A 1-D array over all of buffer.
+    explicit ArrayObject(std::shared_ptr<const Buffer> buffer);
+    // A view of buffer starting at data.
+    ArrayObject(std::shared_ptr<const Buffer> buffer, const double* data, int dims, const size_t shape[2],
+                const std::ptrdiff_t strides[2]);
+    std::string type_name() const override;
+    std::shared_ptr<IteratorObject> iter() const;
+
+    int dims() const { return m_dims; }
+    size_t rows() const { return m_shape[0]; }
+    size_t cols() const { return m_shape[1]; }  // 1 for a 1-D array
+    size_t size() const { return m_shape[0] * m_shape[1]; }
+    const std::ptrdiff_t* strides() const { return m_strides; }
+    const double* data() const { return m_data; }
+
+    // Laid out row-major without gaps, as data() .. data() + size().
+    bool contiguous() const {
+        if (m_dims == 1) return m_strides[0] == 1;
+        return m_strides[1] == 1 && m_strides[0] == static_cast<std::ptrdiff_t>(m_shape[1]);
+    }
+
+    double at(size_t i) const { return m_data[static_cast<std::ptrdiff_t>(i) * m_strides[0]]; }
+    double at(size_t i, size_t j) const {
+        return m_data[static_cast<std::ptrdiff_t>(i) * m_strides[0] + static_cast<std::ptrdiff_t>(j) * m_strides[1]];
+    }
+
+    // Element i of a 1-D array, or a view of row i of a 2-D one.
+    Value item(size_t i) const;
+    // Swaps the dimensions of a 2-D array; a 1-D array is its own transpose.
+    std::shared_ptr<ArrayObject> transposed() const;
+    // The elements in row-major order: the buffer itself when contiguous,
+    // otherwise a copy in scratch.
+    const double* rowMajor(Buffer& scratch) const;
+
+private:
+    std::shared_ptr<const Buffer> m_buffer;
+    const double* m_data;
+    int m_dims;
+    size_t m_shape[2];
+    std::ptrdiff_t m_strides[2];
+};
+
+// Rows of a 2-D array, or elements of a 1-D one.
+class ArrayIterator : public IteratorObject {
+    const ArrayObject& array;
+    size_t index;
+public:
+    ArrayIterator(const ArrayObject& array);
+    bool has_next() const override;
+    Value next() override;
+    std::string type_name() const override;
+};
+
+#endif // ARRAY_OBJECT_H
@@ -7,9 +7,14 @@
 #include <vector>
 #include "core/AST.h"
 #include "core/Environment.h"
+#include "core/MemoTable.h"
 #include "objects/Object.h"
+#include "objects/Value.h"
 
-using BuiltinFunction = std::function<ObjectPtr(const std::vector<ObjectPtr>&)>;
+struct FunctionProto;
+struct CompiledFunction;
+
+using BuiltinFunction = std::function<Value(const std::vector<Value>&)>;
 
 class FunctionObject : public Object {
 public:
@@ -26,9 +31,11 @@ private:
     std::string builtin_name;
     
     // For user-defined functions
-    std::vector<std::string> parameters;
-    std::vector<const Stmt*> body;  // Raw pointers since AST outlives functions
+    const FunctionDecl* decl = nullptr;  // Parameters, slots and body; owned by the Ast
     std::shared_ptr<Environment> closure;
+    const FunctionProto* proto = nullptr;  // Bytecode, when created by the VM
+    const CompiledFunction* compiled = nullptr;  // Closure tree, when created by ClosureCompiler
+    std::shared_ptr<MemoTable> memo;  // Result cache, when memoized
 
 public:
     // Constructor for built-in functions
@@ -36,24 +43,34 @@ public:
         : type(FunctionType::BUILTIN), builtin_func(func), builtin_name(name) {}
     
     // Constructor for user-defined functions
-    FunctionObject(const std::vector<std::string>& params,
-                   std::vector<const Stmt*> func_body,
-                   std::shared_ptr<Environment> env)
-        : type(FunctionType::USER_DEFINED), parameters(params), 
-          body(func_body), closure(env) {}
+    FunctionObject(const FunctionDecl& declaration,
+                   std::shared_ptr<Environment> env,
+                   const FunctionProto* code = nullptr,
+                   const CompiledFunction* compiled_body = nullptr)
+        : type(FunctionType::USER_DEFINED), decl(&declaration),
+          closure(env), proto(code), compiled(compiled_body) {
+        if (declaration.memoCapacity) memo = std::make_shared<MemoTable>(declaration.memoCapacity);
+    }
     
     std::string type_name() const override;
     
     FunctionType get_type() const { return type; }
     
     // For built-in functions
-    BuiltinFunction get_builtin() const { return builtin_func; }
+    const BuiltinFunction& get_builtin() const { return builtin_func; }
     std::string get_builtin_name() const { return builtin_name; }
     
     // For user-defined functions
-    const std::vector<std::string>& get_parameters() const { return parameters; }
-    const std::vector<const Stmt*>& get_body() const { return body; }
-    std::shared_ptr<Environment> get_closure() const { return closure; }
+    const FunctionDecl& get_decl() const { return *decl; }
+    const std::vector<Symbol>& get_parameters() const { return decl->parameters; }
+    NodeList get_body() const { return decl->body; }
+    const std::shared_ptr<Environment>& get_closure() const { return closure; }
+    const std::vector<Symbol>& get_locals() const { return decl->locals; }
+    const FunctionProto* get_proto() const { return proto; }
+    const CompiledFunction* get_compiled() const { return compiled; }
+    MemoTable* get_memo() const { return memo.get(); }
+    const std::shared_ptr<MemoTable>& get_memo_table() const { return memo; }
+    void set_memo(std::shared_ptr<MemoTable> table) { memo = std::move(table); }
 };
 
 #endif // FUNCTION_OBJECT_H
@@ -2,11 +2,12 @@
 #define ITERATOR_OBJECT_H
 
 #include "objects/Object.h"
+#include "objects/Value.h"
 
 class IteratorObject : public Object {
 public:
     virtual bool has_next() const = 0;
-    virtual ObjectPtr next() = 0;
+    virtual Value next() = 0;
     std::string type_name() const override;
 }; 
 
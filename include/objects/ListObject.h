@@ -1,26 +1,48 @@
 #ifndef LIST_OBJECT_H
 #define LIST_OBJECT_H
 
+#include <cstddef>
 #include <vector>
 #include "objects/IteratorObject.h"
 #include "objects/Object.h"
+#include "objects/Value.h"
 
+// Lists are never modified once built. A list whose elements are all
+// numbers (the empty list included) is stored packed, as a vector of
+// doubles: half the size of a vector of Values, and what the reduction
+// builtins run their vector kernels on. An element is made into a Value
+// again only when it is read. Any other list holds its Values.
 class ListObject : public Object {
 public:
-    std::vector<ObjectPtr> items;
     ListObject();
-    ListObject(const std::vector<ObjectPtr>& items);
+    ListObject(std::vector<Value> items);
+    ListObject(std::vector<double> numbers);
     std::string type_name() const override;
     std::shared_ptr<IteratorObject> iter() const;
+
+    size_t size() const { return m_packed ? m_numbers.size() : m_items.size(); }
+    Value at(size_t index) const { return m_packed ? Value(m_numbers[index]) : m_items[index]; }
+
+    bool packed() const { return m_packed; }
+    // The elements of a packed list, and of any other list.
+    const std::vector<double>& numbers() const { return m_numbers; }
+    const std::vector<Value>& values() const { return m_items; }
+
+private:
+    bool m_packed = true;
+    std::vector<double> m_numbers;
+    std::vector<Value> m_items;
 };
 
 class ListIterator : public IteratorObject {
-    const std::vector<ObjectPtr>& items;
+    const double* numbers;  // set for a packed list
+    const Value* items;     // set for any other list
+    size_t size;
     size_t index;
 public:
-    ListIterator(const std::vector<ObjectPtr>& items);
+    ListIterator(const ListObject& list);
     bool has_next() const override;
-    ObjectPtr next() override;
+    Value next() override;
     std::string type_name() const override;
 };
 
@@ -0,0 +1,132 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Slab allocator for runtime objects and environments. Requests up to
+// kMaxPooledSize bytes are rounded up to a 16-byte size class and served
+// from a per-class free list refilled from 64 KiB slabs; larger requests go
+// to the global heap. Memory is returned to the slabs, never to the system,
+// until the pool is destroyed, so a pool must outlive every object
+// allocated from it.
+//
+// Building with INTERPRETER_USE_MALLOC sends every request to the global
+// heap while keeping the counters, for comparison.
+class ObjectPool {
+public:
+    struct Stats {
+        size_t allocations = 0;  // total served
+        size_t liveObjects = 0;
+        size_t liveBytes = 0;
+        size_t peakBytes = 0;
+    };
+
+    ObjectPool() = default;
+    ~ObjectPool();
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    void* allocate(size_t bytes) {
+        ++m_stats.allocations;
+        ++m_stats.liveObjects;
+        m_stats.liveBytes += bytes;
+        if (m_stats.liveBytes > m_stats.peakBytes) m_stats.peakBytes = m_stats.liveBytes;
+#ifndef INTERPRETER_USE_MALLOC
+        if (bytes <= kMaxPooledSize) {
+            FreeBlock*& head = m_freeLists[sizeClass(bytes)];
+            if (!head) refill(sizeClass(bytes));
+            FreeBlock* block = head;
+            head = block->next;
+            return block;
+        }
+#endif
+        return ::operator new(bytes);
+    }
+
+    void deallocate(void* ptr, size_t bytes) noexcept {
+        --m_stats.liveObjects;
+        m_stats.liveBytes -= bytes;
+#ifndef INTERPRETER_USE_MALLOC
+        if (bytes <= kMaxPooledSize) {
+            FreeBlock*& head = m_freeLists[sizeClass(bytes)];
+            head = new (ptr) FreeBlock{head};
+            return;
+        }
+#endif
+        ::operator delete(ptr);
+    }
+
+    const Stats& stats() const { return m_stats; }
+
+    // Pool used by makePooled on this thread, or nullptr for the global heap.
+    static ObjectPool* current() { return s_current; }
+
+    // Makes a pool current for the lifetime of the scope.
+    class Scope {
+    public:
+        explicit Scope(ObjectPool& pool) : m_previous(s_current) { s_current = &pool; }
+        ~Scope() { s_current = m_previous; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        ObjectPool* m_previous;
+    };
+
+private:
+    static constexpr size_t kGranularity = 16;
+    static constexpr size_t kMaxPooledSize = 256;
+    static constexpr size_t kSizeClasses = kMaxPooledSize / kGranularity;
+    static constexpr size_t kSlabSize = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static size_t sizeClass(size_t bytes) { return (bytes + kGranularity - 1) / kGranularity - 1; }
+    void refill(size_t sizeClass);
+
+    FreeBlock* m_freeLists[kSizeClasses] = {};
+    std::vector<void*> m_slabs;
+    Stats m_stats;
+
+    static thread_local ObjectPool* s_current;
+};
+
+// Standard allocator over an ObjectPool, for std::allocate_shared.
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(ObjectPool* pool) noexcept : m_pool(pool) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : m_pool(other.pool()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_pool->allocate(n * sizeof(T))); }
+    void deallocate(T* ptr, size_t n) noexcept { m_pool->deallocate(ptr, n * sizeof(T)); }
+    ObjectPool* pool() const noexcept { return m_pool; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return m_pool == other.pool(); }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept { return m_pool != other.pool(); }
+
+private:
+    ObjectPool* m_pool;
+};
+
+// Replacement for std::make_shared that places the object and its control
+// block in the current thread's pool.
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args&&... args) {
+    if (ObjectPool* pool = ObjectPool::current()) {
+        return std::allocate_shared<T>(PoolAllocator<T>(pool), std::forward<Args>(args)...);
+    }
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+#endif // OBJECT_POOL_H
@@ -13,13 +13,32 @@ public:
     std::shared_ptr<IteratorObject> iter() const;
 };
 
-class RangeIterator : public IteratorObject {
+// Steps through a range: start, start + step, ... while short of stop.
+// RangeIterator wraps one, and the engines run `for ... in range(...)` on
+// one directly, with no iterator object and no virtual calls per step.
+// Values are accumulated, not computed as start + k * step, so a float step
+// produces the same sequence either way.
+struct RangeCounter {
     double current, stop, step;
-    bool forward;
+
+    explicit RangeCounter(const RangeObject& range)
+        : current(range.start), stop(range.stop), step(range.step) {}
+    RangeCounter(double start, double stop, double step) : current(start), stop(stop), step(step) {}
+
+    bool has_next() const { return step > 0 ? current < stop : current > stop; }
+    double next() {
+        double value = current;
+        current += step;
+        return value;
+    }
+};
+
+class RangeIterator : public IteratorObject {
+    RangeCounter counter;
 public:
     RangeIterator(double start, double stop, double step);
     bool has_next() const override;
-    ObjectPtr next() override;
+    Value next() override;
     std::string type_name() const override;
 };
 
@@ -19,7 +19,7 @@ class StringIterator : public IteratorObject {
 public:
     StringIterator(const std::string& s);
     bool has_next() const override;
-    ObjectPtr next() override;
+    Value next() override;
     std::string type_name() const override;
 }; 
 
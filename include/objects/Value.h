@@ -0,0 +1,107 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include "objects/Object.h"
+
+// A runtime value: numbers are stored inline, everything else (strings,
+// lists, ranges, functions, iterators) is a reference-counted heap Object.
+// Booleans are numbers in this language (True == 1, False == 0), so they
+// are inline as well.
+class Value {
+public:
+    enum class Type : uint8_t {
+        Undefined,  // an unassigned local slot; never visible to scripts
+        Number,
+        Object
+    };
+
+    Value() : m_type(Type::Number), m_number(0.0) {}
+    Value(double number) : m_type(Type::Number), m_number(number) {}
+    Value(ObjectPtr object) : m_type(Type::Object) {
+        new (&m_object) ObjectPtr(std::move(object));
+    }
+    template <typename T, typename = std::enable_if_t<std::is_base_of<::Object, T>::value>>
+    Value(std::shared_ptr<T> object) : Value(ObjectPtr(std::move(object))) {}
+
+    Value(const Value& other) : m_type(other.m_type) {
+        if (m_type == Type::Object) new (&m_object) ObjectPtr(other.m_object);
+        else m_number = other.m_number;
+    }
+    Value(Value&& other) noexcept : m_type(other.m_type) {
+        if (m_type == Type::Object) new (&m_object) ObjectPtr(std::move(other.m_object));
+        else m_number = other.m_number;
+    }
+    Value& operator=(const Value& other) {
+        // Copy first: releasing our object may destroy the one other lives in
+        Value copy(other);
+        return *this = std::move(copy);
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this == &other) return *this;
+        if (other.m_type != Type::Object) {
+            double number = other.m_number;
+            if (m_type == Type::Object) m_object.~ObjectPtr();
+            m_type = other.m_type;
+            m_number = number;
+        } else if (m_type == Type::Object) {
+            m_object = std::move(other.m_object);
+        } else {
+            new (&m_object) ObjectPtr(std::move(other.m_object));
+            m_type = Type::Object;
+        }
+        return *this;
+    }
+    ~Value() {
+        if (m_type == Type::Object) m_object.~ObjectPtr();
+    }
+
+    static Value boolean(bool b) { return Value(b ? 1.0 : 0.0); }
+    static Value undefined() {
+        Value value;
+        value.m_type = Type::Undefined;
+        return value;
+    }
+
+    Type type() const { return m_type; }
+    bool is_number() const { return m_type == Type::Number; }
+    bool is_object() const { return m_type == Type::Object; }
+    bool is_undefined() const { return m_type == Type::Undefined; }
+
+    double as_number() const { return m_number; }
+    const ObjectPtr& as_object() const { return m_object; }
+
+    // Returns the heap object as T, or nullptr when the value is a number
+    // or an object of another type.
+    template <typename T>
+    T* as() const {
+        return m_type == Type::Object ? dynamic_cast<T*>(m_object.get()) : nullptr;
+    }
+
+    // Same as as<T>, for an object of exactly type T and not of a subclass.
+    // A compare of the dynamic type instead of a dynamic_cast, for guards.
+    template <typename T>
+    T* as_exact() const {
+        return m_type == Type::Object && typeid(*m_object) == typeid(T) ? static_cast<T*>(m_object.get())
+                                                                         : nullptr;
+    }
+
+    std::string type_name() const {
+        return m_type == Type::Object ? m_object->type_name() : "number";
+    }
+
+private:
+    Type m_type;
+    union {
+        double m_number;
+        ObjectPtr m_object;
+    };
+};
+
+#endif // VALUE_H
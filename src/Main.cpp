@@ -1,63 +1,208 @@
 ﻿#include <chrono>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
+#include "core/ASTPrinter.h"
+#include "core/AstCache.h"
+#include "core/ClosureCompiler.h"
+#include "core/Compiler.h"
+#include "core/InlineCache.h"
 #include "core/Interpreter.h"
+#include "core/Jit.h"
+#include "core/MemoTable.h"
+#include "core/Optimizer.h"
 #include "core/Parser.h"
+#include "core/Quickening.h"
+#include "core/PurityAnalyzer.h"
+#include "core/Resolver.h"
+#include "core/SourceFile.h"
+#include "core/Symbol.h"
 #include "core/Tokenizer.h"
 #include "core/Token.h"
+#include "core/Tracer.h"
+#include "core/VM.h"
+#include "objects/ObjectPool.h"
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename> [--timing]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <filename> [--timing] [--engine=vm|tree|closure] [--opt-level=0|1|2] [--dump-ast] [--stats] [--lex-threads=N] [--cache=on|off|refresh] [--cache-dir=DIR] [--auto-memo] [--memo-size=N] [--jit] [--trace-jit]" << std::endl;
         return 1;
     }
     std::string filename = argv[1];
     bool timing = false;
+    bool dumpAst = false;
+    bool stats = false;
+    std::string engine = "vm";
+    std::string optLevel = "1";
+    std::string lexThreads = "1";
+    std::string cacheMode = "on";
+    std::string cacheDir;
+    bool autoMemo = false;
+    bool jit = false;
+    bool traceJit = false;
+    std::string memoSize = std::to_string(MemoTable::kDefaultCapacity);
     for (int i = 2; i < argc; ++i) {
-        if (std::string(argv[i]) == "--timing") timing = true;
+        std::string arg = argv[i];
+        if (arg == "--timing") timing = true;
+        else if (arg == "--dump-ast") dumpAst = true;
+        else if (arg == "--stats") stats = true;
+        else if (arg.rfind("--engine=", 0) == 0) engine = arg.substr(9);
+        else if (arg.rfind("--opt-level=", 0) == 0) optLevel = arg.substr(12);
+        else if (arg.rfind("--lex-threads=", 0) == 0) lexThreads = arg.substr(14);
+        else if (arg.rfind("--cache=", 0) == 0) cacheMode = arg.substr(8);
+        else if (arg.rfind("--cache-dir=", 0) == 0) cacheDir = arg.substr(12);
+        else if (arg == "--auto-memo") autoMemo = true;
+        else if (arg.rfind("--memo-size=", 0) == 0) memoSize = arg.substr(12);
+        else if (arg == "--jit") jit = true;
+        else if (arg == "--trace-jit") traceJit = true;
+    }
+    if (engine != "vm" && engine != "tree" && engine != "closure") {
+        std::cerr << "Unknown engine: " << engine << " (expected vm, tree or closure)" << std::endl;
+        return 1;
+    }
+    if (optLevel != "0" && optLevel != "1" && optLevel != "2") {
+        std::cerr << "Unknown optimization level: " << optLevel << " (expected 0, 1 or 2)" << std::endl;
+        return 1;
+    }
+    if (lexThreads.empty() || lexThreads.size() > 4 || lexThreads.find_first_not_of("0123456789") != std::string::npos) {
+        std::cerr << "Invalid thread count: " << lexThreads << " (expected a number, 0 for one per core)" << std::endl;
+        return 1;
+    }
+    if (cacheMode != "on" && cacheMode != "off" && cacheMode != "refresh") {
+        std::cerr << "Unknown cache mode: " << cacheMode << " (expected on, off or refresh)" << std::endl;
+        return 1;
+    }
+    if (memoSize.empty() || memoSize.size() > 9 || memoSize.find_first_not_of("0123456789") != std::string::npos ||
+        std::stoul(memoSize) == 0) {
+        std::cerr << "Invalid memo size: " << memoSize << " (expected a number of at least 1)" << std::endl;
+        return 1;
     }
 
-    std::ifstream file(filename);
-    if (!file) {
+    SourceFile source;
+    if (!source.open(filename)) {
         std::cerr << "Could not open " << filename << std::endl;
         return 1;
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string code = buffer.str();
+
+    // Every runtime object and environment of this run comes from the pool,
+    // which is declared first so that it is destroyed last.
+    ObjectPool pool;
+    ObjectPool::Scope poolScope(pool);
 
     try {
         using clock = std::chrono::high_resolution_clock;
         auto t0 = clock::now();
 
-        // Tokenize
-        Tokenizer tokenizer(code);
-        std::vector<Token> tokens;
-        while (true) {
-            Token token = tokenizer.nextToken();
-            tokens.push_back(token);
-            if (token.type == TokenType::EndOfInput) break;
+        // A cached AST of the same source replaces the whole front end
+        Ast ast;
+        std::unique_ptr<AstCache> cache;
+        const char* cacheResult = "off";
+        if (cacheMode != "off") cache = std::make_unique<AstCache>(filename, source.text(), optLevel[0] - '0', cacheDir);
+        if (cacheMode == "on" && cache->load(ast)) {
+            cacheResult = "hit";
+        } else {
+            // Tokenize and parse in one pass: the parser pulls tokens on demand,
+            // unless the source is lexed up front on several threads
+            Tokenizer tokenizer(source.text());
+            if (lexThreads != "1") tokenizer.lexInParallel(static_cast<unsigned>(std::stoul(lexThreads)));
+            Parser parser(tokenizer);
+            ast = parser.parse();
+
+            // Fold constants and prune dead code
+            Optimizer optimizer(optLevel[0] - '0');
+            optimizer.optimize(ast);
+
+            // Resolve variables to frame slots
+            Resolver resolver;
+            resolver.resolve(ast);
+
+            if (cache) cacheResult = cache->store(ast) ? "written" : "not writable";
+        }
+
+        // Pick pure recursive functions to memoize (not part of the cache)
+        if (autoMemo) PurityAnalyzer(static_cast<uint32_t>(std::stoul(memoSize))).analyze(ast);
+
+        if (dumpAst) {
+            printAst(ast, std::cout);
+            return 0;
+        }
+
+        // Compile number-only functions and top-level loops to machine code
+        // (not part of the cache); the engines run them where they can
+        Jit nativeCode;
+        if (jit) {
+            if (Jit::available()) nativeCode.compile(ast);
+            else std::cerr << "Warning: --jit is not supported on this platform, running without it" << std::endl;
+        }
+        // Let the engines trace the hot loops --jit did not take
+        Tracer tracer;
+        if (traceJit) {
+            if (Tracer::available()) tracer.attach(ast);
+            else std::cerr << "Warning: --trace-jit is not supported on this platform, running without it" << std::endl;
+        }
+        // Compile to bytecode or to a closure tree
+        std::unique_ptr<Program> program;
+        ClosureCompiler closureCompiler;
+        ClosureCompiler::StmtFn closureProgram;
+        if (engine == "vm") {
+            Compiler compiler;
+            program = compiler.compile(ast);
+        } else if (engine == "closure") {
+            closureProgram = closureCompiler.compile(ast);
         }
-        
-        // Parse
-        Parser parser(tokens);
-        auto statements = parser.parse();
         auto t1 = clock::now();
 
         // Interpret
-        Interpreter interpreter;
-        interpreter.run(statements);
+        if (engine == "vm") {
+            VM vm;
+            vm.run(*program);
+        } else if (engine == "closure") {
+            closureCompiler.run(closureProgram);
+        } else {
+            Interpreter interpreter;
+            interpreter.run(ast);
+        }
         auto t2 = clock::now();
 
         if (timing) {
             auto compile_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
             auto interpret_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
             std::cout << "\n[Compilation time]: " << compile_ms << " ms\n";
+            std::cout << "[AST cache]: " << cacheResult << "\n";
             std::cout << "[Interpretation time]: " << interpret_ms << " ms\n";
         }
+        if (stats) {
+            const ObjectPool::Stats& objects = pool.stats();
+#ifdef INTERPRETER_USE_MALLOC
+            std::cout << "\n[Allocator]: malloc\n";
+#else
+            std::cout << "\n[Allocator]: pool\n";
+#endif
+            std::cout << "[Allocations]: " << objects.allocations << "\n";
+            std::cout << "[Peak bytes]: " << objects.peakBytes << "\n";
+            std::cout << "[Live at exit]: " << objects.liveObjects << " objects, " << objects.liveBytes << " bytes\n";
+            std::cout << "[Symbols]: " << Symbol::count() << "\n";
+            const InlineCacheStats& caches = inlineCacheStats();
+            std::cout << "[Global read cache]: " << caches.globalHits << " hits, " << caches.globalMisses << " misses\n";
+            std::cout << "[Call site cache]: " << caches.callHits << " hits, " << caches.callMisses << " misses\n";
+            const QuickStats& quick = quickStats();
+            std::cout << "[Quickening]: " << quick.quickened << " sites specialized, " << quick.deoptimized
+                      << " deopts, " << quick.generic << " left generic\n";
+            const MemoStats& memo = memoStats();
+            std::cout << "[Memo]: " << memo.hits << " hits, " << memo.misses << " misses, " << memo.evictions << " evictions\n";
+            const JitStats& native = jitStats();
+            std::cout << "[JIT]: " << native.functions << " functions, " << native.loops << " loops, "
+                      << native.codeBytes << " bytes; " << native.nativeCalls << " native calls, "
+                      << native.loopRuns << " native loop runs, " << native.fallbacks << " fallbacks\n";
+            const TraceStats& traces = traceStats();
+            std::cout << "[Trace JIT]: " << traces.compiled << " traces, " << traces.codeBytes << " bytes, "
+                      << traces.aborted << " aborted, " << traces.blacklisted << " blacklisted; "
+                      << traces.entered << " entered, " << traces.finished << " finished, "
+                      << traces.sideExits << " side exits, " << traces.merged << " branches merged, "
+                      << traces.declined << " declined, "
+                      << traces.iterations << " native iterations; " << traces.guardsEliminated << " of "
+                      << traces.guards << " guards eliminated\n";
+        }
         std::cout << "\n[Program finished successfully]" << std::endl;
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << std::endl;
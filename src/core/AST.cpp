@@ -0,0 +1,35 @@
+#include <limits>
+#include <stdexcept>
+#include "core/AST.h"
+
+template <typename T>
+static uint32_t checkedSize(const std::vector<T>& items) {
+    if (items.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Program too large");
+    }
+    return static_cast<uint32_t>(items.size());
+}
+
+NodeIndex Ast::addExpr(const Expr& expr) {
+    NodeIndex index = checkedSize(expressions);
+    expressions.push_back(expr);
+    return index;
+}
+
+NodeIndex Ast::addStmt(const Stmt& stmt) {
+    NodeIndex index = checkedSize(statements);
+    statements.push_back(stmt);
+    return index;
+}
+
+NodeList Ast::addExpressionList(const std::vector<NodeIndex>& items) {
+    NodeList list{checkedSize(expressionLists), static_cast<uint32_t>(items.size())};
+    expressionLists.insert(expressionLists.end(), items.begin(), items.end());
+    return list;
+}
+
+NodeList Ast::addStatementList(const std::vector<NodeIndex>& items) {
+    NodeList list{checkedSize(statementLists), static_cast<uint32_t>(items.size())};
+    statementLists.insert(statementLists.end(), items.begin(), items.end());
+    return list;
+}
@@ -0,0 +1,127 @@
+#include <stdexcept>
+#include <string>
+#include "core/ASTPrinter.h"
+
+static void printStmt(const Ast& ast, NodeIndex index, std::ostream& out, int depth);
+static void printExpr(const Ast& ast, NodeIndex index, std::ostream& out, int depth);
+
+static std::ostream& indent(std::ostream& out, int depth) {
+    return out << std::string(depth * 2, ' ');
+}
+
+static std::string bindingText(const Binding& binding) {
+    if (binding.is_global()) return "[global]";
+    return "[local " + std::to_string(binding.depth) + ":" + std::to_string(binding.slot) + "]";
+}
+
+static void printBlock(const Ast& ast, const char* label, NodeList statements, std::ostream& out, int depth) {
+    indent(out, depth) << label << "\n";
+    for (NodeIndex stmt : ast.statementList(statements)) printStmt(ast, stmt, out, depth + 1);
+}
+
+static void printStmt(const Ast& ast, NodeIndex index, std::ostream& out, int depth) {
+    const Stmt& s = ast.stmt(index);
+    switch (s.kind) {
+    case StmtKind::Expression:
+        indent(out, depth) << "Expression\n";
+        printExpr(ast, s.expr, out, depth + 1);
+        break;
+    case StmtKind::Assign:
+        indent(out, depth) << "Assign " << s.name.text() << " " << bindingText(s.binding) << "\n";
+        printExpr(ast, s.expr, out, depth + 1);
+        break;
+    case StmtKind::If:
+        indent(out, depth) << "If\n";
+        printExpr(ast, s.expr, out, depth + 1);
+        printBlock(ast, "Then", s.body, out, depth + 1);
+        if (!s.orelse.empty()) printBlock(ast, "Else", s.orelse, out, depth + 1);
+        break;
+    case StmtKind::While:
+        indent(out, depth) << "While\n";
+        printExpr(ast, s.expr, out, depth + 1);
+        printBlock(ast, "Body", s.body, out, depth + 1);
+        break;
+    case StmtKind::For:
+        indent(out, depth) << "For " << s.name.text() << " " << bindingText(s.binding) << "\n";
+        printExpr(ast, s.expr, out, depth + 1);
+        printBlock(ast, "Body", s.body, out, depth + 1);
+        break;
+    case StmtKind::Block:
+        printBlock(ast, "Block", s.body, out, depth);
+        break;
+    case StmtKind::FunctionDef: {
+        const FunctionDecl& decl = ast.functions[s.function];
+        indent(out, depth) << "Def " << decl.name.text() << "(";
+        for (size_t i = 0; i < decl.parameters.size(); ++i) {
+            out << (i ? ", " : "") << decl.parameters[i].text();
+        }
+        out << ") " << bindingText(s.binding) << "\n";
+        printBlock(ast, "Body", decl.body, out, depth + 1);
+        break;
+    }
+    case StmtKind::Return:
+        indent(out, depth) << (s.tailCall ? "Return (tail call)\n" : "Return\n");
+        if (s.expr != kNoNode) printExpr(ast, s.expr, out, depth + 1);
+        break;
+    case StmtKind::Break:
+        indent(out, depth) << "Break\n";
+        break;
+    case StmtKind::Continue:
+        indent(out, depth) << "Continue\n";
+        break;
+    default:
+        throw std::runtime_error("Unknown statement type");
+    }
+}
+
+static void printExpr(const Ast& ast, NodeIndex index, std::ostream& out, int depth) {
+    const Expr& e = ast.expr(index);
+    switch (e.kind) {
+    case ExprKind::Number:
+        indent(out, depth) << "Number " << e.number << "\n";
+        break;
+    case ExprKind::String:
+        indent(out, depth) << "String \"" << e.name.text() << "\"\n";
+        break;
+    case ExprKind::Variable:
+        indent(out, depth) << "Variable " << e.name.text() << " " << bindingText(e.binding) << "\n";
+        break;
+    case ExprKind::Binary:
+        indent(out, depth) << "Binary " << operatorSymbol(e.op) << "\n";
+        printExpr(ast, e.left, out, depth + 1);
+        printExpr(ast, e.right, out, depth + 1);
+        break;
+    case ExprKind::Unary:
+        indent(out, depth) << "Unary " << operatorSymbol(e.op) << "\n";
+        printExpr(ast, e.left, out, depth + 1);
+        break;
+    case ExprKind::Assign:
+        indent(out, depth) << "AssignExpr " << e.name.text() << " " << bindingText(e.binding) << "\n";
+        printExpr(ast, e.left, out, depth + 1);
+        break;
+    case ExprKind::Call:
+        indent(out, depth) << "Call\n";
+        printExpr(ast, e.left, out, depth + 1);
+        for (NodeIndex arg : ast.expressionList(e.items)) printExpr(ast, arg, out, depth + 1);
+        break;
+    case ExprKind::MemberAccess:
+        indent(out, depth) << "Member " << e.name.text() << "\n";
+        printExpr(ast, e.left, out, depth + 1);
+        break;
+    case ExprKind::List:
+        indent(out, depth) << "List\n";
+        for (NodeIndex elem : ast.expressionList(e.items)) printExpr(ast, elem, out, depth + 1);
+        break;
+    case ExprKind::Index:
+        indent(out, depth) << "Index\n";
+        printExpr(ast, e.left, out, depth + 1);
+        printExpr(ast, e.right, out, depth + 1);
+        break;
+    default:
+        throw std::runtime_error("Unknown expression type");
+    }
+}
+
+void printAst(const Ast& ast, std::ostream& out) {
+    for (NodeIndex stmt : ast.statementList(ast.program)) printStmt(ast, stmt, out, 0);
+}
@@ -0,0 +1,460 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include "core/AstCache.h"
+#include "core/SourceFile.h"
+
+#ifndef INTERPRETER_VERSION
+#define INTERPRETER_VERSION "dev"
+#endif
+
+namespace fs = std::filesystem;
+
+// Bump whenever the records below, or the output of Optimizer or Resolver,
+// change.
+static constexpr uint32_t kFormatVersion = 3;
+static constexpr char kMagic[8] = {'G', 'R', 'M', 'A', 'S', 'T', '\r', '\n'};
+
+// File layout: Header, then the names (u32 length + bytes each), the
+// expression and statement records, the two list arrays, and the functions
+// (name, body, parameter and local counts, hasNestedFunctions, then their
+// name ids). Integers are in host byte order; a file from another byte
+// order fails the magic check.
+struct Header {
+    char magic[8];
+    uint32_t format;
+    uint32_t optLevel;
+    char version[16];
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint32_t names;
+    uint32_t expressions;
+    uint32_t statements;
+    uint32_t expressionLists;
+    uint32_t statementLists;
+    uint32_t functions;
+    NodeList program;
+};
+
+struct ExprRecord {
+    uint8_t kind;
+    uint8_t op;
+    uint16_t unused;
+    uint32_t name;
+    NodeIndex left;
+    NodeIndex right;
+    NodeList items;
+    int32_t depth;
+    int32_t slot;
+    double number;
+};
+
+struct StmtRecord {
+    uint8_t kind;
+    uint8_t tailCall;
+    uint8_t unused[2];
+    uint32_t name;
+    int32_t depth;
+    int32_t slot;
+    NodeIndex expr;
+    NodeList body;
+    NodeList orelse;
+    uint32_t function;
+};
+
+static_assert(std::is_trivially_copyable<Header>::value, "Header is copied as bytes");
+static_assert(sizeof(ExprRecord) == 40 && sizeof(StmtRecord) == 40, "Records should stay packed");
+
+// Not cryptographic: a cache built for different source text is only ever
+// picked up by accident, never by construction.
+static uint64_t hashBytes(std::string_view text) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ text.size();
+    size_t i = 0;
+    for (; i + 8 <= text.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, text.data() + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, text.data() + i, text.size() - i);
+    hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    return hash ^ (hash >> 29);
+}
+
+static void versionField(char (&field)[16]) {
+    std::memset(field, 0, sizeof(field));
+    std::strncpy(field, INTERPRETER_VERSION, sizeof(field) - 1);
+}
+
+AstCache::AstCache(const std::string& scriptPath, std::string_view source, int optLevel,
+                   const std::string& cacheDir)
+    : m_sourceHash(hashBytes(source)), m_sourceSize(source.size()), m_optLevel(optLevel) {
+    fs::path script(scriptPath);
+    std::string suffix = ".o" + std::to_string(optLevel) + ".grmc";
+    if (cacheDir.empty()) {
+        m_path = (script.parent_path() / "__grmcache__" / (script.stem().string() + suffix)).string();
+        return;
+    }
+    // One directory for every script: tell equal names apart by their path
+    std::error_code error;
+    fs::path absolute = fs::absolute(script, error);
+    char pathHash[17];
+    std::snprintf(pathHash, sizeof(pathHash), "%016llx",
+                  static_cast<unsigned long long>(hashBytes((error ? script : absolute).string())));
+    m_path = (fs::path(cacheDir) / (script.stem().string() + "-" + pathHash + suffix)).string();
+}
+
+// --- Writing ---
+// Copies the nodes reachable from the program and the functions into a new,
+// dense Ast, so the nodes the optimizer left behind are not written.
+class Compactor {
+public:
+    explicit Compactor(const Ast& in) : m_in(in) {}
+
+    Ast run() {
+        m_out.program = copyStatements(m_in.program);
+        m_out.functions = m_in.functions;  // indices stay valid for FunctionDef
+        for (FunctionDecl& function : m_out.functions) function.body = copyStatements(function.body);
+        return std::move(m_out);
+    }
+
+private:
+    const Ast& m_in;
+    Ast m_out;
+
+    NodeIndex copyExpr(NodeIndex index) {
+        if (index == kNoNode) return kNoNode;
+        const Expr& expr = m_in.expr(index);
+        NodeIndex copy = m_out.addExpr(expr);
+        NodeIndex left = copyExpr(expr.left);
+        NodeIndex right = copyExpr(expr.right);
+        NodeList items = copyExpressions(expr.items);
+        Expr& out = m_out.expr(copy);
+        out.left = left;
+        out.right = right;
+        out.items = items;
+        return copy;
+    }
+
+    NodeIndex copyStmt(NodeIndex index) {
+        if (index == kNoNode) return kNoNode;
+        const Stmt& stmt = m_in.stmt(index);
+        NodeIndex copy = m_out.addStmt(stmt);
+        NodeIndex expr = copyExpr(stmt.expr);
+        NodeList body = copyStatements(stmt.body);
+        NodeList orelse = copyStatements(stmt.orelse);
+        Stmt& out = m_out.stmt(copy);
+        out.expr = expr;
+        out.body = body;
+        out.orelse = orelse;
+        return copy;
+    }
+
+    NodeList copyExpressions(NodeList list) {
+        std::vector<NodeIndex> items;
+        items.reserve(list.count);
+        for (NodeIndex item : m_in.expressionList(list)) items.push_back(copyExpr(item));
+        return m_out.addExpressionList(items);
+    }
+
+    NodeList copyStatements(NodeList list) {
+        std::vector<NodeIndex> items;
+        items.reserve(list.count);
+        for (NodeIndex item : m_in.statementList(list)) items.push_back(copyStmt(item));
+        return m_out.addStatementList(items);
+    }
+};
+
+class Writer {
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "written as bytes");
+        m_bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    template <typename T>
+    void putArray(const std::vector<T>& items) {
+        m_bytes.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+    }
+    void putText(std::string_view text) { m_bytes += text; }
+    const std::string& bytes() const { return m_bytes; }
+
+private:
+    std::string m_bytes;
+};
+
+// Numbers the names the records use, in order of first use.
+class NameTable {
+public:
+    uint32_t id(Symbol name) {
+        auto [it, added] = m_ids.emplace(name, static_cast<uint32_t>(m_names.size()));
+        if (added) m_names.push_back(name);
+        return it->second;
+    }
+    uint32_t count() const { return static_cast<uint32_t>(m_names.size()); }
+    void write(Writer& out) const {
+        for (Symbol name : m_names) {
+            out.put(static_cast<uint32_t>(name.text().size()));
+            out.putText(name.text());
+        }
+    }
+
+private:
+    std::unordered_map<Symbol, uint32_t> m_ids;
+    std::vector<Symbol> m_names;
+};
+
+bool AstCache::store(const Ast& original) const {
+    Ast ast = Compactor(original).run();
+
+    // Records first, collecting the names they use
+    NameTable names;
+    Writer body;
+    std::vector<ExprRecord> expressions(ast.expressions.size());
+    std::vector<StmtRecord> statements(ast.statements.size());
+    for (size_t i = 0; i < ast.expressions.size(); ++i) {
+        const Expr& expr = ast.expressions[i];
+        ExprRecord& record = expressions[i];
+        record = ExprRecord{};
+        record.kind = static_cast<uint8_t>(expr.kind);
+        record.op = static_cast<uint8_t>(expr.op);
+        record.name = names.id(expr.name);
+        record.left = expr.left;
+        record.right = expr.right;
+        record.items = expr.items;
+        record.depth = expr.binding.depth;
+        record.slot = expr.binding.slot;
+        record.number = expr.number;
+    }
+    for (size_t i = 0; i < ast.statements.size(); ++i) {
+        const Stmt& stmt = ast.statements[i];
+        StmtRecord& record = statements[i];
+        record = StmtRecord{};
+        record.kind = static_cast<uint8_t>(stmt.kind);
+        record.tailCall = stmt.tailCall;
+        record.name = names.id(stmt.name);
+        record.depth = stmt.binding.depth;
+        record.slot = stmt.binding.slot;
+        record.expr = stmt.expr;
+        record.body = stmt.body;
+        record.orelse = stmt.orelse;
+        record.function = stmt.function;
+    }
+    body.putArray(expressions);
+    body.putArray(statements);
+    body.putArray(ast.expressionLists);
+    body.putArray(ast.statementLists);
+    for (const FunctionDecl& function : ast.functions) {
+        body.put(names.id(function.name));
+        body.put(function.body);
+        body.put(static_cast<uint32_t>(function.parameters.size()));
+        body.put(static_cast<uint32_t>(function.locals.size()));
+        body.put(static_cast<uint32_t>(function.hasNestedFunctions));
+        for (Symbol name : function.parameters) body.put(names.id(name));
+        for (Symbol name : function.locals) body.put(names.id(name));
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format = kFormatVersion;
+    header.optLevel = static_cast<uint32_t>(m_optLevel);
+    versionField(header.version);
+    header.sourceHash = m_sourceHash;
+    header.sourceSize = m_sourceSize;
+    header.names = names.count();
+    header.expressions = static_cast<uint32_t>(ast.expressions.size());
+    header.statements = static_cast<uint32_t>(ast.statements.size());
+    header.expressionLists = static_cast<uint32_t>(ast.expressionLists.size());
+    header.statementLists = static_cast<uint32_t>(ast.statementLists.size());
+    header.functions = static_cast<uint32_t>(ast.functions.size());
+    header.program = ast.program;
+
+    // Write a temporary file and rename it over the old one, so concurrent
+    // runs never see a partial cache
+    std::error_code error;
+    fs::path path(m_path);
+    fs::create_directories(path.parent_path(), error);
+    std::random_device random;
+    fs::path temporary = path;
+    temporary += ".tmp" + std::to_string(random());
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file) return false;
+        Writer head;
+        head.put(header);
+        names.write(head);
+        file.write(head.bytes().data(), static_cast<std::streamsize>(head.bytes().size()));
+        file.write(body.bytes().data(), static_cast<std::streamsize>(body.bytes().size()));
+        if (!file.flush()) {
+            file.close();
+            fs::remove(temporary, error);
+            return false;
+        }
+    }
+    fs::rename(temporary, path, error);
+    if (!error) return true;
+    fs::remove(temporary, error);
+    return false;
+}
+
+// --- Loading ---
+// Bounds-checked reads from the mapped file. Every failure is a cache miss.
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : m_pos(bytes.data()), m_end(bytes.data() + bytes.size()) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (static_cast<size_t>(m_end - m_pos) < sizeof(T)) return false;
+        std::memcpy(&value, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+    template <typename T>
+    bool getArray(std::vector<T>& items, uint32_t count) {
+        if (static_cast<size_t>(m_end - m_pos) / sizeof(T) < count) return false;
+        items.resize(count);
+        std::memcpy(items.data(), m_pos, count * sizeof(T));
+        m_pos += count * sizeof(T);
+        return true;
+    }
+    bool getText(std::string_view& text, uint32_t size) {
+        if (static_cast<size_t>(m_end - m_pos) < size) return false;
+        text = std::string_view(m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+};
+
+static bool validNode(NodeIndex index, size_t count) {
+    return index == kNoNode || index < count;
+}
+
+static bool validList(NodeList list, size_t count) {
+    return list.start <= count && list.count <= count - list.start;
+}
+
+bool AstCache::load(Ast& ast) const {
+    SourceFile file;
+    if (!file.open(m_path)) return false;
+    Reader reader(file.text());
+
+    Header header;
+    char version[16];
+    versionField(version);
+    if (!reader.get(header) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.format != kFormatVersion || header.optLevel != static_cast<uint32_t>(m_optLevel) ||
+        std::memcmp(header.version, version, sizeof(version)) != 0 || header.sourceHash != m_sourceHash ||
+        header.sourceSize != m_sourceSize) {
+        return false;
+    }
+
+    std::vector<Symbol> names;
+    names.reserve(header.names);
+    for (uint32_t i = 0; i < header.names; ++i) {
+        uint32_t size;
+        std::string_view text;
+        if (!reader.get(size) || !reader.getText(text, size)) return false;
+        names.push_back(Symbol::intern(text));
+    }
+    auto name = [&](uint32_t id, Symbol& out) {
+        if (id >= names.size()) return false;
+        out = names[id];
+        return true;
+    };
+    auto nameList = [&](uint32_t count, std::vector<Symbol>& out) {
+        out.resize(count);
+        for (Symbol& symbol : out) {
+            uint32_t id;
+            if (!reader.get(id) || !name(id, symbol)) return false;
+        }
+        return true;
+    };
+
+    Ast result;
+    std::vector<ExprRecord> expressions;
+    std::vector<StmtRecord> statements;
+    if (!reader.getArray(expressions, header.expressions) || !reader.getArray(statements, header.statements) ||
+        !reader.getArray(result.expressionLists, header.expressionLists) ||
+        !reader.getArray(result.statementLists, header.statementLists)) {
+        return false;
+    }
+    size_t exprCount = expressions.size();
+    size_t stmtCount = statements.size();
+    size_t exprListCount = result.expressionLists.size();
+    size_t stmtListCount = result.statementLists.size();
+    for (NodeIndex index : result.expressionLists) {
+        if (index >= exprCount) return false;
+    }
+    for (NodeIndex index : result.statementLists) {
+        if (index >= stmtCount) return false;
+    }
+
+    result.expressions.resize(exprCount, Expr{ExprKind::Number});
+    for (size_t i = 0; i < exprCount; ++i) {
+        const ExprRecord& record = expressions[i];
+        Expr& expr = result.expressions[i];
+        if (record.kind > static_cast<uint8_t>(ExprKind::MemberAccess) ||
+            record.op > static_cast<uint8_t>(TokenType::EndOfInput) || !name(record.name, expr.name) ||
+            !validNode(record.left, exprCount) || !validNode(record.right, exprCount) ||
+            !validList(record.items, exprListCount)) {
+            return false;
+        }
+        expr.kind = static_cast<ExprKind>(record.kind);
+        expr.op = static_cast<TokenType>(record.op);
+        expr.left = record.left;
+        expr.right = record.right;
+        expr.items = record.items;
+        expr.binding.depth = record.depth;
+        expr.binding.slot = record.slot;
+        expr.number = record.number;
+    }
+
+    result.statements.resize(stmtCount, Stmt{StmtKind::Expression});
+    for (size_t i = 0; i < stmtCount; ++i) {
+        const StmtRecord& record = statements[i];
+        Stmt& stmt = result.statements[i];
+        if (record.kind > static_cast<uint8_t>(StmtKind::Return) || !name(record.name, stmt.name) ||
+            !validNode(record.expr, exprCount) || !validList(record.body, stmtListCount) ||
+            !validList(record.orelse, stmtListCount) ||
+            (record.kind == static_cast<uint8_t>(StmtKind::FunctionDef) && record.function >= header.functions) ||
+            (record.tailCall && (record.kind != static_cast<uint8_t>(StmtKind::Return) || record.expr == kNoNode ||
+                                 result.expressions[record.expr].kind != ExprKind::Call))) {
+            return false;
+        }
+        stmt.kind = static_cast<StmtKind>(record.kind);
+        stmt.tailCall = record.tailCall != 0;
+        stmt.binding.depth = record.depth;
+        stmt.binding.slot = record.slot;
+        stmt.expr = record.expr;
+        stmt.body = record.body;
+        stmt.orelse = record.orelse;
+        stmt.function = record.function;
+    }
+
+    result.functions.resize(header.functions);
+    for (FunctionDecl& function : result.functions) {
+        uint32_t nameId, parameters, locals, nested;
+        if (!reader.get(nameId) || !name(nameId, function.name) || !reader.get(function.body) ||
+            !validList(function.body, stmtListCount) || !reader.get(parameters) || !reader.get(locals) ||
+            !reader.get(nested) || nested > 1 ||
+            !nameList(parameters, function.parameters) || !nameList(locals, function.locals)) {
+            return false;
+        }
+        function.hasNestedFunctions = nested != 0;
+    }
+    if (!validList(header.program, stmtListCount)) return false;
+    result.program = header.program;
+
+    ast = std::move(result);
+    return true;
+}
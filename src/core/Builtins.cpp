@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include "core/Builtins.h"
+#include "core/MemoTable.h"
+#include "core/NumericKernels.h"
+#include "core/Operations.h"
+#include "objects/ArrayObject.h"
+#include "objects/StringObject.h"
+#include "objects/ListObject.h"
+#include "objects/RangeObject.h"
+#include "objects/FunctionObject.h"
+#include "objects/ObjectPool.h"
+
+struct Numbers {
+    const double* data;
+    size_t size;
+};
+
+// The elements of fn()'s argument: a list of numbers, or an array in
+// row-major order (copied into scratch if it is a view with gaps).
+static Numbers numbersOf(const Value& arg, const char* fn, ArrayObject::Buffer& scratch) {
+    if (auto list = arg.as<ListObject>()) {
+        if (list->packed()) return {list->numbers().data(), list->size()};
+    } else if (auto array = arg.as<ArrayObject>()) {
+        return {array->rowMajor(scratch), array->size()};
+    }
+    throw std::runtime_error(std::string(fn) + "() expects a list of numbers or an array");
+}
+
+// Builtin fn(list) computed by reduce over the list's numbers; the list
+// must not be empty unless allowEmpty.
+template <typename Reduce>
+static BuiltinFunction reduction(const char* fn, bool allowEmpty, Reduce reduce) {
+    return [fn, allowEmpty, reduce](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) throw std::runtime_error(std::string(fn) + "() expects exactly 1 argument");
+        ArrayObject::Buffer scratch;
+        Numbers numbers = numbersOf(args[0], fn, scratch);
+        if (numbers.size == 0 && !allowEmpty) throw std::runtime_error(std::string(fn) + "() of an empty list");
+        return reduce(numbers.data, numbers.size);
+    };
+}
+
+static const ArrayObject& arrayArgument(const Value& arg, const char* fn) {
+    auto array = arg.as<ArrayObject>();
+    if (!array) throw std::runtime_error(std::string(fn) + "() expects an array");
+    return *array;
+}
+
+static size_t dimension(const Value& arg) {
+    if (!arg.is_number() || !(arg.as_number() >= 0) || arg.as_number() > 1e9) {
+        throw std::runtime_error("zeros() expects sizes from 0 to 1e9");
+    }
+    return static_cast<size_t>(arg.as_number());
+}
+
+// array(list): a 1-D array of a list of numbers or a range, or a 2-D one
+// of a list of rows, each a list of numbers or a 1-D array, all the same
+// length.
+static Value arrayOf(const Value& arg) {
+    if (arg.as<ArrayObject>()) return arg;
+    if (auto range = arg.as<RangeObject>()) {
+        auto buffer = std::make_shared<ArrayObject::Buffer>();
+        for (RangeCounter counter(*range); counter.has_next();) buffer->push_back(counter.next());
+        return makePooled<ArrayObject>(std::move(buffer));
+    }
+    auto list = arg.as<ListObject>();
+    if (!list) throw std::runtime_error("array() expects a list or a range");
+    if (list->packed()) return makePooled<ArrayObject>(std::make_shared<ArrayObject::Buffer>(list->numbers()));
+
+    size_t rows = list->size();
+    size_t cols = 0;
+    auto buffer = std::make_shared<ArrayObject::Buffer>();
+    ArrayObject::Buffer scratch;
+    for (size_t i = 0; i < rows; ++i) {
+        Value row = list->at(i);
+        auto array = row.as<ArrayObject>();
+        if (array && array->dims() != 1) throw std::runtime_error("array() rows must be lists of numbers or 1-D arrays");
+        Numbers numbers = numbersOf(row, "array", scratch);
+        if (i == 0) {
+            cols = numbers.size;
+            buffer->reserve(rows * cols);
+        } else if (numbers.size != cols) {
+            throw std::runtime_error("array() rows must all have the same length");
+        }
+        buffer->insert(buffer->end(), numbers.data, numbers.data + numbers.size);
+    }
+    return makePooled<ArrayObject>(std::move(buffer), rows, cols);
+}
+
+void registerBuiltins(Environment& env) {
+    auto print_func = [](const std::vector<Value>& args) -> Value {
+        bool first = true;
+        for (const auto& arg : args) {
+            if (!first) std::cout << " ";
+            first = false;
+            if (arg.is_number()) {
+                std::cout << arg.as_number();
+            } else if (auto str = arg.as<StringObject>()) {
+                std::cout << str->value;
+            } else {
+                std::cout << "<object>";
+            }
+        }
+        std::cout << std::endl;
+        return 0.0;
+    };
+    
+    auto range_func = [](const std::vector<Value>& args) -> Value {
+        size_t argc = args.size();
+        double start = 0, stop = 0, step = 1;
+        
+        if (argc == 1) {
+            if (args[0].is_number()) stop = args[0].as_number();
+            else throw std::runtime_error("range(stop) expects a number");
+        } else if (argc == 2) {
+            if (args[0].is_number()) start = args[0].as_number();
+            else throw std::runtime_error("range(start, stop) expects numbers");
+            if (args[1].is_number()) stop = args[1].as_number();
+            else throw std::runtime_error("range(start, stop) expects numbers");
+        } else if (argc == 3) {
+            if (args[0].is_number()) start = args[0].as_number();
+            else throw std::runtime_error("range(start, stop, step) expects numbers");
+            if (args[1].is_number()) stop = args[1].as_number();
+            else throw std::runtime_error("range(start, stop, step) expects numbers");
+            if (args[2].is_number()) step = args[2].as_number();
+            else throw std::runtime_error("range(start, stop, step) expects numbers");
+            if (step == 0) throw std::runtime_error("range() step argument must not be zero");
+        } else {
+            throw std::runtime_error("range() expects 1 to 3 arguments");
+        }
+        return makePooled<RangeObject>(start, stop, step);
+    };
+    
+    auto len_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) {
+            throw std::runtime_error("len() expects exactly 1 argument");
+        }
+        
+        if (auto str = args[0].as<StringObject>()) {
+            return static_cast<double>(str->value.length());
+        } else if (auto list = args[0].as<ListObject>()) {
+            return static_cast<double>(list->size());
+        } else if (auto array = args[0].as<ArrayObject>()) {
+            return static_cast<double>(array->rows());
+        } else {
+            throw std::runtime_error("len() expects a string, list or array");
+        }
+    };
+    
+    // memo(f) or memo(f, size): a copy of f that caches its results
+    auto memo_func = [](const std::vector<Value>& args) -> Value {
+        if (args.empty() || args.size() > 2) {
+            throw std::runtime_error("memo() expects 1 or 2 arguments");
+        }
+        auto function = args[0].as<FunctionObject>();
+        if (!function || function->get_type() != FunctionObject::FunctionType::USER_DEFINED) {
+            throw std::runtime_error("memo() expects a user-defined function");
+        }
+        size_t capacity = MemoTable::kDefaultCapacity;
+        if (args.size() == 2) {
+            if (!args[1].is_number() || !(args[1].as_number() >= 1)) {
+                throw std::runtime_error("memo() size must be a number of at least 1");
+            }
+            capacity = static_cast<size_t>(std::min(args[1].as_number(), 1e15));
+        }
+        auto memoized = makePooled<FunctionObject>(*function);
+        memoized->set_memo(std::make_shared<MemoTable>(capacity));
+        return memoized;
+    };
+    
+    // list(iterable): a list of the values iterable produces
+    auto list_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() > 1) throw std::runtime_error("list() expects at most 1 argument");
+        if (args.empty()) return makePooled<ListObject>();
+        if (args[0].as<ListObject>()) return args[0];
+        if (auto range = args[0].as<RangeObject>()) {
+            std::vector<double> numbers;
+            for (RangeCounter counter(*range); counter.has_next();) numbers.push_back(counter.next());
+            return makePooled<ListObject>(std::move(numbers));
+        }
+        std::vector<Value> items;
+        for (auto iterator = makeIterator(args[0]); iterator->has_next();) items.push_back(iterator->next());
+        return makePooled<ListObject>(std::move(items));
+    };
+
+    auto sum_func = reduction("sum", true, [](const double* p, size_t n) { return numericKernels().sum(p, n); });
+    auto min_func = reduction("min", false, [](const double* p, size_t n) { return numericKernels().min(p, n); });
+    auto max_func = reduction("max", false, [](const double* p, size_t n) { return numericKernels().max(p, n); });
+    auto mean_func = reduction("mean", false, [](const double* p, size_t n) {
+        return numericKernels().sum(p, n) / static_cast<double>(n);
+    });
+
+    auto dot_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() != 2) throw std::runtime_error("dot() expects exactly 2 arguments");
+        for (const Value& arg : args) {
+            auto array = arg.as<ArrayObject>();
+            if (array && array->dims() != 1) throw std::runtime_error("dot() expects lists or 1-D arrays");
+        }
+        ArrayObject::Buffer scratchA, scratchB;
+        Numbers a = numbersOf(args[0], "dot", scratchA);
+        Numbers b = numbersOf(args[1], "dot", scratchB);
+        if (a.size != b.size) throw std::runtime_error("dot() expects lists of the same length");
+        return numericKernels().dot(a.data, b.data, a.size);
+    };
+
+    auto array_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) throw std::runtime_error("array() expects exactly 1 argument");
+        return arrayOf(args[0]);
+    };
+
+    // zeros(n) or zeros(rows, cols)
+    auto zeros_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() == 1) {
+            return makePooled<ArrayObject>(std::make_shared<ArrayObject::Buffer>(dimension(args[0])));
+        }
+        if (args.size() != 2) throw std::runtime_error("zeros() expects 1 or 2 arguments");
+        size_t rows = dimension(args[0]);
+        size_t cols = dimension(args[1]);
+        if (cols != 0 && rows > static_cast<size_t>(1e9) / cols) {
+            throw std::runtime_error("zeros() expects sizes from 0 to 1e9");
+        }
+        return makePooled<ArrayObject>(std::make_shared<ArrayObject::Buffer>(rows * cols), rows, cols);
+    };
+
+    // transpose(a): a view of a with rows and columns swapped
+    auto transpose_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) throw std::runtime_error("transpose() expects exactly 1 argument");
+        return arrayArgument(args[0], "transpose").transposed();
+    };
+
+    auto matmul_func = [](const std::vector<Value>& args) -> Value {
+        if (args.size() != 2) throw std::runtime_error("matmul() expects exactly 2 arguments");
+        const ArrayObject& a = arrayArgument(args[0], "matmul");
+        const ArrayObject& b = arrayArgument(args[1], "matmul");
+        if (a.dims() != 2 || b.dims() != 2) throw std::runtime_error("matmul() expects 2-D arrays");
+        if (a.cols() != b.rows()) {
+            throw std::runtime_error("matmul() shapes do not match: " + std::to_string(a.rows()) + "x" +
+                                     std::to_string(a.cols()) + " and " + std::to_string(b.rows()) + "x" +
+                                     std::to_string(b.cols()));
+        }
+        ArrayObject::Buffer scratchA, scratchB;
+        const double* x = a.rowMajor(scratchA);
+        const double* y = b.rowMajor(scratchB);
+        auto result = std::make_shared<ArrayObject::Buffer>(a.rows() * b.cols());
+        numericKernels().matmul(x, y, result->data(), a.rows(), a.cols(), b.cols());
+        return makePooled<ArrayObject>(std::move(result), a.rows(), b.cols());
+    };
+
+    env.set(Symbol::intern("print"), makePooled<FunctionObject>("print", print_func));
+    env.set(Symbol::intern("range"), makePooled<FunctionObject>("range", range_func));
+    env.set(Symbol::intern("len"), makePooled<FunctionObject>("len", len_func));
+    env.set(Symbol::intern("memo"), makePooled<FunctionObject>("memo", memo_func));
+    env.set(Symbol::intern("list"), makePooled<FunctionObject>("list", list_func));
+    env.set(Symbol::intern("sum"), makePooled<FunctionObject>("sum", sum_func));
+    env.set(Symbol::intern("min"), makePooled<FunctionObject>("min", min_func));
+    env.set(Symbol::intern("max"), makePooled<FunctionObject>("max", max_func));
+    env.set(Symbol::intern("mean"), makePooled<FunctionObject>("mean", mean_func));
+    env.set(Symbol::intern("dot"), makePooled<FunctionObject>("dot", dot_func));
+    env.set(Symbol::intern("array"), makePooled<FunctionObject>("array", array_func));
+    env.set(Symbol::intern("zeros"), makePooled<FunctionObject>("zeros", zeros_func));
+    env.set(Symbol::intern("transpose"), makePooled<FunctionObject>("transpose", transpose_func));
+    env.set(Symbol::intern("matmul"), makePooled<FunctionObject>("matmul", matmul_func));
+}
+
+bool isPureBuiltin(const std::string& name) {
+    return name == "range" || name == "len" || name == "list" || name == "sum" || name == "min" ||
+           name == "max" || name == "mean" || name == "dot" || name == "array" || name == "zeros" ||
+           name == "transpose" || name == "matmul";
+}
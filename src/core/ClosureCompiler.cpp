@@ -0,0 +1,476 @@
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include "core/ClosureCompiler.h"
+#include "core/Builtins.h"
+#include "core/InlineCache.h"
+#include "core/Quickening.h"
+#include "core/Jit.h"
+#include "core/Tracer.h"
+#include "core/Operations.h"
+#include "objects/StringObject.h"
+#include "objects/ListObject.h"
+#include "objects/IteratorObject.h"
+#include "objects/RangeObject.h"
+#include "objects/FunctionObject.h"
+#include "objects/ObjectPool.h"
+
+using ExprFn = ClosureCompiler::ExprFn;
+using StmtFn = ClosureCompiler::StmtFn;
+
+// Numbers are computed inline by the operator's kernel; any other operand
+// types go through a quickened site (string concatenation) or the shared
+// runtime, so error messages match the other engines.
+template <TokenType Op>
+static ExprFn makeBinary(ExprFn left, ExprFn right) {
+    return [left = std::move(left), right = std::move(right), site = QuickSite()]() mutable -> Value {
+        Value a = left();
+        Value b = right();
+        if (a.is_number() && b.is_number()) return NumberKernel<Op>::apply(a.as_number(), b.as_number());
+        return site.binary(a, b, Op);
+    };
+}
+
+// Same as makeBinary for a right operand that is a number literal.
+template <TokenType Op>
+static ExprFn makeBinaryConstant(ExprFn left, double right) {
+    return [left = std::move(left), right]() -> Value {
+        Value a = left();
+        if (a.is_number()) return NumberKernel<Op>::apply(a.as_number(), right);
+        return evaluateBinaryOperation(a, right, Op);
+    };
+}
+
+struct BinaryFactory {
+    ExprFn (*general)(ExprFn, ExprFn);
+    ExprFn (*constant)(ExprFn, double);
+};
+
+template <TokenType Op>
+static constexpr BinaryFactory binaryFactory() {
+    return {&makeBinary<Op>, &makeBinaryConstant<Op>};
+}
+
+ClosureCompiler::ClosureCompiler() {
+    m_global_env = makePooled<Environment>();
+    m_current_env = m_global_env;
+    registerBuiltins(*m_global_env);
+}
+
+StmtFn ClosureCompiler::compile(const Ast& ast) {
+    m_ast = &ast;
+    return compileBlock(ast.program);
+}
+
+void ClosureCompiler::run(const StmtFn& program) {
+    checkEscapedCompletion(program(), false);
+}
+
+// --- Statements ---
+StmtFn ClosureCompiler::compileBlock(NodeList statements) {
+    std::vector<StmtFn> compiled;
+    compiled.reserve(statements.count);
+    for (NodeIndex stmt : m_ast->statementList(statements)) compiled.push_back(compileStmt(stmt));
+    if (compiled.size() == 1) return std::move(compiled.front());
+    return [compiled = std::move(compiled)]() {
+        for (const auto& stmt : compiled) {
+            Completion completion = stmt();
+            if (completion != Completion::Normal) return completion;
+        }
+        return Completion::Normal;
+    };
+}
+
+StmtFn ClosureCompiler::compileStmt(NodeIndex index) {
+    const Stmt& stmt = m_ast->stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression: {
+        ExprFn expr = compileExpr(stmt.expr);
+        return [expr = std::move(expr)]() {
+            expr();
+            return Completion::Normal;
+        };
+    }
+    case StmtKind::Assign:
+        return compileDefine(stmt.name, stmt.binding, compileExpr(stmt.expr));
+    case StmtKind::If: return compileIf(stmt);
+    case StmtKind::While: return compileLoop(stmt, compileWhile(stmt));
+    case StmtKind::For: return compileLoop(stmt, compileFor(stmt));
+    case StmtKind::Block: return compileBlock(stmt.body);
+    case StmtKind::FunctionDef: return compileFunctionDef(stmt);
+    case StmtKind::Return: return compileReturn(stmt);
+    case StmtKind::Break: return []() { return Completion::Break; };
+    case StmtKind::Continue: return []() { return Completion::Continue; };
+    }
+    throw std::runtime_error("Unknown statement type");
+}
+
+StmtFn ClosureCompiler::compileIf(const Stmt& stmt) {
+    ExprFn condition = compileExpr(stmt.expr);
+    StmtFn thenBranch = compileBlock(stmt.body);
+    if (stmt.orelse.empty()) {
+        return [condition = std::move(condition), thenBranch = std::move(thenBranch)]() {
+            if (isTruthy(condition())) return thenBranch();
+            return Completion::Normal;
+        };
+    }
+    StmtFn elseBranch = compileBlock(stmt.orelse);
+    return [condition = std::move(condition), thenBranch = std::move(thenBranch),
+            elseBranch = std::move(elseBranch)]() {
+        if (isTruthy(condition())) return thenBranch();
+        return elseBranch();
+    };
+}
+
+// A top-level loop with native code runs it when its globals are numbers.
+StmtFn ClosureCompiler::compileLoop(const Stmt& stmt, StmtFn loop) {
+    const JitLoop* native = stmt.jit;
+    if (!native) return loop;
+    return [this, native, loop = std::move(loop)]() {
+        return native->run(*m_global_env) ? Completion::Normal : loop();
+    };
+}
+
+StmtFn ClosureCompiler::compileWhile(const Stmt& stmt) {
+    ExprFn condition = compileExpr(stmt.expr);
+    StmtFn body = compileBlock(stmt.body);
+    TraceLoop* trace = stmt.trace;
+    return [this, condition = std::move(condition), body = std::move(body), trace]() {
+        while (true) {
+            if (trace && trace->tick() && trace->run(*m_global_env, *m_current_env, nullptr)) break;
+            if (!isTruthy(condition())) break;
+            Completion completion = body();
+            if (completion == Completion::Break) break;
+            if (completion == Completion::Return) return completion;
+        }
+        return Completion::Normal;
+    };
+}
+
+StmtFn ClosureCompiler::compileFor(const Stmt& stmt) {
+    ExprFn iterable = compileExpr(stmt.expr);
+    StmtFn body = compileBlock(stmt.body);
+    Symbol var = stmt.name;
+    Binding binding = stmt.binding;
+    TraceLoop* trace = stmt.trace;
+    return [this, iterable = std::move(iterable), body = std::move(body), var, binding, trace]() {
+        Value iterableValue = iterable();
+        if (auto range = iterableValue.as<RangeObject>()) {
+            // Counted loop: the variable is written straight into its slot
+            RangeCounter counter(*range);
+            GlobalNumberStore global;
+            while (true) {
+                if (trace && trace->tick() && trace->run(*m_global_env, *m_current_env, &counter)) break;
+                if (!counter.has_next()) break;
+                if (binding.is_global()) global.store(*m_global_env, var, counter.next());
+                else m_current_env->slot(binding.slot) = counter.next();
+                Completion completion = body();
+                if (completion == Completion::Break) break;
+                if (completion == Completion::Return) return completion;
+            }
+            return Completion::Normal;
+        }
+        std::shared_ptr<IteratorObject> iterator = makeIterator(iterableValue);
+        while (iterator->has_next()) {
+            if (binding.is_global()) m_global_env->set(var, iterator->next());
+            else m_current_env->slot(binding.slot) = iterator->next();
+            Completion completion = body();
+            if (completion == Completion::Break) break;
+            if (completion == Completion::Return) return completion;
+        }
+        return Completion::Normal;
+    };
+}
+
+StmtFn ClosureCompiler::compileFunctionDef(const Stmt& stmt) {
+    const FunctionDecl* decl = &m_ast->functions[stmt.function];
+    m_functions.push_back(std::make_unique<CompiledFunction>());
+    CompiledFunction* compiled = m_functions.back().get();
+    compiled->body = compileBlock(decl->body);
+
+    ExprFn make = [this, decl, compiled]() -> Value {
+        return makePooled<FunctionObject>(*decl, m_current_env, nullptr, compiled);
+    };
+    return compileDefine(decl->name, stmt.binding, std::move(make));
+}
+
+StmtFn ClosureCompiler::compileReturn(const Stmt& stmt) {
+    if (stmt.tailCall) return compileTailCall(m_ast->expr(stmt.expr));
+    if (stmt.expr == kNoNode) {
+        return [this]() {
+            m_return_value = 0.0; // Default return value
+            return Completion::Return;
+        };
+    }
+    ExprFn value = compileExpr(stmt.expr);
+    return [this, value = std::move(value)]() {
+        m_return_value = value();
+        return Completion::Return;
+    };
+}
+
+// A user function called in tail position is left in m_tail_function for
+// the enclosing callFunction to run in this call's place, so tail recursion
+// does not grow the C++ stack.
+StmtFn ClosureCompiler::compileTailCall(const Expr& call) {
+    ExprFn callee = compileExpr(call.left);
+    std::vector<ExprFn> arguments;
+    arguments.reserve(call.items.count);
+    for (NodeIndex arg : m_ast->expressionList(call.items)) arguments.push_back(compileExpr(arg));
+    return [this, callee = std::move(callee), arguments = std::move(arguments), cache = CallCache()]() mutable {
+        Value function = callee();
+        std::vector<Value> values;
+        values.reserve(arguments.size());
+        for (const auto& arg : arguments) values.push_back(arg());
+        FunctionObject* func = cache.resolve(function);
+        if (func && func->get_type() == FunctionObject::FunctionType::USER_DEFINED) {
+            m_tail_callee = std::move(function);
+            m_tail_function = func;
+            m_tail_arguments = std::move(values);
+        } else {
+            m_return_value = callFunction(func, values);
+        }
+        return Completion::Return;
+    };
+}
+
+StmtFn ClosureCompiler::compileDefine(Symbol name, const Binding& binding, ExprFn value) {
+    if (binding.is_global()) {
+        return [this, name, value = std::move(value)]() {
+            m_global_env->set(name, value());
+            return Completion::Normal;
+        };
+    }
+    int slot = binding.slot;
+    return [this, slot, value = std::move(value)]() {
+        m_current_env->slot(slot) = value();
+        return Completion::Normal;
+    };
+}
+
+// --- Expressions ---
+ExprFn ClosureCompiler::compileExpr(NodeIndex index) {
+    const Expr& e = m_ast->expr(index);
+    switch (e.kind) {
+    case ExprKind::Number: {
+        double value = e.number;
+        return [value]() -> Value { return value; };
+    }
+    case ExprKind::String: {
+        Symbol value = e.name;
+        return [value]() -> Value { return makePooled<StringObject>(value.text()); };
+    }
+    case ExprKind::Variable:
+        return compileVariable(e);
+    case ExprKind::Binary:
+        return compileBinary(e);
+    case ExprKind::Unary:
+        return compileUnary(e);
+    case ExprKind::Assign:
+        return compileAssign(e);
+    case ExprKind::Call:
+        return compileCall(e);
+    case ExprKind::MemberAccess: {
+        ExprFn object = compileExpr(e.left);
+        Symbol member = e.name;
+        return [object = std::move(object), member]() { return evaluateMemberAccess(object(), member.text()); };
+    }
+    case ExprKind::List: {
+        std::vector<ExprFn> elements;
+        elements.reserve(e.items.count);
+        for (NodeIndex elem : m_ast->expressionList(e.items)) elements.push_back(compileExpr(elem));
+        return [elements = std::move(elements)]() -> Value {
+            std::vector<Value> items;
+            items.reserve(elements.size());
+            for (const auto& elem : elements) items.push_back(elem());
+            return makePooled<ListObject>(std::move(items));
+        };
+    }
+    case ExprKind::Index: {
+        const Expr& inner = m_ast->expr(e.left);
+        if (inner.kind == ExprKind::Index) {
+            // a[i][j]: on a 2-D array, read the element without a row view
+            ExprFn collection = compileExpr(inner.left);
+            ExprFn row = compileExpr(inner.right);
+            ExprFn column = compileExpr(e.right);
+            return [collection = std::move(collection), row = std::move(row), column = std::move(column),
+                    rowSite = QuickSite(), site = QuickSite()]() mutable -> Value {
+                Value collectionValue = collection();
+                Value rowIndex = row();
+                size_t i;
+                if (const ArrayObject* matrix = matrixRow(collectionValue, rowIndex, i)) {
+                    return matrixElement(*matrix, i, column());
+                }
+                Value rowValue = rowSite.index(collectionValue, rowIndex);
+                return site.index(rowValue, column());
+            };
+        }
+        ExprFn collection = compileExpr(e.left);
+        ExprFn index = compileExpr(e.right);
+        return [collection = std::move(collection), index = std::move(index), site = QuickSite()]() mutable {
+            Value collectionValue = collection();
+            return site.index(collectionValue, index());
+        };
+    }
+    }
+    throw std::runtime_error("Unknown expression type");
+}
+
+ExprFn ClosureCompiler::compileBinary(const Expr& expr) {
+    static const std::unordered_map<TokenType, BinaryFactory> factories = {
+        {TokenType::Plus, binaryFactory<TokenType::Plus>()},
+        {TokenType::Minus, binaryFactory<TokenType::Minus>()},
+        {TokenType::Star, binaryFactory<TokenType::Star>()},
+        {TokenType::Slash, binaryFactory<TokenType::Slash>()},
+        {TokenType::Percent, binaryFactory<TokenType::Percent>()},
+        {TokenType::Power, binaryFactory<TokenType::Power>()},
+        {TokenType::Equal, binaryFactory<TokenType::Equal>()},
+        {TokenType::NotEqual, binaryFactory<TokenType::NotEqual>()},
+        {TokenType::Less, binaryFactory<TokenType::Less>()},
+        {TokenType::Greater, binaryFactory<TokenType::Greater>()},
+        {TokenType::LessEqual, binaryFactory<TokenType::LessEqual>()},
+        {TokenType::GreaterEqual, binaryFactory<TokenType::GreaterEqual>()},
+        {TokenType::And, binaryFactory<TokenType::And>()},
+        {TokenType::Or, binaryFactory<TokenType::Or>()},
+    };
+    auto it = factories.find(expr.op);
+    if (it == factories.end()) {
+        throw std::runtime_error(std::string("Unsupported binary operator: ") + operatorSymbol(expr.op));
+    }
+    ExprFn left = compileExpr(expr.left);
+    const Expr& right = m_ast->expr(expr.right);
+    if (right.kind == ExprKind::Number) {
+        return it->second.constant(std::move(left), right.number);
+    }
+    return it->second.general(std::move(left), compileExpr(expr.right));
+}
+
+ExprFn ClosureCompiler::compileUnary(const Expr& expr) {
+    ExprFn operand = compileExpr(expr.left);
+    if (expr.op == TokenType::Minus) {
+        return [operand = std::move(operand)]() -> Value {
+            Value value = operand();
+            if (value.is_number()) return -value.as_number();
+            return evaluateUnaryOperation(value, TokenType::Minus);
+        };
+    }
+    if (expr.op == TokenType::Not) {
+        return [operand = std::move(operand)]() { return Value::boolean(!isTruthy(operand())); };
+    }
+    throw std::runtime_error(std::string("Unknown unary operator: ") + operatorSymbol(expr.op));
+}
+
+ExprFn ClosureCompiler::compileVariable(const Expr& expr) {
+    Symbol name = expr.name;
+    if (expr.binding.is_global()) {
+        return [this, name, cache = GlobalReadCache()]() mutable { return cache.read(*m_global_env, name); };
+    }
+    int depth = expr.binding.depth;
+    int slot = expr.binding.slot;
+    // A local read before its first assignment resolves dynamically outward
+    if (depth == 0) {
+        return [this, name, slot]() -> Value {
+            const Value& value = m_current_env->slot(slot);
+            return value.is_undefined() ? m_current_env->enclosing()->get(name) : value;
+        };
+    }
+    return [this, name, depth, slot]() -> Value {
+        Environment* env = m_current_env->ancestor(depth);
+        const Value& value = env->slot(slot);
+        return value.is_undefined() ? env->enclosing()->get(name) : value;
+    };
+}
+
+ExprFn ClosureCompiler::compileAssign(const Expr& expr) {
+    ExprFn value = compileExpr(expr.left);
+    Symbol name = expr.name;
+    Binding binding = expr.binding;
+    return [this, value = std::move(value), name, binding]() -> Value {
+        Value val = value();
+        if (binding.is_global()) {
+            m_global_env->update(name, val);
+            return val;
+        }
+        Environment* env = m_current_env->ancestor(binding.depth);
+        Value& slot = env->slot(binding.slot);
+        if (!slot.is_undefined()) slot = val;
+        else env->enclosing()->update(name, val);
+        return val;
+    };
+}
+
+ExprFn ClosureCompiler::compileCall(const Expr& expr) {
+    ExprFn callee = compileExpr(expr.left);
+    std::vector<ExprFn> arguments;
+    arguments.reserve(expr.items.count);
+    for (NodeIndex arg : m_ast->expressionList(expr.items)) arguments.push_back(compileExpr(arg));
+    return [this, callee = std::move(callee), arguments = std::move(arguments), site = QuickCall()]() mutable {
+        Value function = callee();
+        std::vector<Value> values;
+        values.reserve(arguments.size());
+        for (const auto& arg : arguments) values.push_back(arg());
+        auto generic = [this](FunctionObject* func, const std::vector<Value>& args) { return callFunction(func, args); };
+        return site.call(function, values, generic);
+    };
+}
+
+Value ClosureCompiler::callFunction(FunctionObject* func, const std::vector<Value>& arguments) {
+    if (!func) throw std::runtime_error("Can only call functions");
+    if (func->get_type() == FunctionObject::FunctionType::BUILTIN) {
+        return func->get_builtin()(arguments);
+    }
+
+    // A memoized function answers from its table when it can
+    MemoTable* memo = func->get_memo();
+    std::string key;
+    if (memo && MemoTable::makeKey(arguments.data(), arguments.size(), key)) {
+        if (const Value* cached = memo->find(key)) return *cached;
+    } else {
+        memo = nullptr;
+    }
+
+    auto previous_env = m_current_env;
+    const std::vector<Value>* args = &arguments;
+    Value callee; // keeps a tail callee alive
+    bool onStack = false; // m_current_env is one of m_frames
+    Completion completion;
+    for (;;) {
+        const auto& parameters = func->get_parameters();
+        if (args->size() != parameters.size()) {
+            throw std::runtime_error("Function expects " + std::to_string(parameters.size()) +
+                                   " arguments, got " + std::to_string(args->size()));
+        }
+        const CompiledFunction* compiled = func->get_compiled();
+        if (!compiled) throw std::runtime_error("Function has no compiled body");
+        // Native code runs the whole call when the arguments are numbers
+        const JitFunction* native = func->get_decl().jit;
+        if (native && native->call(*m_global_env, args->data(), args->size(), m_return_value)) {
+            completion = Completion::Return;
+            break;
+        }
+
+        // Bind parameters to the first slots of a fresh frame chained to the
+        // closure, replacing the one a tail call leaves (on the first pass
+        // m_current_env is the caller's frame, which previous_env still holds)
+        m_frames.enter(*func, m_current_env, onStack);
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            m_current_env->slot(static_cast<int>(i)) = (*args)[i];
+        }
+        m_tail_arguments.clear();
+
+        completion = compiled->body();
+        if (!m_tail_function) break;
+        // The body returned a call in tail position: make it here, without
+        // consulting the callee's memo table (its result is this call's)
+        callee = std::move(m_tail_callee);
+        func = std::exchange(m_tail_function, nullptr);
+        args = &m_tail_arguments;
+    }
+    if (onStack) m_frames.leave();
+    m_current_env = previous_env;
+    checkEscapedCompletion(completion, true);
+    // If no return statement, return default value
+    Value result = completion == Completion::Return ? std::move(m_return_value) : Value(0.0);
+    if (memo) memo->store(key, result);
+    return result;
+}
@@ -0,0 +1,351 @@
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "core/Compiler.h"
+#include "objects/StringObject.h"
+#include "objects/ObjectPool.h"
+
+std::unique_ptr<Program> Compiler::compile(const Ast& ast) {
+    auto program = std::make_unique<Program>();
+    m_ast = &ast;
+    m_program = program.get();
+    ChunkState saved = enterChunk(&program->main, false);
+    compileBlock(ast.program);
+    m_chunk->emit(OpCode::Halt);
+    leaveChunk(saved);
+    m_program = nullptr;
+    return program;
+}
+
+Compiler::ChunkState Compiler::enterChunk(Chunk* chunk, bool inFunction) {
+    ChunkState saved{m_chunk, m_inFunction, std::move(m_loops),
+                     std::move(m_numberConstants), std::move(m_stringConstants),
+                     std::move(m_nameIndices)};
+    m_chunk = chunk;
+    m_inFunction = inFunction;
+    m_loops.clear();
+    m_numberConstants.clear();
+    m_stringConstants.clear();
+    m_nameIndices.clear();
+    return saved;
+}
+
+void Compiler::leaveChunk(ChunkState& saved) {
+    m_chunk->globalCaches.resize(m_chunk->names.size());
+    m_chunk->globalStores.resize(m_chunk->names.size());
+    m_chunk = saved.chunk;
+    m_inFunction = saved.inFunction;
+    m_loops = std::move(saved.loops);
+    m_numberConstants = std::move(saved.numberConstants);
+    m_stringConstants = std::move(saved.stringConstants);
+    m_nameIndices = std::move(saved.nameIndices);
+}
+
+// --- Statements ---
+void Compiler::compileBlock(NodeList statements) {
+    for (NodeIndex stmt : m_ast->statementList(statements)) compileStmt(stmt);
+}
+
+void Compiler::compileStmt(NodeIndex index) {
+    const Stmt& stmt = m_ast->stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+        compileExpr(stmt.expr);
+        m_chunk->emit(OpCode::Pop);
+        break;
+    case StmtKind::Assign:
+        compileExpr(stmt.expr);
+        compileStore(stmt.name, stmt.binding);
+        break;
+    case StmtKind::If: compileIf(stmt); break;
+    case StmtKind::While:
+    case StmtKind::For: compileLoop(stmt); break;
+    case StmtKind::Block: compileBlock(stmt.body); break;
+    case StmtKind::FunctionDef: compileFunctionDef(stmt); break;
+    case StmtKind::Return: compileReturn(stmt); break;
+    case StmtKind::Break: compileBreak(); break;
+    case StmtKind::Continue: compileContinue(); break;
+    default: throw std::runtime_error("Unknown statement type");
+    }
+}
+
+void Compiler::compileIf(const Stmt& stmt) {
+    compileExpr(stmt.expr);
+    size_t elseJump = m_chunk->emit(OpCode::JumpIfFalse, 0);
+    compileBlock(stmt.body);
+    if (stmt.orelse.empty()) {
+        patchJump(elseJump);
+        return;
+    }
+    size_t endJump = m_chunk->emit(OpCode::Jump, 0);
+    patchJump(elseJump);
+    compileBlock(stmt.orelse);
+    patchJump(endJump);
+}
+
+// A top-level loop with native code is preceded by NativeLoop, which skips
+// the bytecode when the native code ran.
+void Compiler::compileLoop(const Stmt& stmt) {
+    uint32_t site = static_cast<uint32_t>(m_chunk->nativeLoops.size());
+    if (stmt.jit) {
+        m_chunk->nativeLoops.push_back({stmt.jit, 0});
+        m_chunk->emit(OpCode::NativeLoop, site);
+    }
+    if (stmt.kind == StmtKind::While) compileWhile(stmt);
+    else compileFor(stmt);
+    if (stmt.jit) m_chunk->nativeLoops[site].exit = currentOffset();
+}
+
+void Compiler::compileWhile(const Stmt& stmt) {
+    uint32_t loopStart = currentOffset();
+    size_t trace = emitTraceLoop(stmt, false);
+    compileExpr(stmt.expr);
+    size_t exitJump = m_chunk->emit(OpCode::JumpIfFalse, 0);
+
+    m_loops.push_back({false, loopStart, {}});
+    compileBlock(stmt.body);
+    m_chunk->emit(OpCode::Jump, loopStart);
+
+    patchJump(exitJump);
+    for (size_t jump : m_loops.back().breakJumps) patchJump(jump);
+    m_loops.pop_back();
+    if (trace != kNoTrace) m_chunk->traceLoops[trace].exit = currentOffset();
+}
+
+void Compiler::compileFor(const Stmt& stmt) {
+    compileExpr(stmt.expr);
+    m_chunk->emit(OpCode::GetIter);
+
+    uint32_t loopStart = currentOffset();
+    size_t trace = emitTraceLoop(stmt, true);
+    size_t exitJump = m_chunk->emit(OpCode::ForIter, 0);
+    compileStore(stmt.name, stmt.binding);
+
+    m_loops.push_back({true, loopStart, {}});
+    compileBlock(stmt.body);
+    m_chunk->emit(OpCode::Jump, loopStart);
+
+    // ForIter pops the iterator pair itself when exhausted; break jumps land
+    // after the pops emitted in compileBreak.
+    patchJump(exitJump);
+    for (size_t jump : m_loops.back().breakJumps) patchJump(jump);
+    m_loops.pop_back();
+    if (trace != kNoTrace) m_chunk->traceLoops[trace].exit = currentOffset();
+}
+
+// A loop traced under --trace-jit starts with TraceLoop, which every
+// iteration and every 'continue' passes. Returns its site, whose exit the
+// caller patches, or kNoTrace.
+size_t Compiler::emitTraceLoop(const Stmt& stmt, bool isFor) {
+    if (!stmt.trace) return kNoTrace;
+    size_t site = m_chunk->traceLoops.size();
+    m_chunk->traceLoops.push_back({stmt.trace, 0, isFor});
+    m_chunk->emit(OpCode::TraceLoop, static_cast<uint32_t>(site));
+    return site;
+}
+
+void Compiler::compileFunctionDef(const Stmt& stmt) {
+    const FunctionDecl& decl = m_ast->functions[stmt.function];
+    auto proto = std::make_unique<FunctionProto>();
+    proto->name = decl.name;
+    proto->parameters = decl.parameters;
+    proto->definition = &decl;
+
+    ChunkState saved = enterChunk(&proto->chunk, true);
+    compileBlock(decl.body);
+    // If no return statement, return default value
+    m_chunk->emit(OpCode::Constant, numberConstant(0.0));
+    m_chunk->emit(OpCode::Return);
+    leaveChunk(saved);
+
+    uint32_t index = static_cast<uint32_t>(m_program->functions.size());
+    m_program->functions.push_back(std::move(proto));
+    m_chunk->emit(OpCode::MakeFunction, index);
+    compileStore(decl.name, stmt.binding);
+}
+
+void Compiler::compileReturn(const Stmt& stmt) {
+    if (!m_inFunction) throw std::runtime_error("'return' outside function");
+    if (stmt.tailCall) {
+        compileCall(m_ast->expr(stmt.expr), OpCode::TailCall);
+    } else if (stmt.expr != kNoNode) {
+        compileExpr(stmt.expr);
+    } else {
+        m_chunk->emit(OpCode::Constant, numberConstant(0.0)); // Default return value
+    }
+    m_chunk->emit(OpCode::Return);
+}
+
+void Compiler::compileBreak() {
+    if (m_loops.empty()) throw std::runtime_error("'break' outside loop");
+    if (m_loops.back().isFor) {
+        m_chunk->emit(OpCode::Pop);
+        m_chunk->emit(OpCode::Pop);
+    }
+    m_loops.back().breakJumps.push_back(m_chunk->emit(OpCode::Jump, 0));
+}
+
+void Compiler::compileContinue() {
+    if (m_loops.empty()) throw std::runtime_error("'continue' outside loop");
+    m_chunk->emit(OpCode::Jump, m_loops.back().continueTarget);
+}
+
+// --- Expressions ---
+void Compiler::compileExpr(NodeIndex index) {
+    const Expr& e = m_ast->expr(index);
+    switch (e.kind) {
+    case ExprKind::Number:
+        m_chunk->emit(OpCode::Constant, numberConstant(e.number));
+        break;
+    case ExprKind::String:
+        m_chunk->emit(OpCode::Constant, stringConstant(e.name));
+        break;
+    case ExprKind::Variable:
+        compileLoad(e.name, e.binding);
+        break;
+    case ExprKind::Binary:
+        compileBinary(e);
+        break;
+    case ExprKind::Unary:
+        compileUnary(e);
+        break;
+    case ExprKind::Assign:
+        compileExpr(e.left);
+        m_chunk->emit(OpCode::UpdateName, nameIndex(e.name));
+        break;
+    case ExprKind::Call:
+        compileCall(e, OpCode::Call);
+        break;
+    case ExprKind::MemberAccess:
+        compileExpr(e.left);
+        m_chunk->emit(OpCode::Member, nameIndex(e.name));
+        break;
+    case ExprKind::List:
+        for (NodeIndex elem : m_ast->expressionList(e.items)) compileExpr(elem);
+        m_chunk->emit(OpCode::BuildList, e.items.count);
+        break;
+    case ExprKind::Index: {
+        const Expr& inner = m_ast->expr(e.left);
+        if (inner.kind == ExprKind::Index) {
+            compileExpr(inner.left);
+            compileExpr(inner.right);
+            m_chunk->emit(OpCode::IndexRow);
+            compileExpr(e.right);
+            m_chunk->emit(OpCode::IndexElement);
+            break;
+        }
+        compileExpr(e.left);
+        compileExpr(e.right);
+        m_chunk->emit(OpCode::Index);
+        break;
+    }
+    default:
+        throw std::runtime_error("Unknown expression type");
+    }
+}
+
+void Compiler::compileBinary(const Expr& expr) {
+    static const std::unordered_map<TokenType, OpCode> binaryOps = {
+        {TokenType::Plus, OpCode::Add},
+        {TokenType::Minus, OpCode::Subtract},
+        {TokenType::Star, OpCode::Multiply},
+        {TokenType::Slash, OpCode::Divide},
+        {TokenType::Percent, OpCode::Modulo},
+        {TokenType::Power, OpCode::Power},
+        {TokenType::Equal, OpCode::Equal},
+        {TokenType::NotEqual, OpCode::NotEqual},
+        {TokenType::Less, OpCode::Less},
+        {TokenType::Greater, OpCode::Greater},
+        {TokenType::LessEqual, OpCode::LessEqual},
+        {TokenType::GreaterEqual, OpCode::GreaterEqual},
+        {TokenType::And, OpCode::And},
+        {TokenType::Or, OpCode::Or},
+    };
+    auto it = binaryOps.find(expr.op);
+    if (it == binaryOps.end()) {
+        throw std::runtime_error(std::string("Unsupported binary operator: ") + operatorSymbol(expr.op));
+    }
+    // Both operands are always evaluated: 'and'/'or' do not short-circuit.
+    compileExpr(expr.left);
+    compileExpr(expr.right);
+    m_chunk->emit(it->second);
+}
+
+void Compiler::compileCall(const Expr& expr, OpCode op) {
+    compileExpr(expr.left);
+    for (NodeIndex arg : m_ast->expressionList(expr.items)) compileExpr(arg);
+    m_chunk->emit(op, static_cast<uint32_t>(m_chunk->callSites.size()));
+    m_chunk->callSites.push_back({expr.items.count, CallCache()});
+}
+
+void Compiler::compileUnary(const Expr& expr) {
+    compileExpr(expr.left);
+    if (expr.op == TokenType::Minus) m_chunk->emit(OpCode::Negate);
+    else if (expr.op == TokenType::Not) m_chunk->emit(OpCode::Not);
+    else throw std::runtime_error(std::string("Unknown unary operator: ") + operatorSymbol(expr.op));
+}
+
+void Compiler::compileLoad(Symbol name, const Binding& binding) {
+    if (binding.is_global()) {
+        m_chunk->emit(OpCode::LoadGlobal, nameIndex(name));
+    } else if (binding.depth == 0) {
+        m_chunk->emit(OpCode::LoadLocal, static_cast<uint32_t>(binding.slot));
+    } else {
+        if (binding.depth > 0xFF || binding.slot > 0xFFFFFF) {
+            throw std::runtime_error("Too many nested scopes or locals");
+        }
+        m_chunk->emit(OpCode::LoadEnclosing,
+                      static_cast<uint32_t>(binding.depth) << 24 | static_cast<uint32_t>(binding.slot));
+    }
+}
+
+// Definitions always target the innermost scope (Resolver only hands out
+// depth-0 bindings for them).
+void Compiler::compileStore(Symbol name, const Binding& binding) {
+    if (binding.is_global()) {
+        m_chunk->emit(OpCode::StoreGlobal, nameIndex(name));
+    } else {
+        m_chunk->emit(OpCode::StoreLocal, static_cast<uint32_t>(binding.slot));
+    }
+}
+
+// --- Helpers ---
+uint32_t Compiler::numberConstant(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto it = m_numberConstants.find(bits);
+    if (it != m_numberConstants.end()) return it->second;
+    uint32_t index = static_cast<uint32_t>(m_chunk->constants.size());
+    m_chunk->constants.push_back(value);
+    m_numberConstants.emplace(bits, index);
+    return index;
+}
+
+uint32_t Compiler::stringConstant(Symbol value) {
+    auto it = m_stringConstants.find(value);
+    if (it != m_stringConstants.end()) return it->second;
+    uint32_t index = static_cast<uint32_t>(m_chunk->constants.size());
+    m_chunk->constants.push_back(makePooled<StringObject>(value.text()));
+    m_stringConstants.emplace(value, index);
+    return index;
+}
+
+uint32_t Compiler::nameIndex(Symbol name) {
+    auto it = m_nameIndices.find(name);
+    if (it != m_nameIndices.end()) return it->second;
+    uint32_t index = static_cast<uint32_t>(m_chunk->names.size());
+    m_chunk->names.push_back(name);
+    m_nameIndices.emplace(name, index);
+    return index;
+}
+
+uint32_t Compiler::currentOffset() const {
+    if (m_chunk->code.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Too much code in a single chunk");
+    }
+    return static_cast<uint32_t>(m_chunk->code.size());
+}
+
+void Compiler::patchJump(size_t operand) {
+    m_chunk->patch(operand, currentOffset());
+}
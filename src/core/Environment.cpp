@@ -5,11 +5,43 @@ Environment::Environment() : parent(nullptr) {}
 
 Environment::Environment(std::shared_ptr<Environment> parent) : parent(parent) {}
 
-void Environment::set(const std::string& name, ObjectPtr value) {
-    values[name] = value;
+Environment::Environment(std::shared_ptr<Environment> parent, const std::vector<Symbol>& slotNames)
+    : slots(slotNames.size(), Value::undefined()), slotNames(&slotNames), parent(parent) {}
+
+Value* Environment::findSlot(Symbol name) {
+    if (!slotNames) return nullptr;
+    for (size_t i = 0; i < slotNames->size(); ++i) {
+        if ((*slotNames)[i] == name) return &slots[i];
+    }
+    return nullptr;
+}
+
+// Assigns to an entry of `values`, bumping the binding version when the
+// entry changes to or from an object, or between objects.
+void Environment::store(Value& target, Value value) {
+    if ((target.is_object() || value.is_object()) &&
+        (!target.is_object() || !value.is_object() || target.as_object() != value.as_object())) {
+        ++bindingVersion;
+    }
+    target = std::move(value);
+}
+
+void Environment::set(Symbol name, Value value) {
+    if (Value* slot = findSlot(name)) {
+        *slot = std::move(value);
+        return;
+    }
+    auto [it, added] = values.try_emplace(name);
+    if (added) ++bindingVersion;
+    store(it->second, std::move(value));
 }
 
-ObjectPtr Environment::get(const std::string& name) {
+const Value& Environment::get(Symbol name) {
+    Value* slot = findSlot(name);
+    if (slot && !slot->is_undefined()) {
+        return *slot;
+    }
+
     auto it = values.find(name);
     if (it != values.end()) {
         return it->second;
@@ -19,25 +51,36 @@ ObjectPtr Environment::get(const std::string& name) {
         return parent->get(name);
     }
     
-    throw std::runtime_error("Undefined variable: " + name);
+    throw std::runtime_error("Undefined variable: " + name.text());
 }
 
-void Environment::update(const std::string& name, ObjectPtr value) {
+void Environment::update(Symbol name, Value value) {
+    Value* slot = findSlot(name);
+    if (slot && !slot->is_undefined()) {
+        *slot = std::move(value);
+        return;
+    }
+
     auto it = values.find(name);
     if (it != values.end()) {
-        it->second = value;
+        store(it->second, std::move(value));
         return;
     }
     
     if (parent != nullptr) {
-        parent->update(name, value);
+        parent->update(name, std::move(value));
         return;
     }
     
-    throw std::runtime_error("Undefined variable: " + name);
+    throw std::runtime_error("Undefined variable: " + name.text());
 }
 
-bool Environment::has(const std::string& name) {
+bool Environment::has(Symbol name) {
+    Value* slot = findSlot(name);
+    if (slot && !slot->is_undefined()) {
+        return true;
+    }
+
     auto it = values.find(name);
     if (it != values.end()) {
         return true;
@@ -0,0 +1,55 @@
+#include <cstring>
+#include "core/ExecutableMemory.h"
+#include "core/X86Assembler.h"
+
+#ifdef JIT_X86_64
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+bool ExecutableMemory::assign(const std::vector<uint8_t>& code) {
+    release();
+#ifdef JIT_X86_64
+    if (code.empty()) return false;
+#ifdef _WIN32
+    void* pages = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!pages) return false;
+    std::memcpy(pages, code.data(), code.size());
+    DWORD previous;
+    if (!VirtualProtect(pages, code.size(), PAGE_EXECUTE_READ, &previous)) {
+        VirtualFree(pages, 0, MEM_RELEASE);
+        return false;
+    }
+#else
+    void* pages = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) return false;
+    std::memcpy(pages, code.data(), code.size());
+    if (mprotect(pages, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(pages, code.size());
+        return false;
+    }
+#endif
+    m_pages = pages;
+    m_size = code.size();
+    return true;
+#else
+    (void)code;
+    return false;
+#endif
+}
+
+void ExecutableMemory::release() {
+#ifdef JIT_X86_64
+    if (!m_pages) return;
+#ifdef _WIN32
+    VirtualFree(m_pages, 0, MEM_RELEASE);
+#else
+    munmap(m_pages, m_size);
+#endif
+#endif
+    m_pages = nullptr;
+    m_size = 0;
+}
@@ -1,385 +1,313 @@
-#include <cmath>
-#include <iostream>
 #include <stdexcept>
+#include <utility>
 #include "core/Interpreter.h"
-#include "objects/NumberObject.h"
+#include "core/Builtins.h"
+#include "core/Jit.h"
+#include "core/Tracer.h"
+#include "core/Operations.h"
 #include "objects/StringObject.h"
 #include "objects/ListObject.h"
-#include "objects/RangeObject.h"
 #include "objects/IteratorObject.h"
+#include "objects/RangeObject.h"
 #include "objects/FunctionObject.h"
-
-const char* BreakException::what() const noexcept {
-    return "Break";
-}
-
-const char* ContinueException::what() const noexcept {
-    return "Continue";
-}
-
-ReturnException::ReturnException(ObjectPtr v) : value(v) {}
-
-const char* ReturnException::what() const noexcept {
-    return "Return";
-}
+#include "objects/ObjectPool.h"
 
 Interpreter::Interpreter() {
-    m_global_env = std::make_shared<Environment>();
+    m_global_env = makePooled<Environment>();
     m_current_env = m_global_env;
-    setupBuiltinFunctions();
+    registerBuiltins(*m_global_env);
 }
 
-void Interpreter::run(const std::vector<std::unique_ptr<Stmt>>& statements) {
-    for (const auto& stmt : statements) {
-        visit(stmt.get());
+void Interpreter::run(const Ast& ast) {
+    m_ast = &ast;
+    m_cacheSites.assign(ast.expressions.size(), 0);
+    m_globalCaches.clear();
+    m_quickSites.clear();
+    m_callSites.clear();
+    for (size_t i = 0; i < ast.expressions.size(); ++i) {
+        const Expr& expr = ast.expressions[i];
+        if (expr.kind == ExprKind::Variable && expr.binding.is_global()) {
+            m_cacheSites[i] = static_cast<uint32_t>(m_globalCaches.size());
+            m_globalCaches.emplace_back();
+        } else if (expr.kind == ExprKind::Binary || expr.kind == ExprKind::Index) {
+            m_cacheSites[i] = static_cast<uint32_t>(m_quickSites.size());
+            m_quickSites.emplace_back();
+        } else if (expr.kind == ExprKind::Call) {
+            m_cacheSites[i] = static_cast<uint32_t>(m_callSites.size());
+            m_callSites.emplace_back();
+        }
     }
+    checkEscapedCompletion(visitBlock(ast.program), false);
 }
 
-void Interpreter::visit(const Stmt* stmt) {
-    if (auto s = dynamic_cast<const ExpressionStmt*>(stmt)) visitExpressionStmt(s);
-    else if (auto s = dynamic_cast<const AssignStmt*>(stmt)) visitAssignStmt(s);
-    else if (auto s = dynamic_cast<const IfStmt*>(stmt)) visitIfStmt(s);
-    else if (auto s = dynamic_cast<const WhileStmt*>(stmt)) visitWhileStmt(s);
-    else if (auto s = dynamic_cast<const ForStmt*>(stmt)) visitForStmt(s);
-    else if (auto s = dynamic_cast<const BlockStmt*>(stmt)) visitBlockStmt(s);
-    else if (auto s = dynamic_cast<const FunctionDefStmt*>(stmt)) visitFunctionDefStmt(s);
-    else if (auto s = dynamic_cast<const ReturnStmt*>(stmt)) visitReturnStmt(s);
-    else if (auto s = dynamic_cast<const BreakStmt*>(stmt)) throw BreakException();
-    else if (auto s = dynamic_cast<const ContinueStmt*>(stmt)) throw ContinueException();
-    else throw std::runtime_error("Unknown statement type");
-}
-
-void Interpreter::visitExpressionStmt(const ExpressionStmt* stmt) {
-    eval(stmt->expr.get());
-}
-
-void Interpreter::visitAssignStmt(const AssignStmt* stmt) {
-    ObjectPtr val = eval(stmt->value.get());
-    m_current_env->set(stmt->name, val);
+Completion Interpreter::visit(NodeIndex index) {
+    const Stmt& stmt = m_ast->stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+        eval(stmt.expr);
+        break;
+    case StmtKind::Assign:
+        define(stmt.name, stmt.binding, eval(stmt.expr));
+        break;
+    case StmtKind::If:
+        return visitBlock(isTruthy(eval(stmt.expr)) ? stmt.body : stmt.orelse);
+    case StmtKind::While:
+        return visitWhileStmt(stmt);
+    case StmtKind::For:
+        return visitForStmt(stmt);
+    case StmtKind::Block:
+        return visitBlock(stmt.body);
+    case StmtKind::FunctionDef:
+        visitFunctionDefStmt(stmt);
+        break;
+    case StmtKind::Return:
+        return visitReturnStmt(stmt);
+    case StmtKind::Break:
+        return Completion::Break;
+    case StmtKind::Continue:
+        return Completion::Continue;
+    default:
+        throw std::runtime_error("Unknown statement type");
+    }
+    return Completion::Normal;
 }
 
-void Interpreter::visitIfStmt(const IfStmt* stmt) {
-    ObjectPtr cond = eval(stmt->condition.get());
-    if (isTruthy(cond)) {
-        for (const auto& s : stmt->thenBranch) visit(s.get());
-    } else {
-        for (const auto& s : stmt->elseBranch) visit(s.get());
+// Runs statements until one of them completes abruptly.
+Completion Interpreter::visitBlock(NodeList statements) {
+    for (NodeIndex s : m_ast->statementList(statements)) {
+        Completion completion = visit(s);
+        if (completion != Completion::Normal) return completion;
     }
+    return Completion::Normal;
 }
 
-void Interpreter::visitWhileStmt(const WhileStmt* stmt) {
-    while (isTruthy(eval(stmt->condition.get()))) {
-        try {
-            for (const auto& s : stmt->body) visit(s.get());
-        } catch (const BreakException&) {
-            break;
-        } catch (const ContinueException&) {
-            continue;
-        }
+Completion Interpreter::visitWhileStmt(const Stmt& stmt) {
+    if (stmt.jit && stmt.jit->run(*m_global_env)) return Completion::Normal;
+    while (true) {
+        if (stmt.trace && stmt.trace->tick() && stmt.trace->run(*m_global_env, *m_current_env, nullptr)) break;
+        if (!isTruthy(eval(stmt.expr))) break;
+        Completion completion = visitBlock(stmt.body);
+        if (completion == Completion::Break) break;
+        if (completion == Completion::Return) return completion;
     }
+    return Completion::Normal;
 }
 
-void Interpreter::visitForStmt(const ForStmt* stmt) {
-    ObjectPtr iterable = eval(stmt->iterable.get());
-    std::shared_ptr<IteratorObject> iterator;
-    if (auto range = std::dynamic_pointer_cast<RangeObject>(iterable)) {
-        iterator = range->iter();
-    } else if (auto str = std::dynamic_pointer_cast<StringObject>(iterable)) {
-        iterator = str->iter();
-    } else if (auto list = std::dynamic_pointer_cast<ListObject>(iterable)) {
-        iterator = list->iter();
-    } else {
-        throw std::runtime_error("Object is not iterable");
+Completion Interpreter::visitForStmt(const Stmt& stmt) {
+    if (stmt.jit && stmt.jit->run(*m_global_env)) return Completion::Normal;
+    Value iterable = eval(stmt.expr);
+    if (auto range = iterable.as<RangeObject>()) {
+        // Counted loop: the variable is written straight into its slot
+        RangeCounter counter(*range);
+        GlobalNumberStore global;
+        while (true) {
+            if (stmt.trace && stmt.trace->tick() && stmt.trace->run(*m_global_env, *m_current_env, &counter)) break;
+            if (!counter.has_next()) break;
+            if (stmt.binding.is_global()) global.store(*m_global_env, stmt.name, counter.next());
+            else m_current_env->slot(stmt.binding.slot) = counter.next();
+            Completion completion = visitBlock(stmt.body);
+            if (completion == Completion::Break) break;
+            if (completion == Completion::Return) return completion;
+        }
+        return Completion::Normal;
     }
+    std::shared_ptr<IteratorObject> iterator = makeIterator(iterable);
     while (iterator->has_next()) {
-        m_current_env->set(stmt->var, iterator->next());
-        try {
-            for (const auto& s : stmt->body) visit(s.get());
-        } catch (const BreakException&) {
-            break;
-        } catch (const ContinueException&) {
-            continue;
-        }
+        define(stmt.name, stmt.binding, iterator->next());
+        Completion completion = visitBlock(stmt.body);
+        if (completion == Completion::Break) break;
+        if (completion == Completion::Return) return completion;
     }
+    return Completion::Normal;
 }
 
-void Interpreter::visitBlockStmt(const BlockStmt* stmt) {
-    for (const auto& s : stmt->statements) visit(s.get());
+void Interpreter::visitFunctionDefStmt(const Stmt& stmt) {
+    const FunctionDecl& decl = m_ast->functions[stmt.function];
+    auto function = makePooled<FunctionObject>(decl, m_current_env);
+    define(decl.name, stmt.binding, function);
 }
 
-void Interpreter::visitFunctionDefStmt(const FunctionDefStmt* stmt) {
-    // Convert unique_ptr to raw pointers for function body
-    std::vector<const Stmt*> body_ptrs;
-    for (const auto& stmt_ptr : stmt->body) {
-        body_ptrs.push_back(stmt_ptr.get());
+Completion Interpreter::visitReturnStmt(const Stmt& stmt) {
+    if (stmt.tailCall) return visitTailCall(stmt.expr);
+    m_return_value = 0.0; // Default return value
+    if (stmt.expr != kNoNode) {
+        m_return_value = eval(stmt.expr);
     }
-    
-    auto function = std::make_shared<FunctionObject>(stmt->parameters, body_ptrs, m_current_env);
-    m_current_env->set(stmt->name, function);
+    return Completion::Return;
 }
 
-void Interpreter::visitReturnStmt(const ReturnStmt* stmt) {
-    ObjectPtr value = nullptr;
-    if (stmt->value) {
-        value = eval(stmt->value.get());
+// Evaluates the callee and arguments of a call in tail position. A user
+// function is left in m_tail_function for the enclosing callFunction to run
+// in this call's place, so tail recursion does not grow the C++ stack.
+Completion Interpreter::visitTailCall(NodeIndex call) {
+    const Expr& e = m_ast->expr(call);
+    Value callee = eval(e.left);
+    std::vector<Value> arguments = evalArguments(e.items);
+    FunctionObject* func = m_callSites[m_cacheSites[call]].cache.resolve(callee);
+    if (func && func->get_type() == FunctionObject::FunctionType::USER_DEFINED) {
+        m_tail_callee = std::move(callee);
+        m_tail_function = func;
+        m_tail_arguments = std::move(arguments);
     } else {
-        value = std::make_shared<NumberObject>(0.0); // Default return value
+        m_return_value = callFunction(func, arguments);
     }
-    throw ReturnException(value);
+    return Completion::Return;
 }
 
-ObjectPtr Interpreter::eval(const Expr* expr) {
-    if (auto e = dynamic_cast<const NumberExpr*>(expr)) return std::make_shared<NumberObject>(e->value);
-    else if (auto e = dynamic_cast<const StringExpr*>(expr)) return std::make_shared<StringObject>(e->value);
-    else if (auto e = dynamic_cast<const VariableExpr*>(expr)) {
-        return m_current_env->get(e->name);
-    } else if (auto e = dynamic_cast<const BinaryExpr*>(expr)) {
-        ObjectPtr left = eval(e->left.get());
-        ObjectPtr right = eval(e->right.get());
-        const std::string& op = e->op;
-
-        if (auto lnum = std::dynamic_pointer_cast<NumberObject>(left)) {
-            if (auto rnum = std::dynamic_pointer_cast<NumberObject>(right)) {
-                return evaluateNumberOperation(lnum->value, rnum->value, op);
-            }
-            if (auto rstr = std::dynamic_pointer_cast<StringObject>(right)) {
-                return evaluateStringNumberOperation(rstr->value, lnum->value, op);
-            }
-        }
-        if (auto lstr = std::dynamic_pointer_cast<StringObject>(left)) {
-            if (auto rstr = std::dynamic_pointer_cast<StringObject>(right)) {
-                return evaluateStringOperation(lstr->value, rstr->value, op);
-            } else if (auto rnum = std::dynamic_pointer_cast<NumberObject>(right)) {
-                return evaluateStringNumberOperation(lstr->value, rnum->value, op);
-            }
-        }
-
-        throw std::runtime_error("Type error in binary expression");
-    } else if (auto e = dynamic_cast<const UnaryExpr*>(expr)) {
-        ObjectPtr operand = eval(e->operand.get());
-        if (e->op == "-") {
-            if (auto num = std::dynamic_pointer_cast<NumberObject>(operand)) {
-                return std::make_shared<NumberObject>(-num->value);
-            }
-            throw std::runtime_error("Unary '-' expects a number");
-        }
-        if (e->op == "not") {
-            return std::make_shared<NumberObject>(isTruthy(operand) ? 0.0 : 1.0);
-        }
-        throw std::runtime_error("Unknown unary operator: " + e->op);
-    } else if (auto e = dynamic_cast<const AssignExpr*>(expr)) {
-        ObjectPtr val = eval(e->value.get());
-        m_current_env->update(e->name, val);
+Value Interpreter::eval(NodeIndex index) {
+    const Expr& e = m_ast->expr(index);
+    switch (e.kind) {
+    case ExprKind::Number:
+        return e.number;
+    case ExprKind::String:
+        return makePooled<StringObject>(e.name.text());
+    case ExprKind::Variable:
+        if (e.binding.is_global()) return m_globalCaches[m_cacheSites[index]].read(*m_global_env, e.name);
+        return lookup(e.name, e.binding);
+    case ExprKind::Binary: {
+        Value left = eval(e.left);
+        Value right = eval(e.right);
+        return m_quickSites[m_cacheSites[index]].binary(left, right, e.op);
+    }
+    case ExprKind::Unary: {
+        Value operand = eval(e.left);
+        return evaluateUnaryOperation(operand, e.op);
+    }
+    case ExprKind::Assign: {
+        Value val = eval(e.left);
+        assign(e.name, e.binding, val);
         return val;
-    } else if (auto e = dynamic_cast<const CallExpr*>(expr)) {
-        ObjectPtr callee = eval(e->callee.get());
-        
-        std::vector<ObjectPtr> arguments;
-        for (const auto& arg : e->arguments) {
-            arguments.push_back(eval(arg.get()));
-        }
-        
-        return callFunction(callee, arguments);
-    } else if (auto e = dynamic_cast<const MemberAccessExpr*>(expr)) {
-        ObjectPtr object = eval(e->object.get());
-        
-        // For now, we'll support basic member access on strings and lists
-        if (auto str = std::dynamic_pointer_cast<StringObject>(object)) {
-            if (e->member == "length") {
-                return std::make_shared<NumberObject>(static_cast<double>(str->value.length()));
-            }
-        } else if (auto list = std::dynamic_pointer_cast<ListObject>(object)) {
-            if (e->member == "length") {
-                return std::make_shared<NumberObject>(static_cast<double>(list->items.size()));
-            }
-        }
-        
-        throw std::runtime_error("Member '" + e->member + "' not found on object");
-    } else if (auto e = dynamic_cast<const ListExpr*>(expr)) {
-        std::vector<ObjectPtr> items;
-        for (const auto& elem : e->elements)
-            items.push_back(eval(elem.get()));
-        return std::make_shared<ListObject>(items);
-    } else if (auto e = dynamic_cast<const IndexExpr*>(expr)) {
-        ObjectPtr collection = eval(e->collection.get());
-        ObjectPtr index = eval(e->index.get());
-        auto get_index = [&](int size) -> int {
-            if (auto num = std::dynamic_pointer_cast<NumberObject>(index)) {
-                int idx = static_cast<int>(num->value);
-                if (idx < 0) idx += size;
-                if (idx < 0 || idx >= size)
-                    throw std::runtime_error("Index out of range");
-                return idx;
+    }
+    case ExprKind::Call: {
+        Value callee = eval(e.left);
+        std::vector<Value> arguments = evalArguments(e.items);
+        auto generic = [this](FunctionObject* func, const std::vector<Value>& args) { return callFunction(func, args); };
+        return m_callSites[m_cacheSites[index]].call(callee, arguments, generic);
+    }
+    case ExprKind::MemberAccess: {
+        Value object = eval(e.left);
+        return evaluateMemberAccess(object, e.name.text());
+    }
+    case ExprKind::List: {
+        std::vector<Value> items;
+        items.reserve(e.items.count);
+        for (NodeIndex elem : m_ast->expressionList(e.items))
+            items.push_back(eval(elem));
+        return makePooled<ListObject>(std::move(items));
+    }
+    case ExprKind::Index: {
+        const Expr& inner = m_ast->expr(e.left);
+        if (inner.kind == ExprKind::Index) {
+            // a[i][j]: on a 2-D array, read the element without a row view
+            Value collection = eval(inner.left);
+            Value row = eval(inner.right);
+            size_t i;
+            if (const ArrayObject* matrix = matrixRow(collection, row, i)) {
+                Value column = eval(e.right);
+                return matrixElement(*matrix, i, column);
             }
-            throw std::runtime_error("Index must be a number");
-        };
-    
-        if (auto list = std::dynamic_pointer_cast<ListObject>(collection)) {
-            int idx = get_index(static_cast<int>(list->items.size()));
-            return list->items[idx];
-        } else if (auto str = std::dynamic_pointer_cast<StringObject>(collection)) {
-            int idx = get_index(static_cast<int>(str->value.size()));
-            return std::make_shared<StringObject>(std::string(1, str->value[idx]));
+            Value rowValue = m_quickSites[m_cacheSites[e.left]].index(collection, row);
+            Value subscript = eval(e.right);
+            return m_quickSites[m_cacheSites[index]].index(rowValue, subscript);
         }
-        throw std::runtime_error("Object is not subscriptable");
+        Value collection = eval(e.left);
+        Value subscript = eval(e.right);
+        return m_quickSites[m_cacheSites[index]].index(collection, subscript);
+    }
     }
     throw std::runtime_error("Unknown expression type");
 }
 
-void Interpreter::setupBuiltinFunctions() {
-    auto print_func = [](const std::vector<ObjectPtr>& args) -> ObjectPtr {
-        bool first = true;
-        for (const auto& arg : args) {
-            if (!first) std::cout << " ";
-            first = false;
-            if (auto num = std::dynamic_pointer_cast<NumberObject>(arg)) {
-                std::cout << num->value;
-            } else if (auto str = std::dynamic_pointer_cast<StringObject>(arg)) {
-                std::cout << str->value;
-            } else {
-                std::cout << "<object>";
-            }
-        }
-        std::cout << std::endl;
-        return std::make_shared<NumberObject>(0.0);
-    };
-    
-    auto range_func = [](const std::vector<ObjectPtr>& args) -> ObjectPtr {
-        size_t argc = args.size();
-        double start = 0, stop = 0, step = 1;
-        
-        if (argc == 1) {
-            if (auto n = std::dynamic_pointer_cast<NumberObject>(args[0])) stop = n->value;
-            else throw std::runtime_error("range(stop) expects a number");
-        } else if (argc == 2) {
-            if (auto n1 = std::dynamic_pointer_cast<NumberObject>(args[0])) start = n1->value;
-            else throw std::runtime_error("range(start, stop) expects numbers");
-            if (auto n2 = std::dynamic_pointer_cast<NumberObject>(args[1])) stop = n2->value;
-            else throw std::runtime_error("range(start, stop) expects numbers");
-        } else if (argc == 3) {
-            if (auto n1 = std::dynamic_pointer_cast<NumberObject>(args[0])) start = n1->value;
-            else throw std::runtime_error("range(start, stop, step) expects numbers");
-            if (auto n2 = std::dynamic_pointer_cast<NumberObject>(args[1])) stop = n2->value;
-            else throw std::runtime_error("range(start, stop, step) expects numbers");
-            if (auto n3 = std::dynamic_pointer_cast<NumberObject>(args[2])) step = n3->value;
-            else throw std::runtime_error("range(start, stop, step) expects numbers");
-            if (step == 0) throw std::runtime_error("range() step argument must not be zero");
-        } else {
-            throw std::runtime_error("range() expects 1 to 3 arguments");
-        }
-        return std::make_shared<RangeObject>(start, stop, step);
-    };
-    
-    auto len_func = [](const std::vector<ObjectPtr>& args) -> ObjectPtr {
-        if (args.size() != 1) {
-            throw std::runtime_error("len() expects exactly 1 argument");
-        }
-        
-        if (auto str = std::dynamic_pointer_cast<StringObject>(args[0])) {
-            return std::make_shared<NumberObject>(static_cast<double>(str->value.length()));
-        } else if (auto list = std::dynamic_pointer_cast<ListObject>(args[0])) {
-            return std::make_shared<NumberObject>(static_cast<double>(list->items.size()));
-        } else {
-            throw std::runtime_error("len() expects a string or list");
-        }
-    };
-    
-    m_global_env->set("print", std::make_shared<FunctionObject>("print", print_func));
-    m_global_env->set("range", std::make_shared<FunctionObject>("range", range_func));
-    m_global_env->set("len", std::make_shared<FunctionObject>("len", len_func));
-}
-
-ObjectPtr Interpreter::callFunction(ObjectPtr callee, const std::vector<ObjectPtr>& arguments) {
-    if (auto func = std::dynamic_pointer_cast<FunctionObject>(callee)) {
-        if (func->get_type() == FunctionObject::FunctionType::BUILTIN) {
-            return func->get_builtin()(arguments);
-        } else {
-            // User-defined function
-            const auto& parameters = func->get_parameters();
-            if (arguments.size() != parameters.size()) {
-                throw std::runtime_error("Function expects " + std::to_string(parameters.size()) + 
-                                       " arguments, got " + std::to_string(arguments.size()));
-            }
-            
-            // Create new environment for function execution
-            auto function_env = std::make_shared<Environment>(func->get_closure());
-            
-            // Bind parameters
-            for (size_t i = 0; i < parameters.size(); ++i) {
-                function_env->set(parameters[i], arguments[i]);
-            }
-            
-            // Save current environment and switch to function environment
-            auto previous_env = m_current_env;
-            m_current_env = function_env;
-            
-                         try {
-                 // Execute function body
-                 for (const auto& stmt : func->get_body()) {
-                     visit(stmt);
-                 }
-                // If no return statement, return default value
-                m_current_env = previous_env;
-                return std::make_shared<NumberObject>(0.0);
-            } catch (const ReturnException& e) {
-                m_current_env = previous_env;
-                return e.value;
-            }
-        }
+std::vector<Value> Interpreter::evalArguments(NodeList items) {
+    std::vector<Value> arguments;
+    arguments.reserve(items.count);
+    for (NodeIndex arg : m_ast->expressionList(items)) {
+        arguments.push_back(eval(arg));
     }
-    
-    throw std::runtime_error("Can only call functions");
+    return arguments;
 }
 
-ObjectPtr Interpreter::evaluateNumberOperation(double left, double right, const std::string& op) {
-    if (op == "+") return std::make_shared<NumberObject>(left + right);
-    if (op == "-") return std::make_shared<NumberObject>(left - right);
-    if (op == "*") return std::make_shared<NumberObject>(left * right);
-    if (op == "/") return std::make_shared<NumberObject>(left / right);
-    if (op == "%") return std::make_shared<NumberObject>(std::fmod(left, right));
-    if (op == "==") return std::make_shared<NumberObject>(left == right ? 1.0 : 0.0);
-    if (op == "!=") return std::make_shared<NumberObject>(left != right ? 1.0 : 0.0);
-    if (op == "<") return std::make_shared<NumberObject>(left < right ? 1.0 : 0.0);
-    if (op == ">") return std::make_shared<NumberObject>(left > right ? 1.0 : 0.0);
-    if (op == "<=") return std::make_shared<NumberObject>(left <= right ? 1.0 : 0.0);
-    if (op == ">=") return std::make_shared<NumberObject>(left >= right ? 1.0 : 0.0);
-    if (op == "**") return std::make_shared<NumberObject>(std::pow(left, right));
-    if (op == "and") return std::make_shared<NumberObject>((left && right) ? 1.0 : 0.0);
-    if (op == "or") return std::make_shared<NumberObject>((left || right) ? 1.0 : 0.0);
-    
-    throw std::runtime_error("Unsupported binary operator for numbers: " + op);
+const Value& Interpreter::lookup(Symbol name, const Binding& binding) {
+    if (binding.is_global()) return m_global_env->get(name);
+    Environment* env = m_current_env->ancestor(binding.depth);
+    const Value& value = env->slot(binding.slot);
+    if (!value.is_undefined()) return value;
+    // Read before the local's first assignment: resolve dynamically outward
+    return env->enclosing()->get(name);
 }
 
-ObjectPtr Interpreter::evaluateStringOperation(const std::string& left, const std::string& right, const std::string& op) {
-    if (op == "+") return std::make_shared<StringObject>(left + right);
-    
-    throw std::runtime_error("Unsupported binary operator for strings: " + op);
+void Interpreter::define(Symbol name, const Binding& binding, Value value) {
+    if (binding.is_global()) m_global_env->set(name, std::move(value));
+    else m_current_env->slot(binding.slot) = std::move(value);
 }
 
-ObjectPtr Interpreter::evaluateStringNumberOperation(const std::string& str, double num, const std::string& op) {
-    if (op == "*") {
-        // String repetition: "abc" * 3 = "abcabcabc"
-        int count = static_cast<int>(num);
-        if (count < 0) throw std::runtime_error("String repetition count must be non-negative");
-        
-        std::string result;
-        result.reserve(str.length() * count);
-        for (int i = 0; i < count; ++i) {
-            result += str;
-        }
-        return std::make_shared<StringObject>(result);
+void Interpreter::assign(Symbol name, const Binding& binding, Value value) {
+    if (binding.is_global()) {
+        m_global_env->update(name, std::move(value));
+        return;
     }
-    
-    throw std::runtime_error("Unsupported binary operator for string and number: " + op);
+    Environment* env = m_current_env->ancestor(binding.depth);
+    Value& slot = env->slot(binding.slot);
+    if (!slot.is_undefined()) slot = std::move(value);
+    else env->enclosing()->update(name, std::move(value));
 }
 
-bool Interpreter::isTruthy(ObjectPtr value) {
-    if (auto num = std::dynamic_pointer_cast<NumberObject>(value)) {
-        return num->value != 0.0;
+Value Interpreter::callFunction(FunctionObject* func, const std::vector<Value>& arguments) {
+    if (!func) throw std::runtime_error("Can only call functions");
+    if (func->get_type() == FunctionObject::FunctionType::BUILTIN) {
+        return func->get_builtin()(arguments);
+    }
+
+    // A memoized function answers from its table when it can
+    MemoTable* memo = func->get_memo();
+    std::string key;
+    if (memo && MemoTable::makeKey(arguments.data(), arguments.size(), key)) {
+        if (const Value* cached = memo->find(key)) return *cached;
+    } else {
+        memo = nullptr;
     }
-    if (auto str = std::dynamic_pointer_cast<StringObject>(value)) {
-        return !str->value.empty();
+
+    auto previous_env = m_current_env;
+    const std::vector<Value>* args = &arguments;
+    Value callee; // keeps a tail callee alive
+    bool onStack = false; // m_current_env is one of m_frames
+    Completion completion;
+    for (;;) {
+        const auto& parameters = func->get_parameters();
+        if (args->size() != parameters.size()) {
+            throw std::runtime_error("Function expects " + std::to_string(parameters.size()) +
+                                   " arguments, got " + std::to_string(args->size()));
+        }
+        // Native code runs the whole call when the arguments are numbers
+        const JitFunction* native = func->get_decl().jit;
+        if (native && native->call(*m_global_env, args->data(), args->size(), m_return_value)) {
+            completion = Completion::Return;
+            break;
+        }
+
+        // A fresh frame chained to the closure, replacing the one a tail
+        // call leaves (on the first pass m_current_env is the caller's frame,
+        // which previous_env still holds)
+        m_frames.enter(*func, m_current_env, onStack);
+        // Bind parameters (the first slots of the frame)
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            m_current_env->slot(static_cast<int>(i)) = (*args)[i];
+        }
+        m_tail_arguments.clear();
+
+        completion = visitBlock(func->get_body());
+        if (!m_tail_function) break;
+        // The body returned a call in tail position: make it here, without
+        // consulting the callee's memo table (its result is this call's)
+        callee = std::move(m_tail_callee);
+        func = std::exchange(m_tail_function, nullptr);
+        args = &m_tail_arguments;
     }
-    // All other objects are considered truthy
-    return true;
+    if (onStack) m_frames.leave();
+    m_current_env = previous_env;
+    checkEscapedCompletion(completion, true);
+    // If no return statement, return default value
+    Value result = completion == Completion::Return ? std::move(m_return_value) : Value(0.0);
+    if (memo) memo->store(key, result);
+    return result;
 }
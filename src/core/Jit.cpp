@@ -0,0 +1,933 @@
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include "core/Jit.h"
+#include "core/Operations.h"
+#include "core/X86Assembler.h"
+#include "objects/FunctionObject.h"
+
+// Native frames in use, and how many the native stack is trusted with. A
+// call past the limit gives up and its outermost native caller is run by
+// the interpreter instead.
+static int64_t s_nativeDepth = 0;
+constexpr int32_t kMaxNativeDepth = 20000;
+constexpr uint32_t kMaxArity = 16;
+
+// A global a loop may leave unbound. A signaling NaN: arithmetic quiets
+// NaNs, so no computed value has this bit pattern.
+constexpr uint64_t kUnbound = 0x7FF4000000000000ULL;
+
+static uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool JitFunction::call(Environment& globals, const Value* arguments, size_t count, Value& result) const {
+    if (disabled || count != arity) return false;
+    double values[kMaxArity];
+    for (size_t i = 0; i < count; ++i) {
+        if (!arguments[i].is_number()) {
+            ++jitStats().fallbacks;
+            return false;
+        }
+        values[i] = arguments[i].as_number();
+    }
+    // Stable globals never change once bound, so this holds for good
+    if (!ready) {
+        for (const auto& [name, decl] : callees) {
+            Value* bound = globals.entry(name);
+            auto* function = bound ? bound->as<FunctionObject>() : nullptr;
+            if (!function || function->get_type() != FunctionObject::FunctionType::USER_DEFINED ||
+                &function->get_decl() != decl) {
+                ++jitStats().fallbacks;
+                return false;
+            }
+        }
+        ready = true;
+    }
+    double value;
+    auto status = static_cast<JitStatus>(entry(values, &value));
+    if (status != JitStatus::Done) {
+        ++jitStats().fallbacks;
+        if (status == JitStatus::TooDeep) disabled = true;
+        return false;
+    }
+    ++jitStats().nativeCalls;
+    result = value;
+    return true;
+}
+
+bool JitLoop::run(Environment& globals) const {
+    std::vector<double> values(variables.size());
+    for (size_t i = 0; i < variables.size(); ++i) {
+        Value* bound = globals.entry(variables[i]);
+        if (bound && bound->is_number()) {
+            values[i] = bound->as_number();
+        } else if (!bound && !required[i]) {
+            std::memcpy(&values[i], &kUnbound, sizeof(double));
+        } else {
+            ++jitStats().fallbacks;
+            return false;
+        }
+    }
+    auto status = static_cast<JitStatus>(entry(values.data()));
+    for (size_t i = 0; i < variables.size(); ++i) {
+        if (bitsOf(values[i]) != kUnbound) globals.set(variables[i], values[i]);
+    }
+    ++jitStats().loopRuns;
+    if (status == JitStatus::ZeroStep) throw std::runtime_error("range() step argument must not be zero");
+    return true;
+}
+
+#ifdef JIT_X86_64
+
+namespace {
+
+using A = X86Assembler;
+
+double jitFmod(double a, double b) { return NumberKernel<TokenType::Percent>::apply(a, b); }
+double jitPow(double a, double b) { return NumberKernel<TokenType::Power>::apply(a, b); }
+
+// Variables certainly assigned at a point of a unit, by index; indices past
+// the end are unassigned. live is false after break, continue and return.
+struct Flow {
+    std::vector<char> assigned;
+    bool live = true;
+
+    bool has(int index) const { return index < static_cast<int>(assigned.size()) && assigned[index]; }
+    void add(int index) {
+        if (index >= static_cast<int>(assigned.size())) assigned.resize(index + 1, 0);
+        assigned[index] = 1;
+    }
+    // Joins two paths that meet
+    void merge(const Flow& other) {
+        if (!other.live) return;
+        if (!live) {
+            *this = other;
+            return;
+        }
+        for (size_t i = 0; i < assigned.size(); ++i) assigned[i] = assigned[i] && other.has(static_cast<int>(i));
+    }
+};
+
+// A function or a top-level loop being checked or compiled. Function
+// variables are its frame slots; loop variables are the globals it uses,
+// numbered as they are met.
+struct Unit {
+    bool isLoop = false;
+    uint32_t function = 0;
+    NodeIndex loop = kNoNode;
+    std::unordered_map<Symbol, int> globals;
+    std::vector<Symbol> globalNames;
+    std::vector<bool> required;
+    std::vector<uint32_t> callees;  // function indices, possibly repeated
+    int variableCount = 0;
+};
+
+class NativeCompiler {
+public:
+    explicit NativeCompiler(Ast& ast) : m_ast(ast) {
+        for (const Stmt& stmt : ast.statements) {
+            bool binds = stmt.kind == StmtKind::Assign || stmt.kind == StmtKind::For ||
+                         stmt.kind == StmtKind::FunctionDef;
+            if (!binds || !stmt.binding.is_global()) continue;
+            ++m_globalBindings[stmt.name];
+            if (stmt.kind == StmtKind::FunctionDef) m_globalFunctions[stmt.name] = stmt.function;
+        }
+        for (const Expr& expr : ast.expressions) {
+            if (expr.kind == ExprKind::Assign && expr.binding.is_global()) ++m_globalBindings[expr.name];
+        }
+    }
+
+    // Decides what qualifies and emits all of it into one buffer.
+    void run(std::vector<std::unique_ptr<JitFunction>>& functions, std::vector<std::unique_ptr<JitLoop>>& loops,
+             ExecutableMemory& code);
+
+private:
+    struct LoopLabels {
+        A::Label exit;
+        A::Label next;
+    };
+
+    Ast& m_ast;
+    std::unordered_map<Symbol, int> m_globalBindings;
+    std::unordered_map<Symbol, uint32_t> m_globalFunctions;
+
+    // Code generation state
+    A m_asm;
+    std::vector<A::Label> m_functionLabels;  // internal entry of each compiled function
+    Unit* m_unit = nullptr;
+    int m_reserved = 0;      // frame slots before the variables
+    int m_temps = 0;         // frame slots after them
+    int m_pushed = 0;        // qwords pushed below the frame
+    A::Label m_body = 0;     // after the prologue, for self tail calls
+    A::Label m_return = 0;   // xmm0 holds the result
+    A::Label m_exit = 0;     // eax holds the status
+    std::vector<LoopLabels> m_loops;
+
+    // --- Checking ---
+    bool isStableFunction(Symbol name) const {
+        auto it = m_globalBindings.find(name);
+        return it != m_globalBindings.end() && it->second == 1 && m_globalFunctions.count(name);
+    }
+    bool isRangeCall(const Expr& expr) const {
+        if (expr.kind != ExprKind::Call || expr.items.count < 1 || expr.items.count > 3) return false;
+        const Expr& callee = m_ast.expr(expr.left);
+        return callee.kind == ExprKind::Variable && callee.binding.is_global() && callee.name.text() == "range" &&
+               !m_globalBindings.count(callee.name);
+    }
+    int variable(Unit& unit, Symbol name, const Binding& binding) {
+        if (!unit.isLoop) return binding.depth == 0 ? binding.slot : -1;
+        if (!binding.is_global()) return -1;
+        auto [it, added] = unit.globals.try_emplace(name, static_cast<int>(unit.globalNames.size()));
+        if (added) {
+            unit.globalNames.push_back(name);
+            unit.required.push_back(false);
+        }
+        return it->second;
+    }
+    bool checkBlock(NodeList statements, Unit& unit, Flow& flow, int loopDepth);
+    bool checkStmt(NodeIndex index, Unit& unit, Flow& flow, int loopDepth);
+    bool checkExpr(NodeIndex index, Unit& unit, Flow& flow);
+    void findLoops(NodeList statements, std::vector<Unit>& units);
+
+    // --- Code generation ---
+    int32_t offset(int slot) const { return -8 * (m_reserved + slot + 1); }
+    int32_t variableOffset(Symbol name, const Binding& binding) const {
+        return offset(m_unit->isLoop ? m_unit->globals.at(name) : binding.slot);
+    }
+    int newTemp() { return m_unit->variableCount + m_temps++; }
+    size_t prologue();
+    void frameSize(size_t patch);
+    void emitFunction(uint32_t index, Unit& unit);
+    void emitLoop(Unit& unit);
+    void emitFunctionEntry(A::Label internal);
+    void loadNumber(A::Xmm reg, double number);
+    bool isSimple(NodeIndex index) const;
+    void loadSimple(NodeIndex index, A::Xmm reg);
+    void pushXmm0();
+    void popXmm1();
+    void operands(const Expr& expr);
+    void callHelper(double (*helper)(double, double));
+    void emitBlock(NodeList statements);
+    void emitStmt(NodeIndex index);
+    void emitExpr(NodeIndex index);
+    void emitBinary(TokenType op);
+    void emitCall(const Expr& expr, bool tail);
+    void emitFor(const Stmt& stmt);
+    void emitBranchIfFalse(NodeIndex condition, A::Label target);
+};
+
+bool NativeCompiler::checkBlock(NodeList statements, Unit& unit, Flow& flow, int loopDepth) {
+    for (NodeIndex index : m_ast.statementList(statements)) {
+        if (!checkStmt(index, unit, flow, loopDepth)) return false;
+    }
+    return true;
+}
+
+bool NativeCompiler::checkStmt(NodeIndex index, Unit& unit, Flow& flow, int loopDepth) {
+    const Stmt& stmt = m_ast.stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+        return checkExpr(stmt.expr, unit, flow);
+    case StmtKind::Assign: {
+        if (!checkExpr(stmt.expr, unit, flow)) return false;
+        int target = variable(unit, stmt.name, stmt.binding);
+        if (target < 0) return false;
+        flow.add(target);
+        return true;
+    }
+    case StmtKind::If: {
+        if (!checkExpr(stmt.expr, unit, flow)) return false;
+        Flow orelse = flow;
+        if (!checkBlock(stmt.body, unit, flow, loopDepth) || !checkBlock(stmt.orelse, unit, orelse, loopDepth)) {
+            return false;
+        }
+        flow.merge(orelse);
+        return true;
+    }
+    case StmtKind::While: {
+        // The body may not run: what it assigns is not certain afterwards
+        if (!checkExpr(stmt.expr, unit, flow)) return false;
+        Flow body = flow;
+        return checkBlock(stmt.body, unit, body, loopDepth + 1);
+    }
+    case StmtKind::For: {
+        const Expr& iterable = m_ast.expr(stmt.expr);
+        if (!isRangeCall(iterable)) return false;
+        for (NodeIndex argument : m_ast.expressionList(iterable.items)) {
+            if (!checkExpr(argument, unit, flow)) return false;
+        }
+        int target = variable(unit, stmt.name, stmt.binding);
+        if (target < 0) return false;
+        Flow body = flow;
+        body.add(target);
+        return checkBlock(stmt.body, unit, body, loopDepth + 1);
+    }
+    case StmtKind::Block:
+        return checkBlock(stmt.body, unit, flow, loopDepth);
+    case StmtKind::Break:
+    case StmtKind::Continue:
+        flow.live = false;
+        return loopDepth > 0;
+    case StmtKind::Return:
+        if (unit.isLoop) return false;
+        flow.live = false;
+        return stmt.expr == kNoNode || checkExpr(stmt.expr, unit, flow);
+    case StmtKind::FunctionDef:
+        return false;
+    }
+    return false;
+}
+
+bool NativeCompiler::checkExpr(NodeIndex index, Unit& unit, Flow& flow) {
+    const Expr& expr = m_ast.expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+        return true;
+    case ExprKind::Variable: {
+        int source = variable(unit, expr.name, expr.binding);
+        if (source < 0) return false;
+        if (!flow.has(source)) {
+            // A function local read before it is assigned looks outward
+            if (!unit.isLoop) return false;
+            unit.required[source] = true;
+        }
+        return true;
+    }
+    case ExprKind::Binary:
+        return isBinaryOperator(expr.op) && checkExpr(expr.left, unit, flow) && checkExpr(expr.right, unit, flow);
+    case ExprKind::Unary:
+        return (expr.op == TokenType::Minus || expr.op == TokenType::Not) && checkExpr(expr.left, unit, flow);
+    case ExprKind::Assign: {
+        if (!checkExpr(expr.left, unit, flow)) return false;
+        int target = variable(unit, expr.name, expr.binding);
+        if (target < 0) return false;
+        flow.add(target);
+        return true;
+    }
+    case ExprKind::Call: {
+        if (unit.isLoop) return false;
+        const Expr& callee = m_ast.expr(expr.left);
+        if (callee.kind != ExprKind::Variable || !callee.binding.is_global() || !isStableFunction(callee.name)) {
+            return false;
+        }
+        uint32_t target = m_globalFunctions.at(callee.name);
+        if (m_ast.functions[target].parameters.size() != expr.items.count) return false;
+        for (NodeIndex argument : m_ast.expressionList(expr.items)) {
+            if (!checkExpr(argument, unit, flow)) return false;
+        }
+        unit.callees.push_back(target);
+        return true;
+    }
+    case ExprKind::String:
+    case ExprKind::List:
+    case ExprKind::Index:
+    case ExprKind::MemberAccess:
+        return false;
+    }
+    return false;
+}
+
+// Collects the outermost top-level loops that qualify, looking inside the
+// ones that do not.
+void NativeCompiler::findLoops(NodeList statements, std::vector<Unit>& units) {
+    for (NodeIndex index : m_ast.statementList(statements)) {
+        const Stmt& stmt = m_ast.stmt(index);
+        switch (stmt.kind) {
+        case StmtKind::While:
+        case StmtKind::For: {
+            Unit unit;
+            unit.isLoop = true;
+            unit.loop = index;
+            Flow flow;
+            if (checkStmt(index, unit, flow, 0)) {
+                unit.variableCount = static_cast<int>(unit.globalNames.size());
+                units.push_back(std::move(unit));
+            } else {
+                findLoops(stmt.body, units);
+            }
+            break;
+        }
+        case StmtKind::If:
+            findLoops(stmt.body, units);
+            findLoops(stmt.orelse, units);
+            break;
+        case StmtKind::Block:
+            findLoops(stmt.body, units);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void NativeCompiler::run(std::vector<std::unique_ptr<JitFunction>>& functions,
+                         std::vector<std::unique_ptr<JitLoop>>& loops, ExecutableMemory& code) {
+    // Functions that qualify on their own, then drop those calling one that
+    // does not until nothing changes
+    uint32_t count = static_cast<uint32_t>(m_ast.functions.size());
+    std::vector<Unit> units(count);
+    std::vector<bool> compiled(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const FunctionDecl& decl = m_ast.functions[i];
+        units[i].function = i;
+        units[i].variableCount = static_cast<int>(decl.locals.size());
+        if (decl.hasNestedFunctions || decl.memoCapacity || decl.parameters.size() > kMaxArity) continue;
+        Flow flow;
+        for (size_t p = 0; p < decl.parameters.size(); ++p) flow.add(static_cast<int>(p));
+        compiled[i] = checkBlock(decl.body, units[i], flow, 0);
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!compiled[i]) continue;
+            for (uint32_t callee : units[i].callees) {
+                if (!compiled[callee]) {
+                    compiled[i] = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    std::vector<Unit> loopUnits;
+    findLoops(m_ast.program, loopUnits);
+
+    // Internal entries first, so calls can refer to them
+    m_functionLabels.assign(count, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (compiled[i]) m_functionLabels[i] = m_asm.newLabel();
+    }
+    std::vector<size_t> functionEntries(count), loopEntries;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!compiled[i]) continue;
+        emitFunction(i, units[i]);
+        functionEntries[i] = m_asm.size();
+        emitFunctionEntry(m_functionLabels[i]);
+    }
+    for (Unit& unit : loopUnits) {
+        loopEntries.push_back(m_asm.size());
+        emitLoop(unit);
+    }
+    m_asm.finish();
+    if (m_asm.size() == 0) return;
+
+    if (!code.assign(m_asm.code())) return;
+    uint8_t* base = code.data();
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!compiled[i]) continue;
+        auto function = std::make_unique<JitFunction>();
+        function->entry = reinterpret_cast<JitFunction::Entry>(base + functionEntries[i]);
+        function->arity = static_cast<uint32_t>(m_ast.functions[i].parameters.size());
+        // Everything reachable must be bound before the native code runs
+        std::vector<bool> seen(count);
+        std::vector<uint32_t> pending = units[i].callees;
+        while (!pending.empty()) {
+            uint32_t callee = pending.back();
+            pending.pop_back();
+            if (seen[callee]) continue;
+            seen[callee] = true;
+            function->callees.emplace_back(m_ast.functions[callee].name, &m_ast.functions[callee]);
+            pending.insert(pending.end(), units[callee].callees.begin(), units[callee].callees.end());
+        }
+        m_ast.functions[i].jit = function.get();
+        functions.push_back(std::move(function));
+    }
+    for (size_t i = 0; i < loopUnits.size(); ++i) {
+        auto loop = std::make_unique<JitLoop>();
+        loop->entry = reinterpret_cast<JitLoop::Entry>(base + loopEntries[i]);
+        loop->variables = loopUnits[i].globalNames;
+        loop->required = loopUnits[i].required;
+        m_ast.stmt(loopUnits[i].loop).jit = loop.get();
+        loops.push_back(std::move(loop));
+    }
+}
+
+// push rbp; mov rbp, rsp; sub rsp, <patched>. Returns the patch offset.
+size_t NativeCompiler::prologue() {
+    m_asm.push(A::RBP);
+    m_asm.movRegReg(A::RBP, A::RSP);
+    m_temps = 0;
+    m_pushed = 0;
+    m_loops.clear();
+    return m_asm.subRsp(0);
+}
+
+// Frames are a multiple of 16 bytes, so rsp stays 16-byte aligned while
+// nothing is pushed.
+void NativeCompiler::frameSize(size_t patch) {
+    int slots = m_reserved + m_unit->variableCount + m_temps;
+    m_asm.patch32(patch, (slots * 8 + 15) / 16 * 16);
+}
+
+// Internal convention: rcx points at the arguments, in order; the result
+// comes back in xmm0 and the status in eax. Only rbp is preserved, and no
+// other register is live across a call.
+void NativeCompiler::emitFunction(uint32_t index, Unit& unit) {
+    const FunctionDecl& decl = m_ast.functions[index];
+    m_unit = &unit;
+    m_reserved = 0;
+    m_body = m_asm.newLabel();
+    m_return = m_asm.newLabel();
+    m_exit = m_asm.newLabel();
+    A::Label tooDeep = m_asm.newLabel();
+
+    m_asm.bind(m_functionLabels[index]);
+    size_t patch = prologue();
+    m_asm.movImm64(A::RAX, reinterpret_cast<uint64_t>(&s_nativeDepth));
+    m_asm.incMem(A::RAX);
+    m_asm.cmpMem(A::RAX, kMaxNativeDepth);
+    m_asm.jcc(A::Greater, tooDeep);
+    for (size_t p = 0; p < decl.parameters.size(); ++p) {
+        m_asm.movsdLoad(A::XMM0, A::RCX, static_cast<int32_t>(8 * p));
+        m_asm.movsdStore(A::RBP, offset(static_cast<int>(p)), A::XMM0);
+    }
+    m_asm.bind(m_body);
+    emitBlock(decl.body);
+    // Falling off the end returns 0
+    m_asm.xorpd(A::XMM0, A::XMM0);
+    m_asm.bind(m_return);
+    m_asm.xorEax();
+    m_asm.bind(m_exit);
+    m_asm.movImm64(A::RDX, reinterpret_cast<uint64_t>(&s_nativeDepth));
+    m_asm.decMem(A::RDX);
+    m_asm.leave();
+    m_asm.ret();
+    m_asm.bind(tooDeep);
+    m_asm.movEax(static_cast<uint32_t>(JitStatus::TooDeep));
+    m_asm.jmp(m_exit);
+    frameSize(patch);
+}
+
+// C entry of a function, int (const double* arguments, double* result):
+// keeps the result pointer in the frame across the call to the internal
+// entry.
+void NativeCompiler::emitFunctionEntry(A::Label internal) {
+    m_asm.push(A::RBP);
+    m_asm.movRegReg(A::RBP, A::RSP);
+    m_asm.subRsp(16);
+#ifdef _WIN32
+    m_asm.movStore(A::RBP, -8, A::RDX);
+#else
+    m_asm.movStore(A::RBP, -8, A::RSI);
+    m_asm.movRegReg(A::RCX, A::RDI);
+#endif
+    m_asm.call(internal);
+    m_asm.movLoad(A::RDX, A::RBP, -8);
+    m_asm.movsdStore(A::RDX, 0, A::XMM0);
+    m_asm.leave();
+    m_asm.ret();
+}
+
+// C entry of a loop, int (double* variables): copies the globals into the
+// frame, runs the loop and copies them back, whatever the status.
+void NativeCompiler::emitLoop(Unit& unit) {
+    m_unit = &unit;
+    m_reserved = 1;  // the variables pointer
+    m_exit = m_asm.newLabel();
+    m_return = m_exit;
+    size_t patch = prologue();
+#ifdef _WIN32
+    m_asm.movStore(A::RBP, -8, A::RCX);
+#else
+    m_asm.movStore(A::RBP, -8, A::RDI);
+    m_asm.movRegReg(A::RCX, A::RDI);
+#endif
+    for (int v = 0; v < unit.variableCount; ++v) {
+        m_asm.movsdLoad(A::XMM0, A::RCX, 8 * v);
+        m_asm.movsdStore(A::RBP, offset(v), A::XMM0);
+    }
+    emitStmt(unit.loop);
+    m_asm.xorEax();
+    m_asm.bind(m_exit);
+    m_asm.movLoad(A::RCX, A::RBP, -8);
+    for (int v = 0; v < unit.variableCount; ++v) {
+        m_asm.movsdLoad(A::XMM0, A::RBP, offset(v));
+        m_asm.movsdStore(A::RCX, 8 * v, A::XMM0);
+    }
+    m_asm.leave();
+    m_asm.ret();
+    frameSize(patch);
+}
+
+void NativeCompiler::loadNumber(A::Xmm reg, double number) {
+    if (bitsOf(number) == 0) {
+        m_asm.xorpd(reg, reg);
+        return;
+    }
+    m_asm.movImm64(A::RAX, bitsOf(number));
+    m_asm.movqFromReg(reg, A::RAX);
+}
+
+bool NativeCompiler::isSimple(NodeIndex index) const {
+    ExprKind kind = m_ast.expr(index).kind;
+    return kind == ExprKind::Number || kind == ExprKind::Variable;
+}
+
+void NativeCompiler::loadSimple(NodeIndex index, A::Xmm reg) {
+    const Expr& expr = m_ast.expr(index);
+    if (expr.kind == ExprKind::Number) loadNumber(reg, expr.number);
+    else m_asm.movsdLoad(reg, A::RBP, variableOffset(expr.name, expr.binding));
+}
+
+void NativeCompiler::pushXmm0() {
+    m_asm.subRsp(8);
+    m_asm.movsdStore(A::RSP, 0, A::XMM0);
+    ++m_pushed;
+}
+
+void NativeCompiler::popXmm1() {
+    m_asm.movsdLoad(A::XMM1, A::RSP, 0);
+    m_asm.addRsp(8);
+    --m_pushed;
+}
+
+// Left operand into xmm0, right into xmm1. A number or a variable is loaded
+// straight into its register; anything else goes through the stack.
+void NativeCompiler::operands(const Expr& expr) {
+    if (isSimple(expr.right)) {
+        emitExpr(expr.left);
+        loadSimple(expr.right, A::XMM1);
+    } else if (isSimple(expr.left)) {
+        emitExpr(expr.right);
+        m_asm.movapd(A::XMM1, A::XMM0);
+        loadSimple(expr.left, A::XMM0);
+    } else {
+        emitExpr(expr.right);
+        pushXmm0();
+        emitExpr(expr.left);
+        popXmm1();
+    }
+}
+
+// Calls a C function of (xmm0, xmm1) with the stack aligned and 32 bytes
+// of shadow space, which Windows requires and System V ignores.
+void NativeCompiler::callHelper(double (*helper)(double, double)) {
+    int32_t reserve = 32 + (m_pushed % 2 ? 8 : 0);
+    m_asm.subRsp(reserve);
+    m_asm.movImm64(A::RAX, reinterpret_cast<uint64_t>(helper));
+    m_asm.callReg(A::RAX);
+    m_asm.addRsp(reserve);
+}
+
+void NativeCompiler::emitBlock(NodeList statements) {
+    for (NodeIndex index : m_ast.statementList(statements)) emitStmt(index);
+}
+
+void NativeCompiler::emitStmt(NodeIndex index) {
+    const Stmt& stmt = m_ast.stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+        emitExpr(stmt.expr);
+        break;
+    case StmtKind::Assign:
+        emitExpr(stmt.expr);
+        m_asm.movsdStore(A::RBP, variableOffset(stmt.name, stmt.binding), A::XMM0);
+        break;
+    case StmtKind::If: {
+        A::Label orelse = m_asm.newLabel();
+        A::Label end = m_asm.newLabel();
+        emitBranchIfFalse(stmt.expr, orelse);
+        emitBlock(stmt.body);
+        if (!stmt.orelse.empty()) m_asm.jmp(end);
+        m_asm.bind(orelse);
+        emitBlock(stmt.orelse);
+        m_asm.bind(end);
+        break;
+    }
+    case StmtKind::While: {
+        A::Label top = m_asm.newLabel();
+        A::Label exit = m_asm.newLabel();
+        m_asm.bind(top);
+        emitBranchIfFalse(stmt.expr, exit);
+        m_loops.push_back({exit, top});
+        emitBlock(stmt.body);
+        m_loops.pop_back();
+        m_asm.jmp(top);
+        m_asm.bind(exit);
+        break;
+    }
+    case StmtKind::For:
+        emitFor(stmt);
+        break;
+    case StmtKind::Block:
+        emitBlock(stmt.body);
+        break;
+    case StmtKind::Break:
+        m_asm.jmp(m_loops.back().exit);
+        break;
+    case StmtKind::Continue:
+        m_asm.jmp(m_loops.back().next);
+        break;
+    case StmtKind::Return:
+        if (stmt.expr == kNoNode) m_asm.xorpd(A::XMM0, A::XMM0);
+        else if (stmt.tailCall) emitCall(m_ast.expr(stmt.expr), true);
+        else emitExpr(stmt.expr);
+        m_asm.jmp(m_return);
+        break;
+    case StmtKind::FunctionDef:
+        throw std::logic_error("function definition in native code");
+    }
+}
+
+void NativeCompiler::emitExpr(NodeIndex index) {
+    const Expr& expr = m_ast.expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+    case ExprKind::Variable:
+        loadSimple(index, A::XMM0);
+        break;
+    case ExprKind::Binary:
+        operands(expr);
+        emitBinary(expr.op);
+        break;
+    case ExprKind::Unary:
+        emitExpr(expr.left);
+        if (expr.op == TokenType::Minus) {
+            loadNumber(A::XMM1, -0.0);
+            m_asm.xorpd(A::XMM0, A::XMM1);
+        } else {
+            m_asm.xorpd(A::XMM1, A::XMM1);
+            m_asm.cmpsd(A::XMM0, A::XMM1, A::CmpEqual);
+            loadNumber(A::XMM1, 1.0);
+            m_asm.andpd(A::XMM0, A::XMM1);
+        }
+        break;
+    case ExprKind::Assign:
+        emitExpr(expr.left);
+        m_asm.movsdStore(A::RBP, variableOffset(expr.name, expr.binding), A::XMM0);
+        break;
+    case ExprKind::Call:
+        emitCall(expr, false);
+        break;
+    default:
+        throw std::logic_error("expression kind not supported in native code");
+    }
+}
+
+// xmm0 = xmm0 op xmm1, with the results of NumberKernel. Comparisons and
+// logical operators build an all-ones mask with cmpsd and keep 1.0 with it.
+void NativeCompiler::emitBinary(TokenType op) {
+    switch (op) {
+    case TokenType::Plus: m_asm.addsd(A::XMM0, A::XMM1); return;
+    case TokenType::Minus: m_asm.subsd(A::XMM0, A::XMM1); return;
+    case TokenType::Star: m_asm.mulsd(A::XMM0, A::XMM1); return;
+    case TokenType::Slash: m_asm.divsd(A::XMM0, A::XMM1); return;
+    case TokenType::Percent: callHelper(&jitFmod); return;
+    case TokenType::Power: callHelper(&jitPow); return;
+    case TokenType::Equal: m_asm.cmpsd(A::XMM0, A::XMM1, A::CmpEqual); break;
+    case TokenType::NotEqual: m_asm.cmpsd(A::XMM0, A::XMM1, A::CmpNotEqual); break;
+    case TokenType::Less: m_asm.cmpsd(A::XMM0, A::XMM1, A::CmpLess); break;
+    case TokenType::LessEqual: m_asm.cmpsd(A::XMM0, A::XMM1, A::CmpLessEqual); break;
+    case TokenType::Greater:
+        m_asm.cmpsd(A::XMM1, A::XMM0, A::CmpLess);
+        m_asm.movapd(A::XMM0, A::XMM1);
+        break;
+    case TokenType::GreaterEqual:
+        m_asm.cmpsd(A::XMM1, A::XMM0, A::CmpLessEqual);
+        m_asm.movapd(A::XMM0, A::XMM1);
+        break;
+    case TokenType::And:
+    case TokenType::Or:
+        // Truthy is != 0, which holds for NaN as in C++
+        m_asm.xorpd(A::XMM2, A::XMM2);
+        m_asm.cmpsd(A::XMM0, A::XMM2, A::CmpNotEqual);
+        m_asm.cmpsd(A::XMM1, A::XMM2, A::CmpNotEqual);
+        if (op == TokenType::And) m_asm.andpd(A::XMM0, A::XMM1);
+        else m_asm.orpd(A::XMM0, A::XMM1);
+        break;
+    default:
+        throw std::logic_error("operator not supported in native code");
+    }
+    loadNumber(A::XMM1, 1.0);
+    m_asm.andpd(A::XMM0, A::XMM1);
+}
+
+// Arguments are evaluated last to first and pushed, so the first ends up
+// at rsp. Nothing they do can be observed, so the order is free. A tail
+// call of the function itself reuses the frame instead.
+void NativeCompiler::emitCall(const Expr& expr, bool tail) {
+    uint32_t target = m_globalFunctions.at(m_ast.expr(expr.left).name);
+    NodeSpan arguments = m_ast.expressionList(expr.items);
+    int count = static_cast<int>(arguments.size());
+    bool self = tail && target == m_unit->function;
+    int pad = !self && (m_pushed + count) % 2 ? 1 : 0;
+    if (pad) {
+        m_asm.subRsp(8);
+        ++m_pushed;
+    }
+    for (int i = count; i-- > 0;) {
+        emitExpr(arguments[i]);
+        pushXmm0();
+    }
+    if (self) {
+        for (int p = 0; p < count; ++p) {
+            m_asm.movsdLoad(A::XMM0, A::RSP, 8 * p);
+            m_asm.movsdStore(A::RBP, offset(p), A::XMM0);
+        }
+        if (count) m_asm.addRsp(8 * count);
+        m_pushed -= count;
+        m_asm.jmp(m_body);
+        return;
+    }
+    m_asm.movRegReg(A::RCX, A::RSP);
+    m_asm.call(m_functionLabels[target]);
+    if (count + pad) m_asm.addRsp(8 * (count + pad));
+    m_pushed -= count + pad;
+    // A callee that gave up: so does this code (leave drops what is pushed)
+    m_asm.testEax();
+    m_asm.jcc(A::NotEqual, m_exit);
+}
+
+// Counts like RangeCounter: the value is stepped in a hidden slot and
+// copied into the loop variable, which the body may change freely.
+void NativeCompiler::emitFor(const Stmt& stmt) {
+    NodeSpan arguments = m_ast.expressionList(m_ast.expr(stmt.expr).items);
+    int current = newTemp();
+    int stop = newTemp();
+    int step = newTemp();
+    if (arguments.size() == 1) {
+        loadNumber(A::XMM0, 0.0);
+        m_asm.movsdStore(A::RBP, offset(current), A::XMM0);
+        emitExpr(arguments[0]);
+        m_asm.movsdStore(A::RBP, offset(stop), A::XMM0);
+    } else {
+        emitExpr(arguments[0]);
+        m_asm.movsdStore(A::RBP, offset(current), A::XMM0);
+        emitExpr(arguments[1]);
+        m_asm.movsdStore(A::RBP, offset(stop), A::XMM0);
+    }
+    int direction = 1;  // sign of the step, 0 if only known at run time
+    if (arguments.size() == 3) {
+        const Expr& stepExpr = m_ast.expr(arguments[2]);
+        direction = stepExpr.kind != ExprKind::Number ? 0 : stepExpr.number > 0 ? 1 : -1;
+        emitExpr(arguments[2]);
+        m_asm.movsdStore(A::RBP, offset(step), A::XMM0);
+        A::Label nonZero = m_asm.newLabel();
+        m_asm.xorpd(A::XMM1, A::XMM1);
+        m_asm.ucomisd(A::XMM0, A::XMM1);
+        m_asm.jcc(A::NotEqual, nonZero);
+        m_asm.jcc(A::Parity, nonZero);
+        m_asm.movEax(static_cast<uint32_t>(JitStatus::ZeroStep));
+        m_asm.jmp(m_exit);
+        m_asm.bind(nonZero);
+    } else {
+        loadNumber(A::XMM0, 1.0);
+        m_asm.movsdStore(A::RBP, offset(step), A::XMM0);
+    }
+
+    A::Label top = m_asm.newLabel();
+    A::Label body = m_asm.newLabel();
+    A::Label exit = m_asm.newLabel();
+    m_asm.bind(top);
+    m_asm.movsdLoad(A::XMM0, A::RBP, offset(current));
+    m_asm.movsdLoad(A::XMM1, A::RBP, offset(stop));
+    // Forward while stop > current, backward while current > stop; jbe
+    // also leaves on NaN
+    if (direction > 0) {
+        m_asm.ucomisd(A::XMM1, A::XMM0);
+        m_asm.jcc(A::BelowEqual, exit);
+    } else if (direction < 0) {
+        m_asm.ucomisd(A::XMM0, A::XMM1);
+        m_asm.jcc(A::BelowEqual, exit);
+    } else {
+        A::Label backward = m_asm.newLabel();
+        m_asm.movsdLoad(A::XMM2, A::RBP, offset(step));
+        m_asm.xorpd(A::XMM3, A::XMM3);
+        m_asm.ucomisd(A::XMM2, A::XMM3);
+        m_asm.jcc(A::BelowEqual, backward);
+        m_asm.ucomisd(A::XMM1, A::XMM0);
+        m_asm.jcc(A::BelowEqual, exit);
+        m_asm.jmp(body);
+        m_asm.bind(backward);
+        m_asm.ucomisd(A::XMM0, A::XMM1);
+        m_asm.jcc(A::BelowEqual, exit);
+    }
+    m_asm.bind(body);
+    m_asm.movsdStore(A::RBP, variableOffset(stmt.name, stmt.binding), A::XMM0);
+    m_asm.movsdLoad(A::XMM1, A::RBP, offset(step));
+    m_asm.addsd(A::XMM0, A::XMM1);
+    m_asm.movsdStore(A::RBP, offset(current), A::XMM0);
+    m_loops.push_back({exit, top});
+    emitBlock(stmt.body);
+    m_loops.pop_back();
+    m_asm.jmp(top);
+    m_asm.bind(exit);
+}
+
+// Jumps to target unless the condition is truthy. A comparison branches on
+// ucomisd flags directly; unordered operands compare false except for !=.
+void NativeCompiler::emitBranchIfFalse(NodeIndex condition, A::Label target) {
+    const Expr& expr = m_ast.expr(condition);
+    if (expr.kind == ExprKind::Binary) {
+        switch (expr.op) {
+        case TokenType::Less:
+        case TokenType::LessEqual:
+            operands(expr);
+            m_asm.ucomisd(A::XMM1, A::XMM0);
+            m_asm.jcc(expr.op == TokenType::Less ? A::BelowEqual : A::Below, target);
+            return;
+        case TokenType::Greater:
+        case TokenType::GreaterEqual:
+            operands(expr);
+            m_asm.ucomisd(A::XMM0, A::XMM1);
+            m_asm.jcc(expr.op == TokenType::Greater ? A::BelowEqual : A::Below, target);
+            return;
+        case TokenType::Equal:
+            operands(expr);
+            m_asm.ucomisd(A::XMM0, A::XMM1);
+            m_asm.jcc(A::NotEqual, target);
+            m_asm.jcc(A::Parity, target);
+            return;
+        case TokenType::NotEqual: {
+            A::Label taken = m_asm.newLabel();
+            operands(expr);
+            m_asm.ucomisd(A::XMM0, A::XMM1);
+            m_asm.jcc(A::Parity, taken);
+            m_asm.jcc(A::Equal, target);
+            m_asm.bind(taken);
+            return;
+        }
+        default:
+            break;
+        }
+    }
+    A::Label taken = m_asm.newLabel();
+    emitExpr(condition);
+    m_asm.xorpd(A::XMM1, A::XMM1);
+    m_asm.ucomisd(A::XMM0, A::XMM1);
+    m_asm.jcc(A::Parity, taken);
+    m_asm.jcc(A::Equal, target);
+    m_asm.bind(taken);
+}
+
+} // namespace
+
+#endif // JIT_X86_64
+
+Jit::Jit() = default;
+
+Jit::~Jit() = default;
+
+bool Jit::available() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Jit::compile(Ast& ast) {
+#ifdef JIT_X86_64
+    NativeCompiler compiler(ast);
+    compiler.run(m_functions, m_loops, m_code);
+    jitStats().functions += m_functions.size();
+    jitStats().loops += m_loops.size();
+    jitStats().codeBytes += m_code.size();
+#else
+    (void)ast;
+#endif
+}
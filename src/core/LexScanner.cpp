@@ -0,0 +1,228 @@
+#include "core/LexScanner.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LEX_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Scalar ---
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool isIdentifierChar(char c) {
+    char lower = static_cast<char>(c | 0x20);
+    return (lower >= 'a' && lower <= 'z') || isDigit(c) || c == '_';
+}
+
+static const char* scalarSkipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+static const char* scalarSkipIdentifier(const char* p, const char* end) {
+    while (p < end && isIdentifierChar(*p)) ++p;
+    return p;
+}
+
+static const char* scalarSkipDigits(const char* p, const char* end) {
+    while (p < end && isDigit(*p)) ++p;
+    return p;
+}
+
+static const char* scalarFindNewline(const char* p, const char* end) {
+    while (p < end && *p != '\n') ++p;
+    return p;
+}
+
+static const char* scalarFindStringStop(const char* p, const char* end, char quote) {
+    while (p < end && *p != quote && *p != '\\' && *p != '\n') ++p;
+    return p;
+}
+
+static const LexScanner kScalarScanner = {
+    "scalar", scalarSkipBlanks, scalarSkipIdentifier, scalarSkipDigits,
+    scalarFindNewline, scalarFindStringStop,
+};
+
+#ifdef LEX_SCANNER_X86
+// Each vector routine builds a byte mask of the characters that belong to
+// the run (skip*) or that stop it (find*), and jumps to the first stop with
+// a count of trailing zeros. The last partial block is left to the scalar
+// loop so that no load reads past end.
+
+// --- SSE2 (always present on x86-64) ---
+// Signed compares are enough: bytes >= 0x80 are negative and never match a
+// range of ASCII characters.
+static inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+static inline __m128i equals16(__m128i v, char c) {
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+static inline __m128i load16(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static const char* sse2SkipBlanks(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        __m128i v = load16(p);
+        __m128i blank = _mm_or_si128(_mm_or_si128(equals16(v, ' '), equals16(v, '\t')), equals16(v, '\r'));
+        unsigned stops = ~static_cast<unsigned>(_mm_movemask_epi8(blank)) & 0xFFFFu;
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return scalarSkipBlanks(p, end);
+}
+
+static const char* sse2SkipIdentifier(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        __m128i v = load16(p);
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i ident = _mm_or_si128(_mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(v, '0', '9')),
+                                     equals16(v, '_'));
+        unsigned stops = ~static_cast<unsigned>(_mm_movemask_epi8(ident)) & 0xFFFFu;
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return scalarSkipIdentifier(p, end);
+}
+
+static const char* sse2SkipDigits(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        unsigned stops = ~static_cast<unsigned>(_mm_movemask_epi8(inRange16(load16(p), '0', '9'))) & 0xFFFFu;
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return scalarSkipDigits(p, end);
+}
+
+static const char* sse2FindNewline(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        unsigned stops = static_cast<unsigned>(_mm_movemask_epi8(equals16(load16(p), '\n')));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return scalarFindNewline(p, end);
+}
+
+static const char* sse2FindStringStop(const char* p, const char* end, char quote) {
+    for (; end - p >= 16; p += 16) {
+        __m128i v = load16(p);
+        __m128i stop = _mm_or_si128(_mm_or_si128(equals16(v, quote), equals16(v, '\\')), equals16(v, '\n'));
+        unsigned stops = static_cast<unsigned>(_mm_movemask_epi8(stop));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return scalarFindStringStop(p, end, quote);
+}
+
+static const LexScanner kSse2Scanner = {
+    "sse2", sse2SkipBlanks, sse2SkipIdentifier, sse2SkipDigits,
+    sse2FindNewline, sse2FindStringStop,
+};
+
+// --- AVX2 (compiled for the target ISA only inside these functions) ---
+#define LEX_AVX2 __attribute__((target("avx2")))
+
+LEX_AVX2 static inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+LEX_AVX2 static inline __m256i equals32(__m256i v, char c) {
+    return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+LEX_AVX2 static inline __m256i load32(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+LEX_AVX2 static const char* avx2SkipBlanks(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        __m256i v = load32(p);
+        __m256i blank = _mm256_or_si256(_mm256_or_si256(equals32(v, ' '), equals32(v, '\t')), equals32(v, '\r'));
+        unsigned stops = ~static_cast<unsigned>(_mm256_movemask_epi8(blank));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return sse2SkipBlanks(p, end);
+}
+
+LEX_AVX2 static const char* avx2SkipIdentifier(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        __m256i v = load32(p);
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(v, '0', '9')),
+                                        equals32(v, '_'));
+        unsigned stops = ~static_cast<unsigned>(_mm256_movemask_epi8(ident));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return sse2SkipIdentifier(p, end);
+}
+
+LEX_AVX2 static const char* avx2SkipDigits(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        unsigned stops = ~static_cast<unsigned>(_mm256_movemask_epi8(inRange32(load32(p), '0', '9')));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return sse2SkipDigits(p, end);
+}
+
+LEX_AVX2 static const char* avx2FindNewline(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        unsigned stops = static_cast<unsigned>(_mm256_movemask_epi8(equals32(load32(p), '\n')));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return sse2FindNewline(p, end);
+}
+
+LEX_AVX2 static const char* avx2FindStringStop(const char* p, const char* end, char quote) {
+    for (; end - p >= 32; p += 32) {
+        __m256i v = load32(p);
+        __m256i stop = _mm256_or_si256(_mm256_or_si256(equals32(v, quote), equals32(v, '\\')), equals32(v, '\n'));
+        unsigned stops = static_cast<unsigned>(_mm256_movemask_epi8(stop));
+        if (stops) return p + __builtin_ctz(stops);
+    }
+    return sse2FindStringStop(p, end, quote);
+}
+
+static const LexScanner kAvx2Scanner = {
+    "avx2", avx2SkipBlanks, avx2SkipIdentifier, avx2SkipDigits,
+    avx2FindNewline, avx2FindStringStop,
+};
+#endif // LEX_SCANNER_X86
+
+static const LexScanner* detectScanner() {
+#ifdef LEX_SCANNER_X86
+    if (__builtin_cpu_supports("avx2")) return &kAvx2Scanner;
+    return &kSse2Scanner;
+#else
+    return &kScalarScanner;
+#endif
+}
+
+static const LexScanner* s_scanner = detectScanner();
+
+const LexScanner& lexScanner() {
+    return *s_scanner;
+}
+
+bool selectLexScanner(const std::string& name) {
+    if (name == "scalar") {
+        s_scanner = &kScalarScanner;
+        return true;
+    }
+#ifdef LEX_SCANNER_X86
+    if (name == "sse2") {
+        s_scanner = &kSse2Scanner;
+        return true;
+    }
+    if (name == "avx2" && __builtin_cpu_supports("avx2")) {
+        s_scanner = &kAvx2Scanner;
+        return true;
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,58 @@
+#include <cstring>
+#include "core/MemoTable.h"
+#include "objects/StringObject.h"
+
+// Numbers are 'n' plus their bit pattern, so -0 and 0 stay apart; strings
+// are 's', their length and their bytes.
+bool MemoTable::makeKey(const Value* arguments, size_t count, std::string& key) {
+    key.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const Value& argument = arguments[i];
+        if (argument.is_number()) {
+            double number = argument.as_number();
+            char bits[sizeof(number)];
+            std::memcpy(bits, &number, sizeof(number));
+            key += 'n';
+            key.append(bits, sizeof(bits));
+        } else if (auto str = argument.as<StringObject>()) {
+            uint32_t length = static_cast<uint32_t>(str->value.size());
+            char bytes[sizeof(length)];
+            std::memcpy(bytes, &length, sizeof(length));
+            key += 's';
+            key.append(bytes, sizeof(bytes));
+            key += str->value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+const Value* MemoTable::find(const std::string& key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        ++memoStats().misses;
+        return nullptr;
+    }
+    ++memoStats().hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->result;
+}
+
+void MemoTable::store(const std::string& key, const Value& result) {
+    if (!result.is_number() && !result.as<StringObject>()) return;
+    // A recursive call may have stored the same arguments already
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->result = result;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+    if (m_entries.size() >= m_capacity) {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+        ++memoStats().evictions;
+    }
+    m_entries.push_front({key, result});
+    m_index.emplace(m_entries.front().key, m_entries.begin());
+}
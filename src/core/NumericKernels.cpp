@@ -0,0 +1,360 @@
+#include "core/NumericKernels.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define NUMERIC_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+static constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// --- Scalar ---
+static double scalarSum(const double* p, size_t n) {
+    double total = 0;
+    for (size_t i = 0; i < n; ++i) total += p[i];
+    return total;
+}
+
+static double scalarMin(const double* p, size_t n) {
+    double result = p[0];
+    bool nan = false;
+    for (size_t i = 0; i < n; ++i) {
+        nan |= p[i] != p[i];
+        if (p[i] < result) result = p[i];
+    }
+    return nan ? kNaN : result;
+}
+
+static double scalarMax(const double* p, size_t n) {
+    double result = p[0];
+    bool nan = false;
+    for (size_t i = 0; i < n; ++i) {
+        nan |= p[i] != p[i];
+        if (p[i] > result) result = p[i];
+    }
+    return nan ? kNaN : result;
+}
+
+static double scalarDot(const double* a, const double* b, size_t n) {
+    double total = 0;
+    for (size_t i = 0; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+// --- Matrix product ---
+// Blocked so that a kKC x kNC panel of b stays in cache while every block of
+// MR rows of a runs over it, and those rows stay in L1 across the panel.
+// Micro computes an MR x NR block of c in registers; the edges of c that do
+// not fill a block go through the scalar loop. Either way each element of
+// c adds its products in increasing k, with a separate multiply and add, so
+// every kernel set computes the same bits.
+constexpr size_t kKC = 256;
+constexpr size_t kNC = 256;
+
+using MicroKernel = void (*)(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc,
+                             size_t kc);
+
+// One element of c: a row of a against a column of b.
+static void scalarEdge(const double* a, const double* b, size_t ldb, double* c, size_t kc) {
+    double total = *c;
+    for (size_t k = 0; k < kc; ++k) total += a[k] * b[k * ldb];
+    *c = total;
+}
+
+template <size_t MR, size_t NR>
+static void blockedMatmul(MicroKernel micro, const double* a, const double* b, double* c, size_t n, size_t m,
+                          size_t p) {
+    for (size_t jc = 0; jc < p; jc += kNC) {
+        size_t jend = std::min(jc + kNC, p);
+        for (size_t kc0 = 0; kc0 < m; kc0 += kKC) {
+            size_t kc = std::min(kKC, m - kc0);
+            for (size_t i = 0; i < n; i += MR) {
+                size_t mr = std::min(MR, n - i);
+                size_t j = jc;
+                if (mr == MR) {
+                    for (; j + NR <= jend; j += NR) {
+                        micro(a + i * m + kc0, m, b + kc0 * p + j, p, c + i * p + j, p, kc);
+                    }
+                }
+                for (size_t r = 0; r < mr; ++r) {
+                    for (size_t jj = j; jj < jend; ++jj) {
+                        scalarEdge(a + (i + r) * m + kc0, b + kc0 * p + jj, p, c + (i + r) * p + jj, kc);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void scalarMicro(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t kc) {
+    for (size_t r = 0; r < 4; ++r) {
+        double c0 = c[r * ldc], c1 = c[r * ldc + 1], c2 = c[r * ldc + 2], c3 = c[r * ldc + 3];
+        for (size_t k = 0; k < kc; ++k) {
+            double x = a[r * lda + k];
+            const double* row = b + k * ldb;
+            c0 += x * row[0];
+            c1 += x * row[1];
+            c2 += x * row[2];
+            c3 += x * row[3];
+        }
+        c[r * ldc] = c0;
+        c[r * ldc + 1] = c1;
+        c[r * ldc + 2] = c2;
+        c[r * ldc + 3] = c3;
+    }
+}
+
+static void scalarMatmul(const double* a, const double* b, double* c, size_t n, size_t m, size_t p) {
+    blockedMatmul<4, 4>(scalarMicro, a, b, c, n, m, p);
+}
+
+static const NumericKernels kScalarKernels = {"scalar", scalarSum, scalarMin, scalarMax, scalarDot, scalarMatmul};
+
+#ifdef NUMERIC_KERNELS_X86
+// Each vector routine runs its accumulators over whole blocks, folds them
+// into one, and leaves the last partial block to a scalar loop so that no
+// load reads past the end. min and max keep a mask of the lanes that saw a
+// NaN, since the min/max instructions drop NaN operands.
+
+// --- SSE2 (always present on x86-64) ---
+static inline double lanes2(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static double sse2Sum(const double* p, size_t n) {
+    __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(p + i));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(p + i + 2));
+    }
+    double total = lanes2(_mm_add_pd(a0, a1));
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+template <bool Min>
+static inline __m128d extreme2(__m128d a, __m128d b) {
+    return Min ? _mm_min_pd(a, b) : _mm_max_pd(a, b);
+}
+
+template <bool Min>
+static double sse2Extreme(const double* p, size_t n) {
+    __m128d a0 = _mm_set1_pd(p[0]), a1 = a0;
+    __m128d nan = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128d v0 = _mm_loadu_pd(p + i), v1 = _mm_loadu_pd(p + i + 2);
+        nan = _mm_or_pd(nan, _mm_cmpunord_pd(v0, v1));
+        a0 = extreme2<Min>(v0, a0);
+        a1 = extreme2<Min>(v1, a1);
+    }
+    if (_mm_movemask_pd(nan)) return kNaN;
+    double lanes[2];
+    _mm_storeu_pd(lanes, extreme2<Min>(a0, a1));
+    double result = Min ? (lanes[1] < lanes[0] ? lanes[1] : lanes[0]) : (lanes[1] > lanes[0] ? lanes[1] : lanes[0]);
+    for (; i < n; ++i) {
+        if (p[i] != p[i]) return kNaN;
+        if (Min ? p[i] < result : p[i] > result) result = p[i];
+    }
+    return result;
+}
+
+static double sse2Min(const double* p, size_t n) {
+    return sse2Extreme<true>(p, n);
+}
+
+static double sse2Max(const double* p, size_t n) {
+    return sse2Extreme<false>(p, n);
+}
+
+static double sse2Dot(const double* a, const double* b, size_t n) {
+    __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double total = lanes2(_mm_add_pd(a0, a1));
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+// 4 x 4 block of c in eight registers
+static void sse2Micro(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t kc) {
+    __m128d acc[4][2];
+    for (size_t r = 0; r < 4; ++r) {
+        acc[r][0] = _mm_loadu_pd(c + r * ldc);
+        acc[r][1] = _mm_loadu_pd(c + r * ldc + 2);
+    }
+    for (size_t k = 0; k < kc; ++k) {
+        __m128d b0 = _mm_loadu_pd(b + k * ldb), b1 = _mm_loadu_pd(b + k * ldb + 2);
+        for (size_t r = 0; r < 4; ++r) {
+            __m128d x = _mm_set1_pd(a[r * lda + k]);
+            acc[r][0] = _mm_add_pd(acc[r][0], _mm_mul_pd(x, b0));
+            acc[r][1] = _mm_add_pd(acc[r][1], _mm_mul_pd(x, b1));
+        }
+    }
+    for (size_t r = 0; r < 4; ++r) {
+        _mm_storeu_pd(c + r * ldc, acc[r][0]);
+        _mm_storeu_pd(c + r * ldc + 2, acc[r][1]);
+    }
+}
+
+static void sse2Matmul(const double* a, const double* b, double* c, size_t n, size_t m, size_t p) {
+    blockedMatmul<4, 4>(sse2Micro, a, b, c, n, m, p);
+}
+
+static const NumericKernels kSse2Kernels = {"sse2", sse2Sum, sse2Min, sse2Max, sse2Dot, sse2Matmul};
+
+// --- AVX2 (compiled for the target ISA only inside these functions) ---
+#define NUMERIC_AVX2 __attribute__((target("avx2")))
+
+NUMERIC_AVX2 static inline double lanes4(__m256d v) {
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return lanes2(half);
+}
+
+NUMERIC_AVX2 static double avx2Sum(const double* p, size_t n) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+    __m256d a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(p + i + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(p + i + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(p + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+    double total = lanes4(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+template <bool Min>
+NUMERIC_AVX2 static inline __m256d extreme4(__m256d a, __m256d b) {
+    return Min ? _mm256_min_pd(a, b) : _mm256_max_pd(a, b);
+}
+
+template <bool Min>
+NUMERIC_AVX2 static double avx2Extreme(const double* p, size_t n) {
+    __m256d a0 = _mm256_set1_pd(p[0]), a1 = a0, a2 = a0, a3 = a0;
+    __m256d nan = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d v0 = _mm256_loadu_pd(p + i), v1 = _mm256_loadu_pd(p + i + 4);
+        __m256d v2 = _mm256_loadu_pd(p + i + 8), v3 = _mm256_loadu_pd(p + i + 12);
+        nan = _mm256_or_pd(nan, _mm256_or_pd(_mm256_cmp_pd(v0, v1, _CMP_UNORD_Q),
+                                             _mm256_cmp_pd(v2, v3, _CMP_UNORD_Q)));
+        a0 = extreme4<Min>(v0, a0);
+        a1 = extreme4<Min>(v1, a1);
+        a2 = extreme4<Min>(v2, a2);
+        a3 = extreme4<Min>(v3, a3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(p + i);
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+        a0 = extreme4<Min>(v, a0);
+    }
+    if (_mm256_movemask_pd(nan)) return kNaN;
+    double lanes[4];
+    _mm256_storeu_pd(lanes, extreme4<Min>(extreme4<Min>(a0, a1), extreme4<Min>(a2, a3)));
+    double result = lanes[0];
+    for (double lane : lanes) {
+        if (Min ? lane < result : lane > result) result = lane;
+    }
+    for (; i < n; ++i) {
+        if (p[i] != p[i]) return kNaN;
+        if (Min ? p[i] < result : p[i] > result) result = p[i];
+    }
+    return result;
+}
+
+NUMERIC_AVX2 static double avx2Min(const double* p, size_t n) {
+    return avx2Extreme<true>(p, n);
+}
+
+NUMERIC_AVX2 static double avx2Max(const double* p, size_t n) {
+    return avx2Extreme<false>(p, n);
+}
+
+NUMERIC_AVX2 static double avx2Dot(const double* a, const double* b, size_t n) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+    __m256d a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        a1 = _mm256_add_pd(a1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+        a2 = _mm256_add_pd(a2, _mm256_mul_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8)));
+        a3 = _mm256_add_pd(a3, _mm256_mul_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12)));
+    }
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm256_add_pd(a0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    double total = lanes4(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+// 4 x 8 block of c in eight registers
+NUMERIC_AVX2 static void avx2Micro(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc,
+                                   size_t kc) {
+    __m256d acc[4][2];
+    for (size_t r = 0; r < 4; ++r) {
+        acc[r][0] = _mm256_loadu_pd(c + r * ldc);
+        acc[r][1] = _mm256_loadu_pd(c + r * ldc + 4);
+    }
+    for (size_t k = 0; k < kc; ++k) {
+        __m256d b0 = _mm256_loadu_pd(b + k * ldb), b1 = _mm256_loadu_pd(b + k * ldb + 4);
+        for (size_t r = 0; r < 4; ++r) {
+            __m256d x = _mm256_broadcast_sd(a + r * lda + k);
+            acc[r][0] = _mm256_add_pd(acc[r][0], _mm256_mul_pd(x, b0));
+            acc[r][1] = _mm256_add_pd(acc[r][1], _mm256_mul_pd(x, b1));
+        }
+    }
+    for (size_t r = 0; r < 4; ++r) {
+        _mm256_storeu_pd(c + r * ldc, acc[r][0]);
+        _mm256_storeu_pd(c + r * ldc + 4, acc[r][1]);
+    }
+}
+
+static void avx2Matmul(const double* a, const double* b, double* c, size_t n, size_t m, size_t p) {
+    blockedMatmul<4, 8>(avx2Micro, a, b, c, n, m, p);
+}
+
+static const NumericKernels kAvx2Kernels = {"avx2", avx2Sum, avx2Min, avx2Max, avx2Dot, avx2Matmul};
+#endif // NUMERIC_KERNELS_X86
+
+static const NumericKernels* detectKernels() {
+#ifdef NUMERIC_KERNELS_X86
+    if (__builtin_cpu_supports("avx2")) return &kAvx2Kernels;
+    return &kSse2Kernels;
+#else
+    return &kScalarKernels;
+#endif
+}
+
+static const NumericKernels* s_kernels = detectKernels();
+
+const NumericKernels& numericKernels() {
+    return *s_kernels;
+}
+
+bool selectNumericKernels(const std::string& name) {
+    if (name == "scalar") {
+        s_kernels = &kScalarKernels;
+        return true;
+    }
+#ifdef NUMERIC_KERNELS_X86
+    if (name == "sse2") {
+        s_kernels = &kSse2Kernels;
+        return true;
+    }
+    if (name == "avx2" && __builtin_cpu_supports("avx2")) {
+        s_kernels = &kAvx2Kernels;
+        return true;
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,210 @@
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include "core/Operations.h"
+#include "objects/ArrayObject.h"
+#include "objects/StringObject.h"
+#include "objects/ListObject.h"
+#include "objects/RangeObject.h"
+#include "objects/ObjectPool.h"
+
+// Operand types the kernel table distinguishes.
+enum class OperandKind : uint8_t { Number, String, Array, Other };
+constexpr size_t kOperandKinds = 4;
+
+static OperandKind operandKind(const Value& value) {
+    if (value.is_number()) return OperandKind::Number;
+    if (value.as<StringObject>()) return OperandKind::String;
+    if (value.as<ArrayObject>()) return OperandKind::Array;
+    return OperandKind::Other;
+}
+
+static std::string shapeText(const ArrayObject& array) {
+    if (array.dims() == 1) return std::to_string(array.rows());
+    return std::to_string(array.rows()) + "x" + std::to_string(array.cols());
+}
+
+static Value makeArray(std::shared_ptr<const ArrayObject::Buffer> buffer, const ArrayObject& like) {
+    if (like.dims() == 1) return makePooled<ArrayObject>(std::move(buffer));
+    return makePooled<ArrayObject>(std::move(buffer), like.rows(), like.cols());
+}
+
+// Op applied element by element to two arrays of the same shape, or to an
+// array and a number. The result is a new row-major array; operands that
+// are views with gaps are copied first, so the loops run over contiguous
+// memory and the compiler vectorizes the simple operators.
+template <TokenType Op>
+static Value elementwise(const Value& left, const Value& right) {
+    const ArrayObject* a = left.as<ArrayObject>();
+    const ArrayObject* b = right.as<ArrayObject>();
+    if (a && b && (a->dims() != b->dims() || a->rows() != b->rows() || a->cols() != b->cols())) {
+        throw std::runtime_error("Array shapes do not match: " + shapeText(*a) + " and " + shapeText(*b));
+    }
+    const ArrayObject& shape = a ? *a : *b;
+    size_t n = shape.size();
+    auto result = std::make_shared<ArrayObject::Buffer>(n);
+    double* out = result->data();
+    ArrayObject::Buffer scratchA, scratchB;
+    if (a && b) {
+        const double* x = a->rowMajor(scratchA);
+        const double* y = b->rowMajor(scratchB);
+        for (size_t i = 0; i < n; ++i) out[i] = NumberKernel<Op>::apply(x[i], y[i]);
+    } else if (a) {
+        const double* x = a->rowMajor(scratchA);
+        double y = right.as_number();
+        for (size_t i = 0; i < n; ++i) out[i] = NumberKernel<Op>::apply(x[i], y);
+    } else {
+        double x = left.as_number();
+        const double* y = b->rowMajor(scratchB);
+        for (size_t i = 0; i < n; ++i) out[i] = NumberKernel<Op>::apply(x, y[i]);
+    }
+    return makeArray(std::move(result), shape);
+}
+
+static Value repeatString(const std::string& str, double num) {
+    // String repetition: "abc" * 3 = "abcabcabc"
+    int count = static_cast<int>(num);
+    if (count < 0) throw std::runtime_error("String repetition count must be non-negative");
+
+    std::string result;
+    result.reserve(str.length() * count);
+    for (int i = 0; i < count; ++i) {
+        result += str;
+    }
+    return makePooled<StringObject>(result);
+}
+
+template <TokenType Op, OperandKind L, OperandKind R>
+static Value binaryKernel(const Value& left, const Value& right) {
+    using K = OperandKind;
+    if constexpr (!isBinaryOperator(Op)) {
+        throw std::runtime_error(std::string("Unsupported binary operator: ") + operatorSymbol(Op));
+    } else if constexpr (L == K::Number && R == K::Number) {
+        return NumberKernel<Op>::apply(left.as_number(), right.as_number());
+    } else if constexpr (L == K::String && R == K::String) {
+        if constexpr (Op == TokenType::Plus) {
+            return makePooled<StringObject>(left.as<StringObject>()->value + right.as<StringObject>()->value);
+        } else {
+            throw std::runtime_error(std::string("Unsupported binary operator for strings: ") + operatorSymbol(Op));
+        }
+    } else if constexpr ((L == K::Array && (R == K::Array || R == K::Number)) || (L == K::Number && R == K::Array)) {
+        return elementwise<Op>(left, right);
+    } else if constexpr ((L == K::String && R == K::Number) || (L == K::Number && R == K::String)) {
+        if constexpr (Op == TokenType::Star) {
+            const Value& str = L == K::String ? left : right;
+            const Value& num = L == K::String ? right : left;
+            return repeatString(str.as<StringObject>()->value, num.as_number());
+        } else {
+            throw std::runtime_error(std::string("Unsupported binary operator for string and number: ") +
+                                     operatorSymbol(Op));
+        }
+    } else {
+        throw std::runtime_error("Type error in binary expression");
+    }
+}
+
+using BinaryKernel = Value (*)(const Value&, const Value&);
+
+constexpr size_t kFirstOperator = static_cast<size_t>(TokenType::Plus);
+constexpr size_t kOperatorCount = static_cast<size_t>(TokenType::Or) - kFirstOperator + 1;
+constexpr size_t kKernelsPerOperator = kOperandKinds * kOperandKinds;
+
+// Entry I holds operator (I / 9), left kind (I / 3 % 3), right kind (I % 3).
+template <size_t... I>
+static constexpr std::array<BinaryKernel, sizeof...(I)> makeKernelTable(std::index_sequence<I...>) {
+    return {{&binaryKernel<static_cast<TokenType>(kFirstOperator + I / kKernelsPerOperator),
+                           static_cast<OperandKind>(I / kOperandKinds % kOperandKinds),
+                           static_cast<OperandKind>(I % kOperandKinds)>...}};
+}
+
+static constexpr auto s_binaryKernels =
+    makeKernelTable(std::make_index_sequence<kOperatorCount * kKernelsPerOperator>());
+
+Value evaluateBinaryOperation(const Value& left, const Value& right, TokenType op) {
+    size_t opIndex = static_cast<size_t>(op) - kFirstOperator;
+    if (opIndex >= kOperatorCount) {
+        throw std::runtime_error(std::string("Unsupported binary operator: ") + operatorSymbol(op));
+    }
+    size_t index = (opIndex * kOperandKinds + static_cast<size_t>(operandKind(left))) * kOperandKinds +
+                   static_cast<size_t>(operandKind(right));
+    return s_binaryKernels[index](left, right);
+}
+
+Value evaluateUnaryOperation(const Value& operand, TokenType op) {
+    if (op == TokenType::Minus) {
+        if (operand.is_number()) {
+            return -operand.as_number();
+        }
+        if (auto array = operand.as<ArrayObject>()) {
+            ArrayObject::Buffer scratch;
+            const double* x = array->rowMajor(scratch);
+            auto result = std::make_shared<ArrayObject::Buffer>(x, x + array->size());
+            for (double& value : *result) value = -value;
+            return makeArray(std::move(result), *array);
+        }
+        throw std::runtime_error("Unary '-' expects a number");
+    }
+    if (op == TokenType::Not) {
+        return Value::boolean(!isTruthy(operand));
+    }
+    throw std::runtime_error(std::string("Unknown unary operator: ") + operatorSymbol(op));
+}
+
+Value evaluateIndex(const Value& collection, const Value& index) {
+    if (auto list = collection.as<ListObject>()) {
+        return list->at(resolveIndex(index, list->size()));
+    } else if (auto str = collection.as<StringObject>()) {
+        size_t idx = resolveIndex(index, str->value.size());
+        return makePooled<StringObject>(std::string(1, str->value[idx]));
+    } else if (auto array = collection.as<ArrayObject>()) {
+        return array->item(resolveIndex(index, array->rows()));
+    }
+    throw std::runtime_error("Object is not subscriptable");
+}
+
+Value evaluateMemberAccess(const Value& object, const std::string& member) {
+    // For now, we'll support basic member access on strings and lists
+    if (auto str = object.as<StringObject>()) {
+        if (member == "length") {
+            return static_cast<double>(str->value.length());
+        }
+    } else if (auto list = object.as<ListObject>()) {
+        if (member == "length") {
+            return static_cast<double>(list->size());
+        }
+    } else if (auto array = object.as<ArrayObject>()) {
+        if (member == "length" || member == "rows") {
+            return static_cast<double>(array->rows());
+        }
+        if (member == "cols") {
+            return static_cast<double>(array->cols());
+        }
+    }
+
+    throw std::runtime_error("Member '" + member + "' not found on object");
+}
+
+std::shared_ptr<IteratorObject> makeIterator(const Value& iterable) {
+    if (auto range = iterable.as<RangeObject>()) {
+        return range->iter();
+    } else if (auto str = iterable.as<StringObject>()) {
+        return str->iter();
+    } else if (auto list = iterable.as<ListObject>()) {
+        return list->iter();
+    } else if (auto array = iterable.as<ArrayObject>()) {
+        return array->iter();
+    }
+    throw std::runtime_error("Object is not iterable");
+}
+
+bool isTruthy(const Value& value) {
+    if (value.is_number()) {
+        return value.as_number() != 0.0;
+    }
+    if (auto str = value.as<StringObject>()) {
+        return !str->value.empty();
+    }
+    // All other objects are considered truthy
+    return true;
+}
@@ -0,0 +1,255 @@
+#include <stdexcept>
+#include "core/Optimizer.h"
+#include "core/Operations.h"
+#include "objects/StringObject.h"
+#include "objects/ObjectPool.h"
+
+// Longest string a folded expression may produce; longer results stay as
+// runtime operations instead of being embedded in the AST.
+static constexpr size_t kMaxFoldedString = 4096;
+
+static bool isNumber(const Expr& expr, double value) {
+    return expr.kind == ExprKind::Number && expr.number == value;
+}
+
+void Optimizer::optimize(Ast& ast) {
+    if (m_level <= 0) return;
+    m_ast = &ast;
+    optimizeBlock(ast.program);
+}
+
+bool Optimizer::literalValue(NodeIndex index, Value& out) const {
+    const Expr& expr = m_ast->expr(index);
+    if (expr.kind == ExprKind::Number) {
+        out = expr.number;
+        return true;
+    }
+    if (expr.kind == ExprKind::String) {
+        out = makePooled<StringObject>(expr.name.text());
+        return true;
+    }
+    return false;
+}
+
+// Overwrites the node at index with a literal; its old children become
+// unreachable.
+bool Optimizer::replaceWithLiteral(NodeIndex index, const Value& value) {
+    if (value.is_number()) {
+        Expr literal{ExprKind::Number};
+        literal.number = value.as_number();
+        m_ast->expr(index) = literal;
+        return true;
+    }
+    if (auto str = value.as<StringObject>()) {
+        Expr literal{ExprKind::String};
+        literal.name = Symbol::intern(str->value);
+        m_ast->expr(index) = literal;
+        return true;
+    }
+    return false;
+}
+
+// --- Statements ---
+// Statement nodes are never added here, so Stmt references stay valid, but
+// statementLists can grow and spans into it must not be held across calls.
+void Optimizer::optimizeBlock(NodeList& statements) {
+    NodeSpan span = m_ast->statementList(statements);
+    std::vector<NodeIndex> original(span.begin(), span.end());
+    std::vector<NodeIndex> optimized;
+    optimized.reserve(original.size());
+    for (NodeIndex stmt : original) {
+        if (!optimizeStmt(stmt, optimized)) break;
+    }
+    if (optimized.size() <= statements.count) {
+        std::copy(optimized.begin(), optimized.end(), m_ast->statementLists.begin() + statements.start);
+        statements.count = static_cast<uint32_t>(optimized.size());
+    } else {
+        statements = m_ast->addStatementList(optimized);
+    }
+}
+
+bool Optimizer::optimizeStmt(NodeIndex index, std::vector<NodeIndex>& out) {
+    Stmt& stmt = m_ast->stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression: {
+        optimizeExpr(stmt.expr);
+        Value unused;
+        if (literalValue(stmt.expr, unused)) return true; // No effect
+        break;
+    }
+    case StmtKind::Assign:
+        optimizeExpr(stmt.expr);
+        break;
+    case StmtKind::If: {
+        optimizeExpr(stmt.expr);
+        Value condition;
+        if (literalValue(stmt.expr, condition)) {
+            // Only functions create scopes, so the taken branch can replace the if
+            return spliceBranch(isTruthy(condition) ? stmt.body : stmt.orelse, out);
+        }
+        optimizeBlock(stmt.body);
+        optimizeBlock(stmt.orelse);
+        break;
+    }
+    case StmtKind::While: {
+        optimizeExpr(stmt.expr);
+        Value condition;
+        if (literalValue(stmt.expr, condition) && !isTruthy(condition)) return true;
+        optimizeBlock(stmt.body);
+        break;
+    }
+    case StmtKind::For:
+        optimizeExpr(stmt.expr);
+        optimizeBlock(stmt.body);
+        break;
+    case StmtKind::Block:
+        optimizeBlock(stmt.body);
+        break;
+    case StmtKind::FunctionDef:
+        optimizeBlock(m_ast->functions[stmt.function].body);
+        break;
+    case StmtKind::Return:
+        if (stmt.expr != kNoNode) optimizeExpr(stmt.expr);
+        out.push_back(index);
+        return false;
+    case StmtKind::Break:
+    case StmtKind::Continue:
+        out.push_back(index);
+        return false;
+    default:
+        throw std::runtime_error("Unknown statement type");
+    }
+    out.push_back(index);
+    return true;
+}
+
+bool Optimizer::spliceBranch(NodeList branch, std::vector<NodeIndex>& out) {
+    NodeSpan span = m_ast->statementList(branch);
+    std::vector<NodeIndex> statements(span.begin(), span.end());
+    for (NodeIndex stmt : statements) {
+        if (!optimizeStmt(stmt, out)) return false;
+    }
+    return true;
+}
+
+// --- Expressions ---
+// Expression nodes are never added either; folding rewrites them in place.
+void Optimizer::optimizeExpr(NodeIndex index) {
+    Expr& expr = m_ast->expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+    case ExprKind::String:
+    case ExprKind::Variable:
+        break; // Nothing to fold
+    case ExprKind::Binary:
+        foldBinary(index);
+        break;
+    case ExprKind::Unary:
+        foldUnary(index);
+        break;
+    case ExprKind::Assign:
+    case ExprKind::MemberAccess:
+        optimizeExpr(expr.left);
+        break;
+    case ExprKind::Call:
+        optimizeExpr(expr.left);
+        for (NodeIndex arg : m_ast->expressionList(expr.items)) optimizeExpr(arg);
+        break;
+    case ExprKind::List:
+        for (NodeIndex elem : m_ast->expressionList(expr.items)) optimizeExpr(elem);
+        break;
+    case ExprKind::Index:
+        optimizeExpr(expr.left);
+        optimizeExpr(expr.right);
+        break;
+    default:
+        throw std::runtime_error("Unknown expression type");
+    }
+}
+
+void Optimizer::foldBinary(NodeIndex index) {
+    const Expr expr = m_ast->expr(index);
+    optimizeExpr(expr.left);
+    optimizeExpr(expr.right);
+
+    Value left, right;
+    if (!literalValue(expr.left, left) || !literalValue(expr.right, right)) {
+        simplifyIdentity(index);
+        return;
+    }
+    if (expr.op == TokenType::Star && (left.is_number() != right.is_number())) {
+        const Value& str = left.is_number() ? right : left;
+        double count = left.is_number() ? left.as_number() : right.as_number();
+        if (count * str.as<StringObject>()->value.size() > kMaxFoldedString) return;
+    }
+    // Operations that fail are left for the engine to report at run time
+    try {
+        replaceWithLiteral(index, evaluateBinaryOperation(left, right, expr.op));
+    } catch (const std::runtime_error&) {
+    }
+}
+
+void Optimizer::foldUnary(NodeIndex index) {
+    const Expr expr = m_ast->expr(index);
+    optimizeExpr(expr.left);
+
+    Value operand;
+    if (!literalValue(expr.left, operand)) return;
+    try {
+        replaceWithLiteral(index, evaluateUnaryOperation(operand, expr.op));
+    } catch (const std::runtime_error&) {
+    }
+}
+
+// x * 1, 1 * x, x / 1, x - 0, x ** 1, x + 0, 0 + x  ->  x
+bool Optimizer::simplifyIdentity(NodeIndex index) {
+    const Expr& expr = m_ast->expr(index);
+    const Expr& left = m_ast->expr(expr.left);
+    const Expr& right = m_ast->expr(expr.right);
+    NodeIndex kept = kNoNode;
+    switch (expr.op) {
+    case TokenType::Star:
+        if (isNumber(right, 1)) kept = expr.left;
+        else if (isNumber(left, 1)) kept = expr.right;
+        break;
+    case TokenType::Slash:
+    case TokenType::Power:
+        if (isNumber(right, 1)) kept = expr.left;
+        break;
+    case TokenType::Minus:
+        if (isNumber(right, 0)) kept = expr.left;
+        break;
+    case TokenType::Plus:
+        // -0 + 0 is +0, so this one is not exact even for numbers
+        if (m_level < 2) return false;
+        if (isNumber(right, 0)) kept = expr.left;
+        else if (isNumber(left, 0)) kept = expr.right;
+        break;
+    default:
+        break;
+    }
+    if (kept == kNoNode) return false;
+    // On strings and other objects these operations fail or build a new value
+    if (m_level < 2 && !isNumeric(kept)) return false;
+    m_ast->expr(index) = m_ast->expr(kept);
+    return true;
+}
+
+// True when the expression evaluates to a number or fails, never to another
+// type.
+bool Optimizer::isNumeric(NodeIndex index) const {
+    const Expr& expr = m_ast->expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+    case ExprKind::Unary:
+        return true;
+    case ExprKind::Binary:
+        // Only + and * are defined for strings
+        if (expr.op == TokenType::Plus || expr.op == TokenType::Star) {
+            return isNumeric(expr.left) && isNumeric(expr.right);
+        }
+        return true;
+    default:
+        return false;
+    }
+}
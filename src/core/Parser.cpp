@@ -57,110 +57,102 @@ const std::unordered_map<TokenType, Parser::ParseRule> Parser::s_parseRules = {
 };
 
 // --- Parser implementation ---
-Parser::Parser(const std::vector<Token>& tokens)
-    : m_tokens(tokens), m_current(0) {}
+Parser::Parser(Tokenizer& tokenizer)
+    : m_tokenizer(tokenizer), m_window(kTokenWindow) {
+    fetch(0);
+}
 
-std::vector<std::unique_ptr<Stmt>> Parser::parse() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+Ast Parser::parse() {
+    m_ast = Ast();
+    std::vector<NodeIndex> statements;
     while (!isAtEnd()) {
         skipNewlines();
-        auto stmt = parseStatement();
-        if (stmt) statements.push_back(std::move(stmt));
+        statements.push_back(parseStatement());
         if (match(TokenType::Newline) || match(TokenType::Semicolon)) {}
     }
-    return statements;
+    m_ast.program = m_ast.addStatementList(statements);
+    return std::move(m_ast);
 }
 
 // --- Statement parsing ---
-std::unique_ptr<Stmt> Parser::parseStatement() {
+NodeIndex Parser::parseStatement() {
     if (match(TokenType::Def)) return parseFunctionDef();
     if (match(TokenType::If)) return parseIf();
     if (match(TokenType::While)) return parseWhile();
     if (match(TokenType::For)) return parseFor();
-    if (match(TokenType::Break)) return std::make_unique<BreakStmt>();
-    if (match(TokenType::Continue)) return std::make_unique<ContinueStmt>();
+    if (match(TokenType::Break)) return m_ast.addStmt({StmtKind::Break});
+    if (match(TokenType::Continue)) return m_ast.addStmt({StmtKind::Continue});
     if (match(TokenType::Return)) return parseReturn();
     
     // Check for assignment: identifier = expression
-    if (check(TokenType::Identifier) && m_current + 1 < m_tokens.size() && m_tokens[m_current + 1].type == TokenType::Assign) {
+    if (check(TokenType::Identifier) && peekNext().type == TokenType::Assign) {
         return parseAssignment();
     }
     
     return parseExpressionStatement();
 }
 
-std::unique_ptr<Stmt> Parser::parseIf() {
-    auto condition = parseExpression();
+NodeIndex Parser::parseIf() {
+    Stmt stmt{StmtKind::If};
+    stmt.expr = parseExpression();
     if (!match(TokenType::Colon)) throw std::runtime_error("Expected ':' after if condition");
     skipNewlines();
     if (!match(TokenType::Indent)) throw std::runtime_error("Expected indentation after ':'");
-    auto thenBlock = parseBlock();
-    std::vector<std::unique_ptr<Stmt>> thenBranch;
-    if (auto block = dynamic_cast<BlockStmt*>(thenBlock.get())) {
-        thenBranch = std::move(block->statements);
-    }
-    std::vector<std::unique_ptr<Stmt>> elseBranch;
+    stmt.body = parseBlock();
     if (match(TokenType::Else)) {
         if (!match(TokenType::Colon)) throw std::runtime_error("Expected ':' after else");
         skipNewlines();
         if (!match(TokenType::Indent)) throw std::runtime_error("Expected indentation after else ':'");
-        auto elseBlock = parseBlock();
-        if (auto block = dynamic_cast<BlockStmt*>(elseBlock.get())) {
-            elseBranch = std::move(block->statements);
-        }
+        stmt.orelse = parseBlock();
     }
-    return std::make_unique<IfStmt>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
+    return m_ast.addStmt(stmt);
 }
 
-std::unique_ptr<Stmt> Parser::parseWhile() {
-    auto condition = parseExpression();
+NodeIndex Parser::parseWhile() {
+    Stmt stmt{StmtKind::While};
+    stmt.expr = parseExpression();
     if (!match(TokenType::Colon)) throw std::runtime_error("Expected ':' after while condition");
     skipNewlines();
     if (!match(TokenType::Indent)) throw std::runtime_error("Expected indentation after ':'");
-    auto bodyBlock = parseBlock();
-    std::vector<std::unique_ptr<Stmt>> body;
-    if (auto block = dynamic_cast<BlockStmt*>(bodyBlock.get())) {
-        body = std::move(block->statements);
-    }
-    return std::make_unique<WhileStmt>(std::move(condition), std::move(body));
+    stmt.body = parseBlock();
+    return m_ast.addStmt(stmt);
 }
 
-std::unique_ptr<Stmt> Parser::parseFor() {
+NodeIndex Parser::parseFor() {
+    Stmt stmt{StmtKind::For};
     if (!match(TokenType::Identifier)) throw std::runtime_error("Expected variable name in for loop");
-    std::string var = previous().text;
+    stmt.name = previous().symbolValue();
     if (!match(TokenType::In)) throw std::runtime_error("Expected 'in' in for loop");
-    auto iterable = parseExpression();
+    stmt.expr = parseExpression();
     if (!match(TokenType::Colon)) throw std::runtime_error("Expected ':' after for loop");
     skipNewlines();
     if (!match(TokenType::Indent)) throw std::runtime_error("Expected indentation after ':'");
-    auto bodyBlock = parseBlock();
-    std::vector<std::unique_ptr<Stmt>> body;
-    if (auto block = dynamic_cast<BlockStmt*>(bodyBlock.get())) {
-        body = std::move(block->statements);
-    }
-    return std::make_unique<ForStmt>(var, std::move(iterable), std::move(body));
+    stmt.body = parseBlock();
+    return m_ast.addStmt(stmt);
 }
 
-std::unique_ptr<Stmt> Parser::parseBlock() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+// Parses statements up to the matching Dedent. Nested blocks are stored
+// before the enclosing one, so each block's statement list is contiguous.
+NodeList Parser::parseBlock() {
+    std::vector<NodeIndex> statements;
     while (!isAtEnd() && !check(TokenType::Dedent)) {
         skipNewlines();
         if (check(TokenType::Dedent)) break;
-        auto stmt = parseStatement();
-        if (stmt) statements.push_back(std::move(stmt));
+        statements.push_back(parseStatement());
     }
     if (match(TokenType::Dedent)) {}
-    return std::make_unique<BlockStmt>(std::move(statements));
+    return m_ast.addStatementList(statements);
 }
 
-std::unique_ptr<Stmt> Parser::parseExpressionStatement() {
-    auto expr = parseExpression();
-    return std::make_unique<ExpressionStmt>(std::move(expr));
+NodeIndex Parser::parseExpressionStatement() {
+    Stmt stmt{StmtKind::Expression};
+    stmt.expr = parseExpression();
+    return m_ast.addStmt(stmt);
 }
 
 // --- Pratt Parser Expression Parsing ---
-std::unique_ptr<Expr> Parser::parseExpression(int precedence) {
-    auto left = parsePrecedence();
+NodeIndex Parser::parseExpression(int precedence) {
+    NodeIndex left = parsePrecedence();
     
     while (precedence <= getPrecedence(peek().type)) {
         auto rule = s_parseRules.find(peek().type);
@@ -169,16 +161,16 @@ std::unique_ptr<Expr> Parser::parseExpression(int precedence) {
         }
         
         advance();
-        left = (this->*rule->second.infix)(std::move(left));
+        left = (this->*rule->second.infix)(left);
     }
     
     return left;
 }
 
-std::unique_ptr<Expr> Parser::parsePrecedence() {
+NodeIndex Parser::parsePrecedence() {
     auto rule = s_parseRules.find(peek().type);
     if (rule == s_parseRules.end() || !rule->second.prefix) {
-        throw std::runtime_error("Unexpected token: " + peek().text);
+        throw std::runtime_error("Unexpected token: " + std::string(m_tokenizer.lexeme(peek())));
     }
     
     advance();
@@ -186,36 +178,44 @@ std::unique_ptr<Expr> Parser::parsePrecedence() {
 }
 
 // --- Prefix Parsers ---
-std::unique_ptr<Expr> Parser::parseNumber() {
-    return std::make_unique<NumberExpr>(std::get<double>(previous().value));
+NodeIndex Parser::parseNumber() {
+    Expr expr{ExprKind::Number};
+    expr.number = previous().number;
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseString() {
-    return std::make_unique<StringExpr>(std::get<std::string>(previous().value));
+NodeIndex Parser::parseString() {
+    Expr expr{ExprKind::String};
+    expr.name = m_tokenizer.stringValue(previous());
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseVariable() {
-    return std::make_unique<VariableExpr>(previous().text);
+NodeIndex Parser::parseVariable() {
+    Expr expr{ExprKind::Variable};
+    expr.name = previous().symbolValue();
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseBoolean() {
-    return std::make_unique<NumberExpr>(previous().type == TokenType::True ? 1.0 : 0.0);
+NodeIndex Parser::parseBoolean() {
+    Expr expr{ExprKind::Number};
+    expr.number = previous().type == TokenType::True ? 1.0 : 0.0;
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseNone() {
-    return std::make_unique<NumberExpr>(0.0); // None is represented as 0
+NodeIndex Parser::parseNone() {
+    return m_ast.addExpr({ExprKind::Number}); // None is represented as 0
 }
 
-std::unique_ptr<Expr> Parser::parseGrouping() {
-    auto expr = parseExpression();
+NodeIndex Parser::parseGrouping() {
+    NodeIndex expr = parseExpression();
     if (!match(TokenType::RightParen)) {
         throw std::runtime_error("Expected ')' after expression");
     }
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::parseList() {
-    std::vector<std::unique_ptr<Expr>> elements;
+NodeIndex Parser::parseList() {
+    std::vector<NodeIndex> elements;
     
     if (!check(TokenType::RightBracket)) {
         do {
@@ -227,26 +227,30 @@ std::unique_ptr<Expr> Parser::parseList() {
         throw std::runtime_error("Expected ']' after list elements");
     }
     
-    return std::make_unique<ListExpr>(std::move(elements));
+    Expr expr{ExprKind::List};
+    expr.items = m_ast.addExpressionList(elements);
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseUnary() {
-    std::string op = previous().text;
+NodeIndex Parser::parseUnary() {
+    TokenType op = previous().type;
     // Use different binding powers for logical vs arithmetic unary:
     // - For "not": lower than equality to allow "not a == b" -> not (a == b)
     // - For numeric negation: higher than multiplicative, lower than power and postfix
-    int operandBindingPower = (op == "not") ? 2 : 7;
-    auto operand = parseExpression(operandBindingPower);
-    return std::make_unique<UnaryExpr>(op, std::move(operand));
+    int operandBindingPower = (op == TokenType::Not) ? 2 : 7;
+    Expr expr{ExprKind::Unary};
+    expr.op = op;
+    expr.left = parseExpression(operandBindingPower);
+    return m_ast.addExpr(expr);
 }
 
 // --- Infix Parsers ---
-std::unique_ptr<Expr> Parser::parseBinary(std::unique_ptr<Expr> left) {
-    std::string op = previous().text;
+NodeIndex Parser::parseBinary(NodeIndex left) {
+    TokenType op = previous().type;
     int precedence = getPrecedence(previous().type);
     
     int nextPrecedence;
-    if (op == "**") {
+    if (op == TokenType::Power) {
         // Power is right associative, so use same precedence
         nextPrecedence = precedence;
     } else {
@@ -254,74 +258,85 @@ std::unique_ptr<Expr> Parser::parseBinary(std::unique_ptr<Expr> left) {
         nextPrecedence = precedence + 1;
     }
     
-    auto right = parseExpression(nextPrecedence);
-    return std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+    Expr expr{ExprKind::Binary};
+    expr.op = op;
+    expr.left = left;
+    expr.right = parseExpression(nextPrecedence);
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseCall(std::unique_ptr<Expr> left) {
-    auto args = parseArguments();
+NodeIndex Parser::parseCall(NodeIndex left) {
+    Expr expr{ExprKind::Call};
+    expr.left = left;
+    expr.items = parseArguments();
     if (!match(TokenType::RightParen)) {
         throw std::runtime_error("Expected ')' after function arguments");
     }
-    return std::make_unique<CallExpr>(std::move(left), std::move(args));
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseIndex(std::unique_ptr<Expr> left) {
-    auto index = parseExpression();
+NodeIndex Parser::parseIndex(NodeIndex left) {
+    Expr expr{ExprKind::Index};
+    expr.left = left;
+    expr.right = parseExpression();
     if (!match(TokenType::RightBracket)) {
         throw std::runtime_error("Expected ']' after index expression");
     }
-    return std::make_unique<IndexExpr>(std::move(left), std::move(index));
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Expr> Parser::parseMemberAccess(std::unique_ptr<Expr> left) {
+NodeIndex Parser::parseMemberAccess(NodeIndex left) {
     if (!match(TokenType::Identifier)) {
         throw std::runtime_error("Expected identifier after '.'");
     }
-    std::string member = previous().text;
-    return std::make_unique<MemberAccessExpr>(std::move(left), member);
+    Expr expr{ExprKind::MemberAccess};
+    expr.left = left;
+    expr.name = previous().symbolValue();
+    return m_ast.addExpr(expr);
 }
 
-std::unique_ptr<Stmt> Parser::parseAssignment() {
+NodeIndex Parser::parseAssignment() {
     if (!match(TokenType::Identifier)) {
         throw std::runtime_error("Expected identifier for assignment");
     }
-    std::string name = previous().text;
+    Stmt stmt{StmtKind::Assign};
+    stmt.name = previous().symbolValue();
     
     if (!match(TokenType::Assign)) {
         throw std::runtime_error("Expected '=' after identifier");
     }
     
-    auto value = parseExpression();
-    return std::make_unique<AssignStmt>(name, std::move(value));
+    stmt.expr = parseExpression();
+    return m_ast.addStmt(stmt);
 }
 
-std::vector<std::unique_ptr<Expr>> Parser::parseArguments() {
-    std::vector<std::unique_ptr<Expr>> args;
-    if (check(TokenType::RightParen)) return args;
-    do {
-        args.push_back(parseExpression());
-    } while (match(TokenType::Comma));
-    return args;
+NodeList Parser::parseArguments() {
+    std::vector<NodeIndex> args;
+    if (!check(TokenType::RightParen)) {
+        do {
+            args.push_back(parseExpression());
+        } while (match(TokenType::Comma));
+    }
+    return m_ast.addExpressionList(args);
 }
 
-std::unique_ptr<Stmt> Parser::parseFunctionDef() {
+NodeIndex Parser::parseFunctionDef() {
     if (!match(TokenType::Identifier)) {
         throw std::runtime_error("Expected function name after 'def'");
     }
-    std::string name = previous().text;
+    FunctionDecl function;
+    function.name = previous().symbolValue();
     
     if (!match(TokenType::LeftParen)) {
         throw std::runtime_error("Expected '(' after function name");
     }
     
-    std::vector<std::string> parameters;
     if (!check(TokenType::RightParen)) {
         do {
             if (!match(TokenType::Identifier)) {
                 throw std::runtime_error("Expected parameter name");
             }
-            parameters.push_back(previous().text);
+            function.parameters.push_back(previous().symbolValue());
         } while (match(TokenType::Comma));
     }
     
@@ -339,21 +354,21 @@ std::unique_ptr<Stmt> Parser::parseFunctionDef() {
         throw std::runtime_error("Expected indentation after function definition");
     }
     
-    auto bodyBlock = parseBlock();
-    std::vector<std::unique_ptr<Stmt>> body;
-    if (auto block = dynamic_cast<BlockStmt*>(bodyBlock.get())) {
-        body = std::move(block->statements);
-    }
+    function.body = parseBlock();
     
-    return std::make_unique<FunctionDefStmt>(name, std::move(parameters), std::move(body));
+    Stmt stmt{StmtKind::FunctionDef};
+    stmt.name = function.name;
+    stmt.function = static_cast<uint32_t>(m_ast.functions.size());
+    m_ast.functions.push_back(std::move(function));
+    return m_ast.addStmt(stmt);
 }
 
-std::unique_ptr<Stmt> Parser::parseReturn() {
-    std::unique_ptr<Expr> value = nullptr;
+NodeIndex Parser::parseReturn() {
+    Stmt stmt{StmtKind::Return};
     if (!check(TokenType::Newline)) {
-        value = parseExpression();
+        stmt.expr = parseExpression();
     }
-    return std::make_unique<ReturnStmt>(std::move(value));
+    return m_ast.addStmt(stmt);
 }
 
 // --- Helpers ---
@@ -376,16 +391,30 @@ bool Parser::check(TokenType type) const {
 }
 
 const Token& Parser::advance() {
-    if (!isAtEnd()) m_current++;
+    if (!isAtEnd()) fetch(++m_current);
     return previous();
 }
 
 const Token& Parser::peek() const {
-    return m_tokens[m_current];
+    return m_window[m_current % kTokenWindow];
+}
+
+const Token& Parser::peekNext() {
+    fetch(m_current + 1);
+    return m_window[(m_current + 1) % kTokenWindow];
 }
 
 const Token& Parser::previous() const {
-    return m_tokens[m_current - 1];
+    return m_window[(m_current - 1) % kTokenWindow];
+}
+
+// Pulls tokens up to and including position. The tokenizer keeps returning
+// EndOfInput once the source is exhausted.
+void Parser::fetch(size_t position) {
+    while (m_fetched <= position) {
+        m_window[m_fetched % kTokenWindow] = m_tokenizer.nextToken();
+        m_fetched++;
+    }
 }
 
 bool Parser::isAtEnd() const {
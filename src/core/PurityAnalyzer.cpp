@@ -0,0 +1,141 @@
+#include "core/PurityAnalyzer.h"
+#include "core/Builtins.h"
+
+void PurityAnalyzer::analyze(Ast& ast) {
+    m_ast = &ast;
+    m_globalBindings.clear();
+    m_globalFunctions.clear();
+
+    // Every place a global name can be bound, reachable or not
+    for (const Stmt& stmt : ast.statements) {
+        bool binds = stmt.kind == StmtKind::Assign || stmt.kind == StmtKind::For ||
+                     stmt.kind == StmtKind::FunctionDef;
+        if (!binds || !stmt.binding.is_global()) continue;
+        ++m_globalBindings[stmt.name];
+        if (stmt.kind == StmtKind::FunctionDef) m_globalFunctions[stmt.name] = stmt.function;
+    }
+    for (const Expr& expr : ast.expressions) {
+        if (expr.kind == ExprKind::Assign && expr.binding.is_global()) ++m_globalBindings[expr.name];
+    }
+
+    // Each function on its own, then drop those calling impure ones until
+    // nothing changes
+    uint32_t count = static_cast<uint32_t>(ast.functions.size());
+    m_callees.assign(count, {});
+    std::vector<bool> pure(count);
+    for (uint32_t i = 0; i < count; ++i) pure[i] = checkBlock(ast.functions[i].body, i);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!pure[i]) continue;
+            for (uint32_t callee : m_callees[i]) {
+                if (!pure[callee]) {
+                    pure[i] = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        FunctionDecl& function = ast.functions[i];
+        std::vector<bool> visited(count);
+        bool memoize = pure[i] && !function.parameters.empty() && reaches(i, i, visited);
+        function.memoCapacity = memoize ? m_memoCapacity : 0;
+    }
+    m_ast = nullptr;
+}
+
+bool PurityAnalyzer::checkBlock(NodeList statements, uint32_t function) {
+    for (NodeIndex index : m_ast->statementList(statements)) {
+        if (!checkStmt(index, function)) return false;
+    }
+    return true;
+}
+
+bool PurityAnalyzer::checkStmt(NodeIndex index, uint32_t function) {
+    const Stmt& stmt = m_ast->stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+    case StmtKind::Assign:
+        return checkExpr(stmt.expr, function);
+    case StmtKind::If:
+        return checkExpr(stmt.expr, function) && checkBlock(stmt.body, function) &&
+               checkBlock(stmt.orelse, function);
+    case StmtKind::While:
+    case StmtKind::For:
+        return checkExpr(stmt.expr, function) && checkBlock(stmt.body, function);
+    case StmtKind::Block:
+        return checkBlock(stmt.body, function);
+    case StmtKind::FunctionDef:
+        // A closure could outlive the call and see its locals change
+        return false;
+    case StmtKind::Return:
+        return stmt.expr == kNoNode || checkExpr(stmt.expr, function);
+    case StmtKind::Break:
+    case StmtKind::Continue:
+        return true;
+    }
+    return false;
+}
+
+bool PurityAnalyzer::checkExpr(NodeIndex index, uint32_t function) {
+    const Expr& expr = m_ast->expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+    case ExprKind::String:
+        return true;
+    case ExprKind::Variable:
+        if (expr.binding.is_global()) return isStableFunction(expr.name) || isPureBuiltin(expr.name);
+        return expr.binding.depth == 0;
+    case ExprKind::Binary:
+    case ExprKind::Index:
+        return checkExpr(expr.left, function) && checkExpr(expr.right, function);
+    case ExprKind::Unary:
+    case ExprKind::MemberAccess:
+        return checkExpr(expr.left, function);
+    case ExprKind::Assign:
+        return expr.binding.depth == 0 && checkExpr(expr.left, function);
+    case ExprKind::List:
+        for (NodeIndex item : m_ast->expressionList(expr.items)) {
+            if (!checkExpr(item, function)) return false;
+        }
+        return true;
+    case ExprKind::Call: {
+        // Only calls whose target is known before running
+        const Expr& callee = m_ast->expr(expr.left);
+        if (callee.kind != ExprKind::Variable || !callee.binding.is_global()) return false;
+        if (isStableFunction(callee.name)) {
+            m_callees[function].push_back(m_globalFunctions.at(callee.name));
+        } else if (!isPureBuiltin(callee.name)) {
+            return false;
+        }
+        for (NodeIndex arg : m_ast->expressionList(expr.items)) {
+            if (!checkExpr(arg, function)) return false;
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+// A global bound only by its 'def', so it always holds that function.
+bool PurityAnalyzer::isStableFunction(Symbol name) const {
+    auto it = m_globalBindings.find(name);
+    return it != m_globalBindings.end() && it->second == 1 && m_globalFunctions.count(name);
+}
+
+bool PurityAnalyzer::isPureBuiltin(Symbol name) const {
+    return !m_globalBindings.count(name) && ::isPureBuiltin(name.text());
+}
+
+bool PurityAnalyzer::reaches(uint32_t from, uint32_t target, std::vector<bool>& visited) const {
+    for (uint32_t callee : m_callees[from]) {
+        if (callee == target) return true;
+        if (visited[callee]) continue;
+        visited[callee] = true;
+        if (reaches(callee, target, visited)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,41 @@
+#include "core/Quickening.h"
+
+template <TokenType Op>
+static double numberKernel(double a, double b) {
+    return NumberKernel<Op>::apply(a, b);
+}
+
+static QuickSite::NumberKernelFn numberKernelFor(TokenType op) {
+    switch (op) {
+    case TokenType::Plus: return &numberKernel<TokenType::Plus>;
+    case TokenType::Minus: return &numberKernel<TokenType::Minus>;
+    case TokenType::Star: return &numberKernel<TokenType::Star>;
+    case TokenType::Slash: return &numberKernel<TokenType::Slash>;
+    case TokenType::Percent: return &numberKernel<TokenType::Percent>;
+    case TokenType::Power: return &numberKernel<TokenType::Power>;
+    case TokenType::Equal: return &numberKernel<TokenType::Equal>;
+    case TokenType::NotEqual: return &numberKernel<TokenType::NotEqual>;
+    case TokenType::Less: return &numberKernel<TokenType::Less>;
+    case TokenType::Greater: return &numberKernel<TokenType::Greater>;
+    case TokenType::LessEqual: return &numberKernel<TokenType::LessEqual>;
+    case TokenType::GreaterEqual: return &numberKernel<TokenType::GreaterEqual>;
+    case TokenType::And: return &numberKernel<TokenType::And>;
+    case TokenType::Or: return &numberKernel<TokenType::Or>;
+    default: return nullptr;
+    }
+}
+
+void QuickSite::quickenBinary(const Value& left, const Value& right, TokenType op) {
+    if (left.is_number() && right.is_number()) {
+        m_kernel = numberKernelFor(op);
+        if (m_kernel) return quicken(QuickForm::NumberBinary);
+    } else if (op == TokenType::Plus && left.as_exact<StringObject>() && right.as_exact<StringObject>()) {
+        return quicken(QuickForm::StringConcat);
+    }
+    stayGeneric();
+}
+
+void QuickSite::quickenIndex(const Value& collection, const Value& index) {
+    if (collection.as_exact<ListObject>() && index.is_number()) return quicken(QuickForm::ListIndex);
+    stayGeneric();
+}
@@ -0,0 +1,167 @@
+#include <stdexcept>
+#include "core/Resolver.h"
+
+void Resolver::resolve(Ast& ast) {
+    m_ast = &ast;
+    m_scopes.clear();
+    resolveBlock(ast.program);
+    m_ast = nullptr;
+}
+
+void Resolver::resolveBlock(NodeList statements) {
+    for (NodeIndex index : m_ast->statementList(statements)) resolveStmt(index);
+}
+
+void Resolver::resolveStmt(NodeIndex index) {
+    Stmt& stmt = m_ast->stmt(index);
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+        resolveExpr(stmt.expr);
+        break;
+    case StmtKind::Assign:
+        resolveExpr(stmt.expr);
+        stmt.binding = local(stmt.name);
+        break;
+    case StmtKind::If:
+        resolveExpr(stmt.expr);
+        resolveBlock(stmt.body);
+        resolveBlock(stmt.orelse);
+        break;
+    case StmtKind::While:
+        resolveExpr(stmt.expr);
+        resolveBlock(stmt.body);
+        break;
+    case StmtKind::For:
+        resolveExpr(stmt.expr);
+        stmt.binding = local(stmt.name);
+        resolveBlock(stmt.body);
+        break;
+    case StmtKind::Block:
+        resolveBlock(stmt.body);
+        break;
+    case StmtKind::FunctionDef:
+        stmt.binding = local(stmt.name);
+        resolveFunction(m_ast->functions[stmt.function]);
+        break;
+    case StmtKind::Return:
+        if (stmt.expr == kNoNode) break;
+        resolveExpr(stmt.expr);
+        // Engines run a call in tail position in the returning function's
+        // frame; at the top level 'return' is an error either way
+        stmt.tailCall = !m_scopes.empty() && m_ast->expr(stmt.expr).kind == ExprKind::Call;
+        break;
+    case StmtKind::Break:
+    case StmtKind::Continue:
+        // Nothing to resolve
+        break;
+    }
+}
+
+void Resolver::resolveExpr(NodeIndex index) {
+    Expr& expr = m_ast->expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+    case ExprKind::String:
+        // Literals have no names
+        break;
+    case ExprKind::Variable:
+        expr.binding = lookup(expr.name);
+        break;
+    case ExprKind::Binary:
+        resolveExpr(expr.left);
+        resolveExpr(expr.right);
+        break;
+    case ExprKind::Unary:
+    case ExprKind::MemberAccess:
+        resolveExpr(expr.left);
+        break;
+    case ExprKind::Assign:
+        resolveExpr(expr.left);
+        expr.binding = lookup(expr.name);
+        break;
+    case ExprKind::Call:
+        resolveExpr(expr.left);
+        for (NodeIndex arg : m_ast->expressionList(expr.items)) resolveExpr(arg);
+        break;
+    case ExprKind::List:
+        for (NodeIndex elem : m_ast->expressionList(expr.items)) resolveExpr(elem);
+        break;
+    case ExprKind::Index:
+        resolveExpr(expr.left);
+        resolveExpr(expr.right);
+        break;
+    }
+}
+
+void Resolver::resolveFunction(FunctionDecl& function) {
+    m_scopes.push_back({&function, {}});
+    Scope& scope = m_scopes.back();
+    function.locals.clear();
+    function.hasNestedFunctions = false;
+    for (Symbol param : function.parameters) declare(param, scope);
+    declareLocals(function.body, scope);
+    resolveBlock(function.body);
+    m_scopes.pop_back();
+}
+
+// Collects the names a function body binds, without descending into nested
+// function bodies (their locals belong to their own frames).
+void Resolver::declareLocals(NodeList statements, Scope& scope) {
+    for (NodeIndex index : m_ast->statementList(statements)) {
+        const Stmt& stmt = m_ast->stmt(index);
+        switch (stmt.kind) {
+        case StmtKind::Assign:
+            declare(stmt.name, scope);
+            break;
+        case StmtKind::FunctionDef:
+            declare(stmt.name, scope);
+            scope.function->hasNestedFunctions = true;
+            break;
+        case StmtKind::If:
+            declareLocals(stmt.body, scope);
+            declareLocals(stmt.orelse, scope);
+            break;
+        case StmtKind::While:
+        case StmtKind::Block:
+            declareLocals(stmt.body, scope);
+            break;
+        case StmtKind::For:
+            declare(stmt.name, scope);
+            declareLocals(stmt.body, scope);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void Resolver::declare(Symbol name, Scope& scope) {
+    if (scope.slots.count(name)) return;
+    scope.slots.emplace(name, static_cast<int>(scope.function->locals.size()));
+    scope.function->locals.push_back(name);
+}
+
+// Finds the innermost function frame that binds name, falling back to the
+// global scope.
+Binding Resolver::lookup(Symbol name) const {
+    for (size_t i = m_scopes.size(); i-- > 0;) {
+        auto it = m_scopes[i].slots.find(name);
+        if (it != m_scopes[i].slots.end()) {
+            Binding binding;
+            binding.depth = static_cast<int>(m_scopes.size() - 1 - i);
+            binding.slot = it->second;
+            return binding;
+        }
+    }
+    return Binding();
+}
+
+// Binding for a name defined in the current scope: a slot of the innermost
+// function, or a global at the top level.
+Binding Resolver::local(Symbol name) const {
+    if (m_scopes.empty()) return Binding();
+    Binding binding;
+    binding.depth = 0;
+    binding.slot = m_scopes.back().slots.at(name);
+    return binding;
+}
@@ -0,0 +1,50 @@
+#include <fstream>
+#include <sstream>
+#include "core/SourceFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SOURCE_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::~SourceFile() {
+#ifdef SOURCE_FILE_MMAP
+    if (m_mapped) munmap(m_mapped, m_mappedSize);
+#endif
+}
+
+bool SourceFile::open(const std::string& path) {
+#ifdef SOURCE_FILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            // The mapping stays valid after the descriptor is closed
+            close(fd);
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            m_mapped = mapped;
+            m_mappedSize = size;
+            m_text = std::string_view(static_cast<const char*>(mapped), size);
+            return true;
+        }
+    }
+    close(fd);
+#endif
+    return readFallback(path);
+}
+
+bool SourceFile::readFallback(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    m_buffer = buffer.str();
+    m_text = m_buffer;
+    return true;
+}
@@ -0,0 +1,46 @@
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include "core/Symbol.h"
+
+struct SymbolTable {
+    std::deque<Symbol::Entry> entries;  // deque: entries never move
+    std::unordered_map<std::string_view, const Symbol::Entry*> index;  // keys view entry text
+
+    SymbolTable() { add(""); }
+
+    const Symbol::Entry* add(std::string_view text) {
+        if (entries.size() >= std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Too many distinct names");
+        }
+        size_t hash = std::hash<std::string_view>{}(text);
+        entries.push_back({std::string(text), hash, static_cast<uint32_t>(entries.size())});
+        const Symbol::Entry* entry = &entries.back();
+        index.emplace(entry->text, entry);
+        return entry;
+    }
+};
+
+// Constructed on first use so builtins can intern from static initializers.
+static SymbolTable& table() {
+    static SymbolTable instance;
+    return instance;
+}
+
+Symbol::Symbol() : m_entry(&table().entries.front()) {}
+
+Symbol Symbol::intern(std::string_view text) {
+    SymbolTable& symbols = table();
+    auto it = symbols.index.find(text);
+    if (it != symbols.index.end()) return Symbol(it->second);
+    return Symbol(symbols.add(text));
+}
+
+Symbol Symbol::fromId(uint32_t id) {
+    return Symbol(&table().entries[id]);
+}
+
+size_t Symbol::count() {
+    return table().entries.size();
+}
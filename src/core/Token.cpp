@@ -1,15 +1,5 @@
 #include "core/Token.h"
 
-Token::Token(TokenType t, const std::string& txt)
-: type(t), text(txt), value(std::monostate{}) {}
-
-Token::Token(TokenType t, const std::string& txt, double num)
-: type(t), text(txt), value(num) {}
-
-Token::Token(TokenType t, const std::string& txt, const std::string& str)
-: type(t), text(txt), value(str) {}
-
-
 const char* tokenTypeToString(TokenType type) {
     switch (type) {
         // Literals
@@ -77,13 +67,37 @@ const char* tokenTypeToString(TokenType type) {
     }
 }
 
+const char* operatorSymbol(TokenType type) {
+    switch (type) {
+        case TokenType::Plus: return "+";
+        case TokenType::Minus: return "-";
+        case TokenType::Star: return "*";
+        case TokenType::Slash: return "/";
+        case TokenType::Percent: return "%";
+        case TokenType::Power: return "**";
+        case TokenType::Assign: return "=";
+        case TokenType::PlusAssign: return "+=";
+        case TokenType::MinusAssign: return "-=";
+        case TokenType::Equal: return "==";
+        case TokenType::NotEqual: return "!=";
+        case TokenType::Less: return "<";
+        case TokenType::Greater: return ">";
+        case TokenType::LessEqual: return "<=";
+        case TokenType::GreaterEqual: return ">=";
+        case TokenType::And: return "and";
+        case TokenType::Or: return "or";
+        case TokenType::Not: return "not";
+        default: return tokenTypeToString(type);
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, const Token& token) {
     os << "Type: " << tokenTypeToString(token.type)
-       << ", Text: \"" << token.text << "\"";
-    if (std::holds_alternative<double>(token.value)) {
-        os << ", Value: " << std::get<double>(token.value);
-    } else if (std::holds_alternative<std::string>(token.value)) {
-        os << ", Value: " << std::get<std::string>(token.value);
+       << ", Offset: " << token.offset << ", Length: " << token.length;
+    if (token.type == TokenType::Number) {
+        os << ", Value: " << token.number;
+    } else if (token.type == TokenType::Identifier) {
+        os << ", Value: " << token.symbolValue().text();
     }
     return os;
 }
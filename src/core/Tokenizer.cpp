@@ -1,10 +1,20 @@
 #include "core/Tokenizer.h"
 #include "core/Token.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <charconv>
+#include <limits>
 #include <stdexcept>
-#include <unordered_map>
+#include <thread>
 
-static const std::unordered_map<std::string, TokenType> keywords = {
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+static constexpr Keyword kKeywords[] = {
     {"for", TokenType::For},
     {"while", TokenType::While},
     {"if", TokenType::If},
@@ -22,8 +32,41 @@ static const std::unordered_map<std::string, TokenType> keywords = {
     {"not", TokenType::Not},
 };
 
-Tokenizer::Tokenizer(const std::string& input)
-    : m_input(input), m_pos(0), m_line(1), m_col(1), m_peekedToken(TokenType::EndOfInput, ""), m_hasPeeked(false), m_atLineStart(true) {
+// Perfect hash over kKeywords: first character, last character and length
+// put every keyword in its own slot, so recognizing one is a single
+// comparison.
+static constexpr size_t kKeywordSlots = 32;
+
+static constexpr size_t keywordSlot(std::string_view word) {
+    return (static_cast<unsigned char>(word.front()) * 3u +
+            static_cast<unsigned char>(word.back()) * 25u + word.size()) % kKeywordSlots;
+}
+
+static constexpr std::array<Keyword, kKeywordSlots> buildKeywordTable() {
+    std::array<Keyword, kKeywordSlots> table{};
+    for (const Keyword& keyword : kKeywords) {
+        Keyword& slot = table[keywordSlot(keyword.text)];
+        if (!slot.text.empty()) throw "keyword hash collision: pick new keywordSlot constants";
+        slot = keyword;
+    }
+    return table;
+}
+
+static constexpr std::array<Keyword, kKeywordSlots> kKeywordTable = buildKeywordTable();
+
+static bool findKeyword(std::string_view word, TokenType& type) {
+    const Keyword& keyword = kKeywordTable[keywordSlot(word)];
+    if (keyword.text != word) return false;
+    type = keyword.type;
+    return true;
+}
+
+Tokenizer::Tokenizer(std::string_view input)
+    : m_input(input), m_pos(0), m_scan(lexScanner()), m_hasPeeked(false), m_atLineStart(true) {
+    if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Source file too large");
+    }
+    m_lineStarts.push_back(0);
     m_indentStack.push_back(0);
 }
 
@@ -40,11 +83,8 @@ char Tokenizer::getChar() {
     if (isAtEnd()) return '\0';
     char c = m_input[m_pos++];
     if (c == '\n') {
-        m_line++;
-        m_col = 1;
+        m_lineStarts.push_back(static_cast<uint32_t>(m_pos));
         m_atLineStart = true;
-    } else {
-        m_col++;
     }
     return c;
 }
@@ -59,14 +99,18 @@ bool Tokenizer::matchChar(char expected) {
 
 // Only skip spaces, tabs, and carriage returns (not newlines)
 void Tokenizer::skipWhitespace() {
-    while (!isAtEnd() && (peekChar() == ' ' || peekChar() == '\t' || peekChar() == '\r')) {
-        getChar();
-    }
+    skipTo(m_scan.skipBlanks(cursor(), inputEnd()));
+}
+
+// Token spanning from start to the current position.
+Token Tokenizer::makeToken(TokenType type, size_t start) const {
+    size_t length = m_pos - start;
+    if (length > Token::kMaxLength) throw std::runtime_error("Token too long");
+    return Token(type, static_cast<uint32_t>(start), static_cast<uint32_t>(length));
 }
 
 void Tokenizer::processIndentation() {
     // Count leading spaces/tabs
-    size_t start = m_pos;
     int indent = 0;
     while (!isAtEnd()) {
         char c = peekChar();
@@ -76,14 +120,23 @@ void Tokenizer::processIndentation() {
     }
     // If line is empty or comment, don't emit INDENT/DEDENT
     if (peekChar() == '\n' || isAtEnd()) return;
+    if (m_deferIndentation) {
+        m_lineIndent = indent;
+        m_pendingIndent = true;
+        return;
+    }
+    applyIndentation(indent);
+}
+
+void Tokenizer::applyIndentation(int indent) {
     int prevIndent = m_indentStack.back();
     if (indent > prevIndent) {
         m_indentStack.push_back(indent);
-        m_pendingIndents.push(Token(TokenType::Indent, "<INDENT>"));
+        m_pendingIndent = true;
     } else if (indent < prevIndent) {
         while (indent < m_indentStack.back()) {
             m_indentStack.pop_back();
-            m_pendingIndents.push(Token(TokenType::Dedent, "<DEDENT>"));
+            m_pendingDedents++;
         }
         if (indent != m_indentStack.back()) {
             throw std::runtime_error("Inconsistent indentation");
@@ -91,48 +144,64 @@ void Tokenizer::processIndentation() {
     }
 }
 
+// Emits a queued INDENT or DEDENT, if any.
+bool Tokenizer::takePending(Token& token) {
+    if (m_pendingIndent) {
+        m_pendingIndent = false;
+        token = Token(TokenType::Indent, static_cast<uint32_t>(m_pos), 0);
+        if (m_deferIndentation) token.symbol = static_cast<uint32_t>(m_lineIndent);
+        return true;
+    }
+    if (m_pendingDedents > 0) {
+        m_pendingDedents--;
+        token = Token(TokenType::Dedent, static_cast<uint32_t>(m_pos), 0);
+        return true;
+    }
+    return false;
+}
+
+// Queues a DEDENT for every open block.
+void Tokenizer::closeIndentation() {
+    while (m_indentStack.size() > 1) {
+        m_indentStack.pop_back();
+        m_pendingDedents++;
+    }
+}
+
 Token Tokenizer::nextToken() {
     if (m_hasPeeked) {
         m_hasPeeked = false;
         return m_peekedToken;
     }
-    // Emit any pending INDENT/DEDENT tokens first
-    if (!m_pendingIndents.empty()) {
-        Token t = m_pendingIndents.front();
-        m_pendingIndents.pop();
-        return t;
+    if (m_buffered) {
+        if (m_nextToken < m_tokens.size()) return m_tokens[m_nextToken++];
+        if (m_error) std::rethrow_exception(m_error);
+        return m_tokens.back(); // EndOfInput again
     }
+    Token token;
+    // Emit any pending INDENT/DEDENT tokens first
+    if (takePending(token)) return token;
     // At start of line, process indentation
     if (m_atLineStart && !isAtEnd()) {
         processIndentation();
         m_atLineStart = false;
-        if (!m_pendingIndents.empty()) {
-            Token t = m_pendingIndents.front();
-            m_pendingIndents.pop();
-            return t;
-        }
+        if (takePending(token)) return token;
     }
     skipWhitespace();
     if (isAtEnd()) {
         // At EOF, emit DEDENTs for any remaining indentation
-        while (m_indentStack.size() > 1) {
-            m_indentStack.pop_back();
-            m_pendingIndents.push(Token(TokenType::Dedent, "<DEDENT>"));
-        }
-        if (!m_pendingIndents.empty()) {
-            Token t = m_pendingIndents.front();
-            m_pendingIndents.pop();
-            return t;
-        }
-        return Token(TokenType::EndOfInput, "");
+        closeIndentation();
+        if (takePending(token)) return token;
+        return Token(TokenType::EndOfInput, static_cast<uint32_t>(m_pos), 0);
     }
     char c = peekChar();
     if (c == '\n') {
+        size_t start = m_pos;
         getChar();
-        return Token(TokenType::Newline, "\\n");
+        return makeToken(TokenType::Newline, start);
     }
     if (c == '#') {
-        while (!isAtEnd() && peekChar() != '\n') getChar();
+        skipTo(m_scan.findNewline(cursor(), inputEnd()));
         return nextToken();
     }
     if (std::isdigit(c) || (c == '.' && m_pos + 1 < m_input.size() && std::isdigit(m_input[m_pos + 1]))) {
@@ -155,100 +224,299 @@ Token Tokenizer::peekToken() {
     return m_peekedToken;
 }
 
-Token Tokenizer::lexNumber() {
-    size_t start = m_pos;
-    bool hasDot = false;
-    while (!isAtEnd() && (std::isdigit(peekChar()) || peekChar() == '.')) {
-        if (peekChar() == '.') {
-            if (hasDot) break;
-            hasDot = true;
+std::string_view Tokenizer::lexeme(const Token& token) const {
+    switch (token.type) {
+        case TokenType::Indent: return "<INDENT>";
+        case TokenType::Dedent: return "<DEDENT>";
+        case TokenType::Newline: return "\\n";
+        case TokenType::EndOfInput: return "";
+        default: return m_input.substr(token.offset, token.length);
+    }
+}
+
+Symbol Tokenizer::stringValue(const Token& token) const {
+    // Skip the opening quote; the closing one may be missing at end of input
+    std::string_view text = m_input.substr(token.offset + 1, token.length - 1);
+    char quote = m_input[token.offset];
+    if (text.find('\\') == std::string_view::npos) {
+        if (!text.empty() && text.back() == quote) text.remove_suffix(1);
+        return Symbol::intern(text);
+    }
+
+    std::string value;
+    value.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == quote) break;
+        if (text[i] != '\\') {
+            value += text[i];
+            continue;
+        }
+        if (++i == text.size()) {
+            value += '\\';
+            break;
+        }
+        switch (text[i]) {
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case 'r': value += '\r'; break;
+            case '"': value += '"'; break;
+            case '\'': value += '\''; break;
+            case '\\': value += '\\'; break;
+            default: value += text[i]; break;
         }
-        getChar();
     }
-    std::string numStr = m_input.substr(start, m_pos - start);
-    double value = std::stod(numStr);
-    return Token(TokenType::Number, numStr, value);
+    return Symbol::intern(value);
+}
+
+SourceLocation Tokenizer::location(uint32_t offset) const {
+    auto line = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), offset) - 1;
+    return {static_cast<uint32_t>(line - m_lineStarts.begin() + 1), offset - *line + 1};
+}
+
+Token Tokenizer::lexNumber() {
+    size_t start = m_pos;
+    // Digits with at most one '.', which may come first
+    skipTo(m_scan.skipDigits(cursor(), inputEnd()));
+    if (matchChar('.')) skipTo(m_scan.skipDigits(cursor(), inputEnd()));
+    double value = 0;
+    auto result = std::from_chars(m_input.data() + start, m_input.data() + m_pos, value);
+    if (result.ec != std::errc()) throw std::runtime_error("Invalid number literal");
+    Token token = makeToken(TokenType::Number, start);
+    token.number = value;
+    return token;
 }
 
 Token Tokenizer::lexIdentifierOrKeyword() {
     size_t start = m_pos;
-    while (!isAtEnd() && (std::isalnum(peekChar()) || peekChar() == '_')) {
-        getChar();
+    skipTo(m_scan.skipIdentifier(cursor(), inputEnd()));
+    std::string_view ident = m_input.substr(start, m_pos - start);
+    TokenType keyword;
+    if (findKeyword(ident, keyword)) {
+        return makeToken(keyword, start);
     }
-    std::string ident = m_input.substr(start, m_pos - start);
-    auto it = keywords.find(ident);
-    if (it != keywords.end()) {
-        return Token(it->second, ident);
+    Token token = makeToken(TokenType::Identifier, start);
+    if (m_localNames) {
+        auto [it, added] = m_localNames->ids.emplace(ident, static_cast<uint32_t>(m_localNames->texts.size()));
+        if (added) m_localNames->texts.push_back(ident);
+        token.symbol = it->second;
+    } else {
+        token.symbol = Symbol::intern(ident).id();
     }
-    return Token(TokenType::Identifier, ident, ident);
+    return token;
 }
 
+// Only finds the end of the literal; stringValue decodes it.
 Token Tokenizer::lexString() {
+    size_t start = m_pos;
     char quote = getChar(); // consume opening quote
-    std::string value;
-    while (!isAtEnd() && peekChar() != quote) {
-        if (peekChar() == '\\') {
-            getChar(); // consume backslash
-            if (!isAtEnd()) {
-                char next = getChar();
-                switch (next) {
-                    case 'n': value += '\n'; break;
-                    case 't': value += '\t'; break;
-                    case 'r': value += '\r'; break;
-                    case '"': value += '"'; break;
-                    case '\'': value += '\''; break;
-                    case '\\': value += '\\'; break;
-                    default: value += next; break;
-                }
-            } else {
-                value += '\\';
-            }
-        } else {
-            value += getChar();
-        }
+    while (true) {
+        // Newlines go through getChar so that line starts are recorded
+        skipTo(m_scan.findStringStop(cursor(), inputEnd(), quote));
+        if (isAtEnd() || peekChar() == quote) break;
+        if (getChar() == '\\') getChar(); // skip the escaped character
     }
     if (peekChar() == quote) getChar(); // consume closing quote
-    return Token(TokenType::String, value, value);
+    return makeToken(TokenType::String, start);
 }
 
 Token Tokenizer::lexOperatorOrDelimiter() {
+    size_t start = m_pos;
     char c = getChar();
     // Two-char operators
     if (!isAtEnd()) {
         char next = peekChar();
-        std::string two = std::string(1, c) + next;
-        if (two == "+=" || two == "-=" || two == "==" || two == "!=" || two == "<=" || two == ">=" || two == "**") {
+        TokenType type = TokenType::EndOfInput;
+        if (c == '+' && next == '=') type = TokenType::PlusAssign;
+        else if (c == '-' && next == '=') type = TokenType::MinusAssign;
+        else if (c == '=' && next == '=') type = TokenType::Equal;
+        else if (c == '!' && next == '=') type = TokenType::NotEqual;
+        else if (c == '<' && next == '=') type = TokenType::LessEqual;
+        else if (c == '>' && next == '=') type = TokenType::GreaterEqual;
+        else if (c == '*' && next == '*') type = TokenType::Power;
+        if (type != TokenType::EndOfInput) {
             getChar();
-            if (two == "+=") return Token(TokenType::PlusAssign, two);
-            if (two == "-=") return Token(TokenType::MinusAssign, two);
-            if (two == "==") return Token(TokenType::Equal, two);
-            if (two == "!=") return Token(TokenType::NotEqual, two);
-            if (two == "<=") return Token(TokenType::LessEqual, two);
-            if (two == ">=") return Token(TokenType::GreaterEqual, two);
-            if (two == "**") return Token(TokenType::Power, two);
+            return makeToken(type, start);
         }
     }
     // Single-char tokens
     switch (c) {
-        case '+': return Token(TokenType::Plus, "+");
-        case '-': return Token(TokenType::Minus, "-");
-        case '*': return Token(TokenType::Star, "*");
-        case '/': return Token(TokenType::Slash, "/");
-        case '%': return Token(TokenType::Percent, "%");
-        case '=': return Token(TokenType::Assign, "=");
-        case '<': return Token(TokenType::Less, "<");
-        case '>': return Token(TokenType::Greater, ">");
-        case ':': return Token(TokenType::Colon, ":");
-        case ',': return Token(TokenType::Comma, ",");
-        case '.': return Token(TokenType::Dot, ".");
-        case ';': return Token(TokenType::Semicolon, ";");
-        case '(': return Token(TokenType::LeftParen, "(");
-        case ')': return Token(TokenType::RightParen, ")");
-        case '[': return Token(TokenType::LeftBracket, "[");
-        case ']': return Token(TokenType::RightBracket, "]");
-        case '{': return Token(TokenType::LeftBrace, "{");
-        case '}': return Token(TokenType::RightBrace, "}");
+        case '+': return makeToken(TokenType::Plus, start);
+        case '-': return makeToken(TokenType::Minus, start);
+        case '*': return makeToken(TokenType::Star, start);
+        case '/': return makeToken(TokenType::Slash, start);
+        case '%': return makeToken(TokenType::Percent, start);
+        case '=': return makeToken(TokenType::Assign, start);
+        case '<': return makeToken(TokenType::Less, start);
+        case '>': return makeToken(TokenType::Greater, start);
+        case ':': return makeToken(TokenType::Colon, start);
+        case ',': return makeToken(TokenType::Comma, start);
+        case '.': return makeToken(TokenType::Dot, start);
+        case ';': return makeToken(TokenType::Semicolon, start);
+        case '(': return makeToken(TokenType::LeftParen, start);
+        case ')': return makeToken(TokenType::RightParen, start);
+        case '[': return makeToken(TokenType::LeftBracket, start);
+        case ']': return makeToken(TokenType::RightBracket, start);
+        case '{': return makeToken(TokenType::LeftBrace, start);
+        case '}': return makeToken(TokenType::RightBrace, start);
         default:
             throw std::runtime_error(std::string("Unknown character: ") + c);
     }
 }
+
+// --- Parallel lexing ---
+// Each chunk starts just after a newline and is lexed as if the tokenizer
+// stood at a line start there, with indentation deferred. The stitch step
+// then walks the chunks in order with the real lexer position: when a chunk
+// was entered in the middle of a token (a string literal spanning the
+// boundary), its tokens are picked up again from the first line start the
+// real position and the chunk lexer share, or the chunk is lexed again from
+// there. Indent tokens are resolved against m_indentStack as they are
+// copied, and identifiers are interned in stream order.
+
+struct Tokenizer::LexedRange {
+    size_t start = 0;             // chunk bounds in the input
+    size_t end = 0;
+    std::vector<Token> tokens;
+    // (offset, token index) of every line start the lexer passed
+    std::vector<std::pair<size_t, size_t>> lineStarts;
+    LocalNames names;
+    std::vector<uint32_t> newlines; // offsets of the newlines in [start, end)
+    size_t exit = 0;              // where lexing stopped
+    std::exception_ptr error;     // raised after the last token
+};
+
+// Lexes from the line start at `from` up to the first line start at or past
+// `until`, or to the end of input.
+void Tokenizer::lexRange(LexedRange& out, size_t from, size_t until) const {
+    Tokenizer lexer(m_input);
+    lexer.m_pos = from;
+    lexer.m_deferIndentation = true;
+    lexer.m_localNames = &out.names;
+    try {
+        while (true) {
+            if (lexer.m_atLineStart) {
+                if (lexer.m_pos >= until && !lexer.isAtEnd()) break;
+                out.lineStarts.emplace_back(lexer.m_pos, out.tokens.size());
+            }
+            out.tokens.push_back(lexer.nextToken());
+            if (out.tokens.back().type == TokenType::EndOfInput) break;
+        }
+    } catch (...) {
+        out.error = std::current_exception();
+    }
+    out.exit = lexer.m_pos;
+}
+
+// Appends range.tokens[first..] to m_tokens. Returns false once the stream
+// is complete, at the end of input or at an error.
+bool Tokenizer::appendRange(const LexedRange& range, size_t first) {
+    static constexpr uint32_t kUnmapped = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> symbols(range.names.texts.size(), kUnmapped);
+    Token pending;
+    try {
+        for (size_t i = first; i < range.tokens.size(); ++i) {
+            Token token = range.tokens[i];
+            switch (token.type) {
+            case TokenType::Indent:
+                m_pos = token.offset;
+                applyIndentation(static_cast<int>(token.symbol));
+                while (takePending(pending)) m_tokens.push_back(pending);
+                break;
+            case TokenType::Identifier: {
+                uint32_t& symbol = symbols[token.symbol];
+                if (symbol == kUnmapped) symbol = Symbol::intern(range.names.texts[token.symbol]).id();
+                token.symbol = symbol;
+                m_tokens.push_back(token);
+                break;
+            }
+            case TokenType::EndOfInput:
+                m_pos = token.offset;
+                closeIndentation();
+                while (takePending(pending)) m_tokens.push_back(pending);
+                m_tokens.push_back(token);
+                return false;
+            default:
+                m_tokens.push_back(token);
+                break;
+            }
+        }
+    } catch (...) {
+        m_error = std::current_exception();
+        return false;
+    }
+    if (range.error) {
+        m_error = range.error;
+        return false;
+    }
+    return true;
+}
+
+void Tokenizer::lexInParallel(unsigned threads, size_t chunkBytes) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    chunkBytes = std::max<size_t>(chunkBytes, 1);
+
+    std::vector<LexedRange> chunks;
+    size_t start = 0;
+    do {
+        size_t end = std::min(start + chunkBytes, m_input.size());
+        if (end < m_input.size()) {
+            // Extend to just past the newline ending the line that holds end - 1
+            end = static_cast<size_t>(m_scan.findNewline(m_input.data() + end - 1, inputEnd()) - m_input.data());
+            end = std::min(end + 1, m_input.size());
+        }
+        chunks.emplace_back();
+        chunks.back().start = start;
+        chunks.back().end = end;
+        start = end;
+    } while (start < m_input.size());
+
+    // Threads take the next unclaimed chunk until none are left
+    std::atomic<size_t> nextChunk{0};
+    auto work = [&] {
+        for (size_t i; (i = nextChunk++) < chunks.size();) {
+            LexedRange& chunk = chunks[i];
+            lexRange(chunk, chunk.start, chunk.end);
+            const char* end = m_input.data() + chunk.end;
+            for (const char* p = m_input.data() + chunk.start; (p = m_scan.findNewline(p, end)) < end; ++p) {
+                chunk.newlines.push_back(static_cast<uint32_t>(p - m_input.data()));
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < std::min<size_t>(threads, chunks.size()); ++i) pool.emplace_back(work);
+    work();
+    for (std::thread& thread : pool) thread.join();
+
+    size_t tokenCount = 0;
+    for (const LexedRange& chunk : chunks) {
+        tokenCount += chunk.tokens.size();
+        for (uint32_t newline : chunk.newlines) m_lineStarts.push_back(newline + 1);
+    }
+    m_tokens.reserve(tokenCount);
+
+    // Stitch, following the real lexer position from chunk to chunk
+    size_t pos = 0;
+    for (LexedRange& chunk : chunks) {
+        size_t first = 0;
+        if (pos != chunk.start) {
+            auto resync = std::lower_bound(chunk.lineStarts.begin(), chunk.lineStarts.end(),
+                                           std::make_pair(pos, size_t(0)));
+            if (resync != chunk.lineStarts.end() && resync->first == pos) {
+                first = resync->second;
+            } else if (pos >= chunk.end) {
+                continue; // Covered by a token from an earlier chunk
+            } else {
+                LexedRange again;
+                lexRange(again, pos, chunk.end);
+                chunk.tokens = std::move(again.tokens);
+                chunk.names = std::move(again.names);
+                chunk.exit = again.exit;
+                chunk.error = again.error;
+            }
+        }
+        if (!appendRange(chunk, first)) break;
+        pos = chunk.exit;
+    }
+    m_pos = m_input.size();
+    m_buffered = true;
+}
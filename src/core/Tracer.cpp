@@ -0,0 +1,1257 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include "core/Tracer.h"
+#include "core/ExecutableMemory.h"
+#include "core/Operations.h"
+#include "core/X86Assembler.h"
+
+namespace {
+
+constexpr uint32_t kHotLoop = 50;         // passes through a loop head before it is recorded
+constexpr uint32_t kNever = UINT32_MAX;   // threshold of a loop left to the engine
+constexpr uint32_t kMaxAttempts = 3;      // failed recordings and dropped traces per loop
+constexpr uint32_t kMaxShortRuns = 16;    // consecutive runs of fewer than kMinIterations
+constexpr int64_t kMinIterations = 2;
+constexpr uint32_t kHotExit = 16;         // side exits through one guard before its branch is merged...
+constexpr uint64_t kHotExitRatio = 64;    // ...if it is also taken once every this many iterations
+constexpr size_t kMaxTraceLength = 2000;  // instructions recorded per trace
+
+// A variable the loop may leave unassigned, as in Jit: a signaling NaN,
+// which no computation produces.
+constexpr uint64_t kUnbound = 0x7FF4000000000000ULL;
+
+uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+// A variable of the loop as its trace sees it.
+struct TraceVariable {
+    Symbol name;
+    Binding binding;
+    bool read = false;     // read before the trace assigns it: must be a number on entry
+    bool written = false;  // assigned by the trace: written back on exit
+};
+
+// A compiled trace. Its entry takes the values of the range counter (if
+// counted: current, stop, step), then of the variables, then room for the
+// number of iterations run, an int64; it updates them in place. It returns
+// 0 when the loop has finished, or 1 + k after a side exit through guard k.
+struct Trace {
+    using Entry = int (*)(double* values);
+
+    ExecutableMemory code;
+    Entry entry = nullptr;
+    std::vector<TraceVariable> variables;
+    bool counted = false;    // a for loop over a range
+    bool ascending = true;   // whose step is positive
+    std::vector<NodeIndex> exits;      // the 'if' each guard stands for
+    std::vector<uint32_t> exitCounts;  // side exits through each guard
+    uint64_t iterations = 0;           // run natively, over all runs
+};
+
+static std::unique_ptr<Trace> recordTrace(const Ast& ast, const Stmt& loop, Environment& globals,
+                                          Environment& frame, const RangeCounter* counter,
+                                          const std::vector<NodeIndex>& merged);
+
+// Where a variable lives. Assignments mirror the engines: a global is
+// defined by name, a local in the current frame's slot.
+static Value* locate(Environment& globals, Environment& frame, const TraceVariable& variable) {
+    if (variable.binding.is_global()) return globals.entry(variable.name);
+    return &frame.ancestor(variable.binding.depth)->slot(variable.binding.slot);
+}
+
+TraceLoop::TraceLoop(const Ast& ast, const Stmt& loop) : m_ast(ast), m_loop(loop), m_threshold(kHotLoop) {}
+
+TraceLoop::~TraceLoop() = default;
+
+bool TraceLoop::run(Environment& globals, Environment& frame, RangeCounter* counter) {
+    if (m_threshold == kNever || (m_loop.kind == StmtKind::For) != (counter != nullptr)) return false;
+    if (!m_trace) {
+        m_trace = recordTrace(m_ast, m_loop, globals, frame, counter, m_merged);
+        if (!m_trace) {
+            ++traceStats().aborted;
+            retry();
+            return false;
+        }
+        ++traceStats().compiled;
+        traceStats().codeBytes += m_trace->code.size();
+        m_threshold = 0;
+    }
+    Trace& trace = *m_trace;
+
+    // Entry: every variable read before it is assigned must be a number
+    size_t base = trace.counted ? 3 : 0;
+    size_t count = trace.variables.size();
+    m_values.resize(base + count + 1);
+    m_slots.resize(count);
+    if (trace.counted) {
+        if ((counter->step > 0) != trace.ascending) {
+            ++traceStats().declined;
+            shortRun();
+            return false;
+        }
+        m_values[0] = counter->current;
+        m_values[1] = counter->stop;
+        m_values[2] = counter->step;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const TraceVariable& variable = trace.variables[i];
+        Value* slot = locate(globals, frame, variable);
+        m_slots[i] = slot;
+        if (slot && slot->is_number()) {
+            m_values[base + i] = slot->as_number();
+        } else if (!variable.read) {
+            std::memcpy(&m_values[base + i], &kUnbound, sizeof(double));
+        } else {
+            ++traceStats().declined;
+            shortRun();
+            return false;
+        }
+    }
+
+    ++traceStats().entered;
+    int status = trace.entry(m_values.data());
+    int64_t iterations;
+    std::memcpy(&iterations, &m_values[base + count], sizeof(iterations));
+    traceStats().iterations += static_cast<uint64_t>(iterations);
+    trace.iterations += static_cast<uint64_t>(iterations);
+
+    // Write back; a number stored over a number keeps the global's binding
+    // version, as in GlobalNumberStore
+    for (size_t i = 0; i < count; ++i) {
+        const TraceVariable& variable = trace.variables[i];
+        double value = m_values[base + i];
+        if (!variable.written || bitsOf(value) == kUnbound) continue;
+        Value* slot = m_slots[i];
+        if (slot && (slot->is_number() || !variable.binding.is_global())) *slot = value;
+        else globals.set(variable.name, value);
+    }
+    if (trace.counted) counter->current = m_values[0];
+
+    if (status == 0) {
+        ++traceStats().finished;
+        m_shortRuns = 0;
+        return true;
+    }
+    ++traceStats().sideExits;
+    size_t exit = static_cast<size_t>(status - 1);
+    uint32_t exits = ++trace.exitCounts[exit];
+    if (exits >= kHotExit && exits * kHotExitRatio >= trace.iterations) {
+        // A branch taken this often is worth computing in the trace
+        NodeIndex branch = trace.exits[exit];
+        if (std::find(m_merged.begin(), m_merged.end(), branch) == m_merged.end()) {
+            m_merged.push_back(branch);
+            ++traceStats().merged;
+            m_trace.reset();
+            m_count = 0;
+            m_threshold = kHotLoop;
+            return false;
+        }
+    }
+    if (iterations >= kMinIterations) m_shortRuns = 0;
+    else shortRun();
+    return false;
+}
+
+// A run that did not get through enough iterations to pay for entering.
+// Too many in a row and the trace is dropped.
+void TraceLoop::shortRun() {
+    if (++m_shortRuns < kMaxShortRuns) return;
+    m_shortRuns = 0;
+    m_trace.reset();
+    retry();
+}
+
+// Counts a failed attempt. The loop is recorded again once it gets hot
+// again, up to kMaxAttempts times.
+void TraceLoop::retry() {
+    m_count = 0;
+    if (++m_attempts < kMaxAttempts) {
+        m_threshold = kHotLoop;
+    } else {
+        m_threshold = kNever;
+        ++traceStats().blacklisted;
+    }
+}
+
+#ifdef JIT_X86_64
+
+namespace {
+
+using A = X86Assembler;
+
+double traceFmod(double a, double b) { return NumberKernel<TokenType::Percent>::apply(a, b); }
+double tracePow(double a, double b) { return NumberKernel<TokenType::Power>::apply(a, b); }
+
+// --- Trace IR ---
+// A trace is a list of instructions in SSA form: each value is the index of
+// the instruction computing it.
+
+enum class Op : uint8_t {
+    Input,  // a: value slot; its value at the loop head
+    Const,  // number
+    Add, Sub, Mul, Div, Mod, Pow,
+    Lt, Le, Eq, Ne,  // 1.0 or 0.0; > and >= are recorded as < and <= swapped
+    And, Or,
+    Neg, Not,
+    Select,  // b if a is truthy, else c
+    Exit,    // leave the loop, finished, unless a's truthiness is expect
+    Guard,   // side exit unless a's truthiness is expect
+};
+
+constexpr uint32_t kNone = UINT32_MAX;
+
+struct Ins {
+    Op op;
+    bool expect = true;  // Exit, Guard
+    uint32_t a = kNone;
+    uint32_t b = kNone;
+    uint32_t c = kNone;
+    double number = 0;   // Const
+    NodeIndex branch = kNoNode;  // Guard: its 'if'
+};
+
+int arity(Op op) {
+    switch (op) {
+    case Op::Input:
+    case Op::Const: return 0;
+    case Op::Neg:
+    case Op::Not:
+    case Op::Exit:
+    case Op::Guard: return 1;
+    case Op::Select: return 3;
+    default: return 2;
+    }
+}
+
+template <typename F>
+void forOperands(const Ins& ins, F f) {
+    int count = arity(ins.op);
+    if (count > 0) f(ins.a);
+    if (count > 1) f(ins.b);
+    if (count > 2) f(ins.c);
+}
+
+bool isPure(Op op) { return op != Op::Exit && op != Op::Guard; }
+bool isCompare(Op op) { return op == Op::Lt || op == Op::Le || op == Op::Eq || op == Op::Ne; }
+
+// The NumberKernel results the engines compute.
+double fold(Op op, double a, double b, double c) {
+    switch (op) {
+    case Op::Add: return NumberKernel<TokenType::Plus>::apply(a, b);
+    case Op::Sub: return NumberKernel<TokenType::Minus>::apply(a, b);
+    case Op::Mul: return NumberKernel<TokenType::Star>::apply(a, b);
+    case Op::Div: return NumberKernel<TokenType::Slash>::apply(a, b);
+    case Op::Mod: return NumberKernel<TokenType::Percent>::apply(a, b);
+    case Op::Pow: return NumberKernel<TokenType::Power>::apply(a, b);
+    case Op::Lt: return NumberKernel<TokenType::Less>::apply(a, b);
+    case Op::Le: return NumberKernel<TokenType::LessEqual>::apply(a, b);
+    case Op::Eq: return NumberKernel<TokenType::Equal>::apply(a, b);
+    case Op::Ne: return NumberKernel<TokenType::NotEqual>::apply(a, b);
+    case Op::And: return NumberKernel<TokenType::And>::apply(a, b);
+    case Op::Or: return NumberKernel<TokenType::Or>::apply(a, b);
+    case Op::Neg: return -a;
+    case Op::Not: return a != 0.0 ? 0.0 : 1.0;
+    case Op::Select: return a != 0.0 ? b : c;
+    default: return 0;
+    }
+}
+
+// A value slot of the trace: the range counter's current, stop and step
+// come first when counted, then the variables.
+struct Slot {
+    uint32_t input = kNone;  // Input instruction, once the slot is used
+    uint32_t value = kNone;  // current value while recording, the output after
+    bool read = false;
+    bool written = false;
+};
+
+struct Recording {
+    std::vector<Ins> code;
+    std::vector<Slot> slots;
+    std::vector<TraceVariable> variables;  // for slots[base...]
+    bool counted = false;
+    bool ascending = true;
+    uint32_t base() const { return counted ? 3 : 0; }
+};
+
+// --- Recording ---
+
+// Walks one iteration of the loop on the current values of its variables,
+// emitting the operations it performs. Folds constants and reuses equal
+// subexpressions as it goes, and drops guards that cannot fail.
+//
+// An 'if' is recorded as a guard on the branch the values take. An 'if'
+// listed in merged instead has both branches recorded: each statement
+// runs under a predicate, the condition of the branches it sits in, and
+// an assignment under one selects between the new value and the old.
+// 'continue' clears the predicate of the rest of the iteration. An 'if'
+// whose branches cannot both be recorded stays a guard.
+class Recorder {
+public:
+    Recorder(const Ast& ast, Environment& globals, Environment& frame, const std::vector<NodeIndex>& merged)
+        : m_ast(ast), m_globals(globals), m_frame(frame), m_merged(merged) {}
+
+    bool record(const Stmt& loop, const RangeCounter* counter, Recording& out);
+
+private:
+    const Ast& m_ast;
+    Environment& m_globals;
+    Environment& m_frame;
+    const std::vector<NodeIndex>& m_merged;
+
+    // Everything an 'if' that fails to merge rolls back
+    struct State {
+        Recording rec;
+        std::vector<double> observed;  // each value in the recorded iteration
+        std::map<std::tuple<Op, uint32_t, uint32_t, uint32_t, uint64_t>, uint32_t> numbering;
+        std::map<uint32_t, bool> known;  // values whose truthiness a guard established
+        uint32_t predicate = kNone;      // under which the current statement runs
+        uint32_t typeGuards = 0;
+        uint32_t branchGuards = 0;
+        uint32_t eliminated = 0;
+    };
+    State m_state;
+
+    uint32_t append(const Ins& ins, double observed);
+    uint32_t input(uint32_t slot, double observed);
+    uint32_t constant(double number);
+    uint32_t operation(Op op, uint32_t a, uint32_t b = kNone, uint32_t c = kNone);
+    bool isConstant(uint32_t value, bool truthy) const;
+    uint32_t conjoin(uint32_t a, uint32_t b);
+    uint32_t disjoin(uint32_t a, uint32_t b);
+    void guard(Op op, uint32_t value, bool expect, NodeIndex branch = kNoNode);
+    uint32_t slotOf(Symbol name, const Binding& binding);
+    bool readSlot(uint32_t slot, uint32_t& value);
+    bool assign(uint32_t slot, uint32_t value);
+
+    bool block(NodeList statements);
+    bool statement(NodeIndex index);
+    bool guardedIf(const Stmt& stmt, NodeIndex index);
+    bool mergedIf(const Stmt& stmt);
+    bool expression(NodeIndex index, uint32_t& value);
+};
+
+uint32_t Recorder::append(const Ins& ins, double observed) {
+    m_state.rec.code.push_back(ins);
+    m_state.observed.push_back(observed);
+    return static_cast<uint32_t>(m_state.rec.code.size() - 1);
+}
+
+uint32_t Recorder::input(uint32_t slot, double observed) {
+    Ins ins{Op::Input};
+    ins.a = slot;
+    uint32_t value = append(ins, observed);
+    m_state.rec.slots[slot].input = value;
+    return value;
+}
+
+uint32_t Recorder::constant(double number) {
+    auto key = std::make_tuple(Op::Const, kNone, kNone, kNone, bitsOf(number));
+    auto it = m_state.numbering.find(key);
+    if (it != m_state.numbering.end()) return it->second;
+    Ins ins{Op::Const};
+    ins.number = number;
+    uint32_t value = append(ins, number);
+    m_state.numbering.emplace(key, value);
+    return value;
+}
+
+uint32_t Recorder::operation(Op op, uint32_t a, uint32_t b, uint32_t c) {
+    const std::vector<double>& observed = m_state.observed;
+    double result = fold(op, observed[a], b != kNone ? observed[b] : 0.0, c != kNone ? observed[c] : 0.0);
+    bool folds = true;
+    Ins ins{op};
+    ins.a = a;
+    ins.b = b;
+    ins.c = c;
+    forOperands(ins, [&](uint32_t operand) { folds = folds && m_state.rec.code[operand].op == Op::Const; });
+    if (folds) return constant(result);
+    if (op == Op::Select) {
+        if (isConstant(a, true)) return b;
+        if (isConstant(a, false) || b == c) return c;
+    }
+    auto key = std::make_tuple(op, a, b, c, uint64_t{0});
+    auto it = m_state.numbering.find(key);
+    if (it != m_state.numbering.end()) return it->second;
+    uint32_t value = append(ins, result);
+    m_state.numbering.emplace(key, value);
+    return value;
+}
+
+bool Recorder::isConstant(uint32_t value, bool truthy) const {
+    const Ins& ins = m_state.rec.code[value];
+    return ins.op == Op::Const && (ins.number != 0.0) == truthy;
+}
+
+// Predicates only matter by truthiness.
+uint32_t Recorder::conjoin(uint32_t a, uint32_t b) {
+    if (isConstant(a, true)) return b;
+    if (isConstant(b, true)) return a;
+    return operation(Op::And, a, b);
+}
+
+uint32_t Recorder::disjoin(uint32_t a, uint32_t b) {
+    if (isConstant(a, false)) return b;
+    if (isConstant(b, false)) return a;
+    return operation(Op::Or, a, b);
+}
+
+// Exit or Guard on the truthiness the value has now. not x is guarded as
+// x; a guard on a constant or on a value already guarded is dropped.
+void Recorder::guard(Op op, uint32_t value, bool expect, NodeIndex branch) {
+    if (op == Op::Guard) ++m_state.branchGuards;
+    while (m_state.rec.code[value].op == Op::Not) {
+        value = m_state.rec.code[value].a;
+        expect = !expect;
+    }
+    if (m_state.rec.code[value].op == Op::Const || m_state.known.count(value)) {
+        if (op == Op::Guard) ++m_state.eliminated;
+        return;
+    }
+    m_state.known.emplace(value, expect);
+    Ins ins{op};
+    ins.a = value;
+    ins.expect = expect;
+    ins.branch = branch;
+    append(ins, 0);
+}
+
+uint32_t Recorder::slotOf(Symbol name, const Binding& binding) {
+    Recording& rec = m_state.rec;
+    uint32_t base = rec.base();
+    for (uint32_t i = 0; i < rec.variables.size(); ++i) {
+        const TraceVariable& variable = rec.variables[i];
+        if (variable.name == name && variable.binding.depth == binding.depth &&
+            variable.binding.slot == binding.slot) {
+            return base + i;
+        }
+    }
+    TraceVariable variable;
+    variable.name = name;
+    variable.binding = binding;
+    rec.variables.push_back(variable);
+    rec.slots.emplace_back();
+    return static_cast<uint32_t>(rec.slots.size() - 1);
+}
+
+// A slot's value in this iteration, or at the loop head if the iteration
+// has not assigned it yet, which must be a number.
+bool Recorder::readSlot(uint32_t slot, uint32_t& value) {
+    Recording& rec = m_state.rec;
+    if (rec.slots[slot].value != kNone) {
+        value = rec.slots[slot].value;
+        return true;
+    }
+    Value* current = locate(m_globals, m_frame, rec.variables[slot - rec.base()]);
+    if (!current || !current->is_number()) return false;
+    Slot& state = rec.slots[slot];
+    state.read = true;
+    state.value = state.input == kNone ? input(slot, current->as_number()) : state.input;
+    value = state.value;
+    return true;
+}
+
+bool Recorder::assign(uint32_t slot, uint32_t value) {
+    Recording& rec = m_state.rec;
+    if (!isConstant(m_state.predicate, true)) {
+        uint32_t old;
+        if (!readSlot(slot, old)) return false;
+        value = operation(Op::Select, m_state.predicate, value, old);
+    }
+    if (rec.slots[slot].input == kNone) {
+        // Its value at the loop head is written back by a side exit
+        Value* current = locate(m_globals, m_frame, rec.variables[slot - rec.base()]);
+        input(slot, current && current->is_number() ? current->as_number() : 0.0);
+    }
+    rec.slots[slot].value = value;
+    rec.slots[slot].written = true;
+    return true;
+}
+
+bool Recorder::record(const Stmt& loop, const RangeCounter* counter, Recording& out) {
+    Recording& rec = m_state.rec;
+    rec.counted = counter != nullptr;
+    m_state.predicate = constant(1.0);
+    if (counter) {
+        // Head of a counted loop: value = current; current += step
+        if (!counter->has_next()) return false;
+        rec.ascending = counter->step > 0;
+        rec.slots.resize(3);
+        uint32_t current = input(0, counter->current);
+        uint32_t stop = input(1, counter->stop);
+        uint32_t step = input(2, counter->step);
+        rec.slots[0].read = rec.slots[1].read = rec.slots[2].read = true;
+        rec.slots[1].value = stop;
+        rec.slots[2].value = step;
+        guard(Op::Exit, rec.ascending ? operation(Op::Lt, current, stop) : operation(Op::Lt, stop, current), true);
+        Binding binding = loop.binding;
+        if (!binding.is_global()) binding.depth = 0;
+        assign(slotOf(loop.name, binding), current);
+        assign(0, operation(Op::Add, current, step));
+    } else {
+        uint32_t condition;
+        if (!expression(loop.expr, condition) || m_state.observed[condition] == 0.0) return false;
+        guard(Op::Exit, condition, true);
+    }
+    if (!block(loop.body) || m_state.rec.code.size() > kMaxTraceLength) return false;
+
+    for (uint32_t i = rec.base(); i < rec.slots.size(); ++i) {
+        TraceVariable& variable = rec.variables[i - rec.base()];
+        variable.read = rec.slots[i].read;
+        variable.written = rec.slots[i].written;
+    }
+    // Every variable read is checked once on entry instead of at each read
+    uint32_t entryChecks = 0;
+    for (const TraceVariable& variable : rec.variables) entryChecks += variable.read;
+    traceStats().guards += m_state.typeGuards + m_state.branchGuards;
+    traceStats().guardsEliminated += m_state.typeGuards - std::min(entryChecks, m_state.typeGuards) + m_state.eliminated;
+    out = std::move(rec);
+    return true;
+}
+
+bool Recorder::block(NodeList statements) {
+    for (NodeIndex index : m_ast.statementList(statements)) {
+        if (isConstant(m_state.predicate, false)) return true;
+        if (!statement(index)) return false;
+    }
+    return true;
+}
+
+// False for anything a trace does not run: calls and other objects, a
+// nested loop or function, return, and break (the recorded iteration
+// would be the last).
+bool Recorder::statement(NodeIndex index) {
+    const Stmt& stmt = m_ast.stmt(index);
+    uint32_t value;
+    switch (stmt.kind) {
+    case StmtKind::Expression:
+        return expression(stmt.expr, value);
+    case StmtKind::Assign: {
+        if (!expression(stmt.expr, value)) return false;
+        Binding binding = stmt.binding;
+        if (!binding.is_global()) binding.depth = 0;
+        return assign(slotOf(stmt.name, binding), value);
+    }
+    case StmtKind::If:
+        if (std::find(m_merged.begin(), m_merged.end(), index) != m_merged.end()) {
+            State saved = m_state;
+            if (mergedIf(stmt)) return true;
+            m_state = std::move(saved);
+        }
+        return guardedIf(stmt, index);
+    case StmtKind::Block:
+        return block(stmt.body);
+    case StmtKind::Continue:
+        m_state.predicate = constant(0.0);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Follows the branch taken. Under a predicate the guard only holds where
+// the predicate does.
+bool Recorder::guardedIf(const Stmt& stmt, NodeIndex index) {
+    uint32_t condition;
+    if (!expression(stmt.expr, condition)) return false;
+    bool taken = m_state.observed[condition] != 0.0;
+    uint32_t predicate = m_state.predicate;
+    if (isConstant(predicate, true)) {
+        guard(Op::Guard, condition, taken, index);
+    } else {
+        uint32_t expected = taken ? condition : operation(Op::Not, condition);
+        guard(Op::Guard, disjoin(operation(Op::Not, predicate), expected), true, index);
+    }
+    return block(taken ? stmt.body : stmt.orelse);
+}
+
+bool Recorder::mergedIf(const Stmt& stmt) {
+    uint32_t condition;
+    if (!expression(stmt.expr, condition)) return false;
+    uint32_t outer = m_state.predicate;
+    uint32_t thenPredicate = conjoin(outer, condition);
+    uint32_t elsePredicate = conjoin(outer, operation(Op::Not, condition));
+    m_state.predicate = thenPredicate;
+    if (!block(stmt.body)) return false;
+    uint32_t thenRest = m_state.predicate;
+    m_state.predicate = elsePredicate;
+    if (!block(stmt.orelse)) return false;
+    uint32_t elseRest = m_state.predicate;
+    // What runs after the 'if' is what did not continue in either branch
+    if (thenRest == thenPredicate && elseRest == elsePredicate) m_state.predicate = outer;
+    else m_state.predicate = disjoin(thenRest, elseRest);
+    return true;
+}
+
+bool Recorder::expression(NodeIndex index, uint32_t& value) {
+    const Expr& expr = m_ast.expr(index);
+    switch (expr.kind) {
+    case ExprKind::Number:
+        value = constant(expr.number);
+        return true;
+    case ExprKind::Variable: {
+        ++m_state.typeGuards;
+        return readSlot(slotOf(expr.name, expr.binding), value);
+    }
+    case ExprKind::Unary: {
+        uint32_t operand;
+        if (!expression(expr.left, operand)) return false;
+        if (expr.op == TokenType::Minus) value = operation(Op::Neg, operand);
+        else if (expr.op == TokenType::Not) value = operation(Op::Not, operand);
+        else return false;
+        return true;
+    }
+    case ExprKind::Binary: {
+        uint32_t left, right;
+        if (!expression(expr.left, left) || !expression(expr.right, right)) return false;
+        switch (expr.op) {
+        case TokenType::Plus: value = operation(Op::Add, left, right); return true;
+        case TokenType::Minus: value = operation(Op::Sub, left, right); return true;
+        case TokenType::Star: value = operation(Op::Mul, left, right); return true;
+        case TokenType::Slash: value = operation(Op::Div, left, right); return true;
+        case TokenType::Percent: value = operation(Op::Mod, left, right); return true;
+        case TokenType::Power: value = operation(Op::Pow, left, right); return true;
+        case TokenType::Less: value = operation(Op::Lt, left, right); return true;
+        case TokenType::LessEqual: value = operation(Op::Le, left, right); return true;
+        case TokenType::Greater: value = operation(Op::Lt, right, left); return true;
+        case TokenType::GreaterEqual: value = operation(Op::Le, right, left); return true;
+        case TokenType::Equal: value = operation(Op::Eq, left, right); return true;
+        case TokenType::NotEqual: value = operation(Op::Ne, left, right); return true;
+        case TokenType::And: value = operation(Op::And, left, right); return true;
+        case TokenType::Or: value = operation(Op::Or, left, right); return true;
+        default: return false;
+        }
+    }
+    default:
+        return false;
+    }
+}
+
+// --- Optimization and code generation ---
+
+// Frame of a trace, below rbp: the values pointer, the iteration count,
+// a save slot for each xmm register around helper calls, 16 bytes for
+// each of xmm6-xmm15 (callee-saved on Windows), then spill slots.
+constexpr int32_t kValuesPointer = -8;
+constexpr int32_t kIterations = -16;
+constexpr int32_t saveSlot(int reg) { return -24 - 8 * reg; }
+#ifdef _WIN32
+constexpr int32_t calleeSaveSlot(int reg) { return -160 - 16 * (reg - 6); }
+#endif
+constexpr int32_t kFirstSpill = -312;
+
+// xmm0-xmm2 are scratch; the rest hold values.
+constexpr int kFirstRegister = 3;
+constexpr int kRegisters = 16 - kFirstRegister;
+constexpr int kTemporaryReserve = 4;  // registers kept for temporaries when they need them
+
+class Generator {
+public:
+    explicit Generator(const Recording& rec) : m_rec(rec), m_code(rec.code) {}
+
+    bool generate(Trace& trace);
+
+private:
+    struct Location {
+        enum Kind : uint8_t { None, Register, Stack, Constant } kind = None;
+        uint8_t reg = 0;
+        int32_t offset = 0;
+
+        bool operator==(const Location& other) const {
+            return kind == other.kind && (kind == Register ? reg == other.reg : offset == other.offset);
+        }
+    };
+
+    const Recording& m_rec;
+    const std::vector<Ins>& m_code;
+    A m_asm;
+    std::vector<char> m_live;
+    std::vector<char> m_invariant;
+    std::vector<char> m_fused;          // compares branched on by the next instruction
+    std::vector<uint32_t> m_preheader;  // run once before the loop
+    std::vector<uint32_t> m_body;       // run every iteration
+    std::vector<uint32_t> m_defined;    // body position of each value
+    std::vector<uint32_t> m_lastUse;    // last body position using it (end: the back edge)
+    std::vector<char> m_longLived;      // live through the whole loop
+    std::vector<Location> m_locations;
+    bool m_usedRegister[16] = {};
+    int m_spills = 0;
+    A::Label m_finish = 0;
+    std::vector<A::Label> m_sideExits;  // one per guard
+    std::vector<NodeIndex> m_exitBranches;
+
+    void optimize();
+    void fuse(const std::vector<uint32_t>& sequence, std::vector<uint32_t>& uses);
+    void allocate();
+    Location spill();
+
+    A::Xmm use(uint32_t value, A::Xmm scratch);
+    void load(A::Xmm target, uint32_t value);
+    void loadNumber(A::Xmm reg, double number);
+    void store(uint32_t value, A::Xmm source);
+    void emitSequence(const std::vector<uint32_t>& sequence, bool body);
+    void emitOperation(uint32_t value, uint32_t position, bool body);
+    void emitBranchUnless(uint32_t value, bool expect, A::Label target);
+    void callHelper(double (*helper)(double, double), uint32_t position, bool body);
+    void emitMoves(std::vector<std::pair<Location, Location>> moves);
+    void move(const Location& target, const Location& source);
+};
+
+// Dead code elimination, then loop-invariant code motion: what only
+// depends on constants and on slots the loop never assigns runs once.
+void Generator::optimize() {
+    size_t count = m_code.size();
+    m_live.assign(count, 0);
+    for (const Slot& slot : m_rec.slots) {
+        if (!slot.written) continue;
+        m_live[slot.input] = 1;
+        m_live[slot.value] = 1;
+    }
+    for (size_t i = count; i-- > 0;) {
+        if (!isPure(m_code[i].op)) m_live[i] = 1;
+        if (m_live[i]) forOperands(m_code[i], [&](uint32_t operand) { m_live[operand] = 1; });
+    }
+
+    m_invariant.assign(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const Ins& ins = m_code[i];
+        if (ins.op == Op::Const) {
+            m_invariant[i] = 1;
+        } else if (ins.op == Op::Input) {
+            m_invariant[i] = !m_rec.slots[ins.a].written;
+        } else {
+            bool invariant = true;
+            forOperands(ins, [&](uint32_t operand) { invariant = invariant && m_invariant[operand]; });
+            m_invariant[i] = invariant;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!m_live[i] || arity(m_code[i].op) == 0) continue;
+        (m_invariant[i] ? m_preheader : m_body).push_back(i);
+    }
+
+    std::vector<uint32_t> uses(count, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_live[i]) forOperands(m_code[i], [&](uint32_t operand) { ++uses[operand]; });
+    }
+    for (const Slot& slot : m_rec.slots) {
+        if (slot.written) ++uses[slot.value];
+    }
+    m_fused.assign(count, 0);
+    fuse(m_preheader, uses);
+    fuse(m_body, uses);
+}
+
+// A compare whose only use is the guard right after it sets the flags the
+// guard branches on, and is never turned into 1.0 or 0.0.
+void Generator::fuse(const std::vector<uint32_t>& sequence, std::vector<uint32_t>& uses) {
+    for (size_t i = 0; i + 1 < sequence.size(); ++i) {
+        uint32_t value = sequence[i];
+        const Ins& next = m_code[sequence[i + 1]];
+        if (isCompare(m_code[value].op) && !isPure(next.op) && next.a == value && uses[value] == 1) {
+            m_fused[value] = 1;
+        }
+    }
+}
+
+Generator::Location Generator::spill() {
+    Location location;
+    location.kind = Location::Stack;
+    location.offset = kFirstSpill - 8 * m_spills++;
+    return location;
+}
+
+// Values live through the whole loop get registers first, in order of how
+// much the loop uses them; then a linear scan over the body hands the rest
+// to temporaries. Whatever is left over lives in the frame, except
+// constants, which are loaded where they are used.
+void Generator::allocate() {
+    size_t count = m_code.size();
+    m_locations.assign(count, Location());
+    m_longLived.assign(count, 0);
+    m_defined.assign(count, kNone);
+    m_lastUse.assign(count, 0);
+    uint32_t end = static_cast<uint32_t>(m_body.size());
+
+    // How often the body uses each value; uses by the preheader keep a
+    // value live too
+    std::vector<uint32_t> bodyUses(count, 0);
+    std::vector<char> needed(count, 0);
+    auto noteUse = [&](uint32_t value, uint32_t position, bool body) {
+        needed[value] = 1;
+        if (!body) return;
+        ++bodyUses[value];
+        m_lastUse[value] = std::max(m_lastUse[value], position);
+    };
+    for (uint32_t i : m_preheader) {
+        forOperands(m_code[i], [&](uint32_t operand) { noteUse(operand, 0, false); });
+    }
+    for (uint32_t position = 0; position < end; ++position) {
+        uint32_t i = m_body[position];
+        m_defined[i] = position;
+        uint32_t at = m_fused[i] ? position + 1 : position;
+        forOperands(m_code[i], [&](uint32_t operand) { noteUse(operand, at, true); });
+    }
+    for (const Slot& slot : m_rec.slots) {
+        if (!slot.written) continue;
+        needed[slot.input] = 1;
+        noteUse(slot.value, end, true);
+    }
+
+    // Long-lived: inputs, constants and invariant values
+    std::vector<uint32_t> longLived;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!needed[i] || m_fused[i]) continue;
+        if (m_code[i].op == Op::Input || m_invariant[i]) {
+            m_longLived[i] = 1;
+            longLived.push_back(i);
+        }
+    }
+    std::stable_sort(longLived.begin(), longLived.end(),
+                     [&](uint32_t a, uint32_t b) { return bodyUses[a] > bodyUses[b]; });
+
+    // Most temporaries live at once
+    auto temporary = [&](uint32_t i) { return isPure(m_code[i].op) && !m_fused[i] && needed[i]; };
+    int pressure = 0, live = 0;
+    std::vector<int> dying(end + 1, 0);
+    for (uint32_t i : m_body) {
+        if (temporary(i)) ++dying[m_lastUse[i]];
+    }
+    for (uint32_t position = 0; position < end; ++position) {
+        live -= dying[position];
+        if (temporary(m_body[position])) ++live;
+        pressure = std::max(pressure, live);
+    }
+
+    int budget = kRegisters - std::min(pressure, kTemporaryReserve);
+    int next = kFirstRegister;
+    for (uint32_t i : longLived) {
+        Location& location = m_locations[i];
+        if (next < kFirstRegister + budget && (bodyUses[i] > 0 || m_code[i].op == Op::Input)) {
+            location.kind = Location::Register;
+            location.reg = static_cast<uint8_t>(next++);
+        } else if (m_code[i].op == Op::Const) {
+            location.kind = Location::Constant;
+        } else {
+            location = spill();
+        }
+    }
+
+    std::vector<int> free;
+    std::vector<char> released(count, 0);
+    for (int reg = 15; reg >= next; --reg) free.push_back(reg);
+    for (uint32_t position = 0; position < end; ++position) {
+        uint32_t i = m_body[position];
+        const Ins& ins = m_code[i];
+        // Operands whose last use this is give their registers to the result
+        auto release = [&](uint32_t value) {
+            const Location& location = m_locations[value];
+            if (m_longLived[value] || released[value] || location.kind != Location::Register) return;
+            if (m_lastUse[value] != position) return;
+            released[value] = 1;
+            free.push_back(location.reg);
+        };
+        forOperands(ins, release);
+        // A fused compare's operands die at the guard after it
+        if (!isPure(ins.op) && position > 0 && m_fused[m_body[position - 1]]) {
+            forOperands(m_code[m_body[position - 1]], release);
+        }
+        if (!temporary(i)) continue;
+        if (!free.empty()) {
+            m_locations[i].kind = Location::Register;
+            m_locations[i].reg = static_cast<uint8_t>(free.back());
+            free.pop_back();
+        } else {
+            m_locations[i] = spill();
+        }
+    }
+    for (const Location& location : m_locations) {
+        if (location.kind == Location::Register) m_usedRegister[location.reg] = true;
+    }
+}
+
+void Generator::loadNumber(A::Xmm reg, double number) {
+    if (bitsOf(number) == 0) {
+        m_asm.xorpd(reg, reg);
+        return;
+    }
+    m_asm.movImm64(A::RAX, bitsOf(number));
+    m_asm.movqFromReg(reg, A::RAX);
+}
+
+// The register holding a value, loading it into scratch if it has none.
+A::Xmm Generator::use(uint32_t value, A::Xmm scratch) {
+    const Location& location = m_locations[value];
+    switch (location.kind) {
+    case Location::Register: return static_cast<A::Xmm>(location.reg);
+    case Location::Stack: m_asm.movsdLoad(scratch, A::RBP, location.offset); return scratch;
+    default: loadNumber(scratch, m_code[value].number); return scratch;
+    }
+}
+
+void Generator::load(A::Xmm target, uint32_t value) {
+    A::Xmm reg = use(value, target);
+    if (reg != target) m_asm.movapd(target, reg);
+}
+
+void Generator::store(uint32_t value, A::Xmm source) {
+    const Location& location = m_locations[value];
+    if (location.kind == Location::Register) m_asm.movapd(static_cast<A::Xmm>(location.reg), source);
+    else m_asm.movsdStore(A::RBP, location.offset, source);
+}
+
+void Generator::emitSequence(const std::vector<uint32_t>& sequence, bool body) {
+    for (uint32_t position = 0; position < sequence.size(); ++position) {
+        uint32_t i = sequence[position];
+        const Ins& ins = m_code[i];
+        if (ins.op == Op::Exit) {
+            emitBranchUnless(ins.a, ins.expect, m_finish);
+        } else if (ins.op == Op::Guard) {
+            m_sideExits.push_back(m_asm.newLabel());
+            m_exitBranches.push_back(ins.branch);
+            emitBranchUnless(ins.a, ins.expect, m_sideExits.back());
+        } else if (!m_fused[i]) {
+            emitOperation(i, position, body);
+        }
+    }
+}
+
+// Computes a value in xmm0, then moves it where it lives.
+void Generator::emitOperation(uint32_t value, uint32_t position, bool body) {
+    const Ins& ins = m_code[value];
+    load(A::XMM0, ins.a);
+    if (ins.op == Op::Select) {
+        // A mask of the predicate's truthiness picks b or c, without a branch
+        m_asm.xorpd(A::XMM2, A::XMM2);
+        m_asm.cmpsd(A::XMM0, A::XMM2, A::CmpNotEqual);
+        load(A::XMM1, ins.b);
+        m_asm.andpd(A::XMM1, A::XMM0);
+        m_asm.andnpd(A::XMM0, use(ins.c, A::XMM2));
+        m_asm.orpd(A::XMM0, A::XMM1);
+        store(value, A::XMM0);
+        return;
+    }
+    A::Xmm right = arity(ins.op) == 1 ? A::XMM1 : use(ins.b, A::XMM1);
+    switch (ins.op) {
+    case Op::Add: m_asm.addsd(A::XMM0, right); break;
+    case Op::Sub: m_asm.subsd(A::XMM0, right); break;
+    case Op::Mul: m_asm.mulsd(A::XMM0, right); break;
+    case Op::Div: m_asm.divsd(A::XMM0, right); break;
+    case Op::Mod:
+    case Op::Pow:
+        if (right != A::XMM1) m_asm.movapd(A::XMM1, right);
+        callHelper(ins.op == Op::Mod ? &traceFmod : &tracePow, position, body);
+        break;
+    case Op::Lt:
+    case Op::Le:
+    case Op::Eq:
+    case Op::Ne: {
+        A::Compare predicate = ins.op == Op::Lt ? A::CmpLess : ins.op == Op::Le ? A::CmpLessEqual
+                             : ins.op == Op::Eq ? A::CmpEqual : A::CmpNotEqual;
+        m_asm.cmpsd(A::XMM0, right, predicate);
+        loadNumber(A::XMM2, 1.0);
+        m_asm.andpd(A::XMM0, A::XMM2);
+        break;
+    }
+    case Op::And:
+    case Op::Or:
+        if (right != A::XMM1) m_asm.movapd(A::XMM1, right);
+        m_asm.xorpd(A::XMM2, A::XMM2);
+        m_asm.cmpsd(A::XMM0, A::XMM2, A::CmpNotEqual);
+        m_asm.cmpsd(A::XMM1, A::XMM2, A::CmpNotEqual);
+        if (ins.op == Op::And) m_asm.andpd(A::XMM0, A::XMM1);
+        else m_asm.orpd(A::XMM0, A::XMM1);
+        loadNumber(A::XMM2, 1.0);
+        m_asm.andpd(A::XMM0, A::XMM2);
+        break;
+    case Op::Neg:
+        loadNumber(A::XMM2, -0.0);
+        m_asm.xorpd(A::XMM0, A::XMM2);
+        break;
+    case Op::Not:
+        m_asm.xorpd(A::XMM2, A::XMM2);
+        m_asm.cmpsd(A::XMM0, A::XMM2, A::CmpEqual);
+        loadNumber(A::XMM2, 1.0);
+        m_asm.andpd(A::XMM0, A::XMM2);
+        break;
+    default:
+        break;
+    }
+    store(value, A::XMM0);
+}
+
+// Jumps to target unless the value's truthiness is expect. A fused compare
+// branches on the ucomisd flags of its operands; anything else is
+// compared with zero (truthy is != 0, which holds for NaN).
+void Generator::emitBranchUnless(uint32_t value, bool expect, A::Label target) {
+    const Ins& ins = m_code[value];
+    Op op = m_fused[value] ? ins.op : Op::Ne;
+    A::Xmm left, right;
+    if (m_fused[value]) {
+        left = use(ins.a, A::XMM0);
+        right = use(ins.b, A::XMM1);
+    } else {
+        left = use(value, A::XMM0);
+        right = A::XMM1;
+        m_asm.xorpd(A::XMM1, A::XMM1);
+    }
+    switch (op) {
+    case Op::Lt:  // a < b: above, comparing b with a
+        m_asm.ucomisd(right, left);
+        m_asm.jcc(expect ? A::BelowEqual : A::Above, target);
+        return;
+    case Op::Le:
+        m_asm.ucomisd(right, left);
+        m_asm.jcc(expect ? A::Below : A::AboveEqual, target);
+        return;
+    default:
+        break;
+    }
+    // Equal and ordered, or not
+    m_asm.ucomisd(left, right);
+    bool jumpWhenEqual = (op == Op::Eq) != expect;
+    if (jumpWhenEqual) {
+        A::Label skip = m_asm.newLabel();
+        m_asm.jcc(A::Parity, skip);
+        m_asm.jcc(A::Equal, target);
+        m_asm.bind(skip);
+    } else {
+        m_asm.jcc(A::NotEqual, target);
+        m_asm.jcc(A::Parity, target);
+    }
+}
+
+// Calls a C function of (xmm0, xmm1), which may clobber every xmm
+// register: the ones holding values still needed are saved around it. The
+// stack stays 16-byte aligned, with 32 bytes of shadow space for Windows.
+void Generator::callHelper(double (*helper)(double, double), uint32_t position, bool body) {
+    std::vector<uint8_t> saved;
+    for (uint32_t i = 0; i < m_code.size(); ++i) {
+        const Location& location = m_locations[i];
+        if (location.kind != Location::Register) continue;
+        bool across = m_longLived[i] ||
+                      (body && m_defined[i] != kNone && m_defined[i] < position && m_lastUse[i] > position);
+        if (across) saved.push_back(location.reg);
+    }
+    for (uint8_t reg : saved) m_asm.movsdStore(A::RBP, saveSlot(reg), static_cast<A::Xmm>(reg));
+    m_asm.subRsp(32);
+    m_asm.movImm64(A::RAX, reinterpret_cast<uint64_t>(helper));
+    m_asm.callReg(A::RAX);
+    m_asm.addRsp(32);
+    for (uint8_t reg : saved) m_asm.movsdLoad(static_cast<A::Xmm>(reg), A::RBP, saveSlot(reg));
+}
+
+void Generator::move(const Location& target, const Location& source) {
+    if (source.kind == Location::Register) {
+        auto from = static_cast<A::Xmm>(source.reg);
+        if (target.kind == Location::Register) m_asm.movapd(static_cast<A::Xmm>(target.reg), from);
+        else m_asm.movsdStore(A::RBP, target.offset, from);
+        return;
+    }
+    if (target.kind == Location::Register) {
+        m_asm.movsdLoad(static_cast<A::Xmm>(target.reg), A::RBP, source.offset);
+        return;
+    }
+    m_asm.movsdLoad(A::XMM1, A::RBP, source.offset);
+    m_asm.movsdStore(A::RBP, target.offset, A::XMM1);
+}
+
+// Moves all sources to their targets at once, as if in parallel. A move is
+// made once nothing still pending reads its target; a cycle is broken by
+// parking one source in xmm0.
+void Generator::emitMoves(std::vector<std::pair<Location, Location>> moves) {
+    moves.erase(std::remove_if(moves.begin(), moves.end(),
+                               [](const auto& m) { return m.first == m.second; }),
+                moves.end());
+    while (!moves.empty()) {
+        bool progress = false;
+        for (size_t k = 0; k < moves.size(); ++k) {
+            bool blocked = false;
+            for (size_t j = 0; j < moves.size() && !blocked; ++j) {
+                blocked = j != k && moves[j].second == moves[k].first;
+            }
+            if (blocked) continue;
+            move(moves[k].first, moves[k].second);
+            moves.erase(moves.begin() + static_cast<std::ptrdiff_t>(k));
+            progress = true;
+            break;
+        }
+        if (progress) continue;
+        Location parked;
+        parked.kind = Location::Register;
+        parked.reg = A::XMM0;
+        Location source = moves[0].second;
+        move(parked, source);
+        for (auto& m : moves) {
+            if (m.second == source) m.second = parked;
+        }
+    }
+}
+
+// C entry, int (double* values). The inputs are loaded, the preheader
+// runs, then the body loops; every exit writes the slots the loop assigns
+// back from their loop-head values, with the iteration count.
+bool Generator::generate(Trace& trace) {
+    optimize();
+    allocate();
+    m_finish = m_asm.newLabel();
+    A::Label head = m_asm.newLabel();
+    A::Label done = m_asm.newLabel();
+    uint32_t slots = static_cast<uint32_t>(m_rec.slots.size());
+
+    m_asm.push(A::RBP);
+    m_asm.movRegReg(A::RBP, A::RSP);
+    m_asm.subRsp((-kFirstSpill + 8 * m_spills + 15) / 16 * 16);
+#ifdef _WIN32
+    const A::Reg values = A::RCX;
+    for (int reg = 6; reg < 16; ++reg) {
+        if (!m_usedRegister[reg]) continue;
+        m_asm.movupdStore(A::RBP, calleeSaveSlot(reg), static_cast<A::Xmm>(reg));
+    }
+#else
+    const A::Reg values = A::RDI;
+#endif
+    m_asm.movStore(A::RBP, kValuesPointer, values);
+    m_asm.xorEax();
+    m_asm.movStore(A::RBP, kIterations, A::RAX);
+    for (uint32_t i = 0; i < m_code.size(); ++i) {
+        const Location& location = m_locations[i];
+        if (m_code[i].op == Op::Input && location.kind == Location::Register) {
+            m_asm.movsdLoad(static_cast<A::Xmm>(location.reg), values, 8 * static_cast<int32_t>(m_code[i].a));
+        } else if (m_code[i].op == Op::Input && location.kind == Location::Stack) {
+            m_asm.movsdLoad(A::XMM0, values, 8 * static_cast<int32_t>(m_code[i].a));
+            m_asm.movsdStore(A::RBP, location.offset, A::XMM0);
+        } else if (m_code[i].op == Op::Const && location.kind == Location::Register) {
+            loadNumber(static_cast<A::Xmm>(location.reg), m_code[i].number);
+        }
+    }
+    emitSequence(m_preheader, false);
+
+    m_asm.bind(head);
+    emitSequence(m_body, true);
+    m_asm.incMem(A::RBP, kIterations);
+    std::vector<std::pair<Location, Location>> moves;
+    std::vector<std::pair<Location, double>> constants;
+    for (const Slot& slot : m_rec.slots) {
+        if (!slot.written) continue;
+        const Location& source = m_locations[slot.value];
+        if (source.kind == Location::Constant) constants.emplace_back(m_locations[slot.input], m_code[slot.value].number);
+        else moves.emplace_back(m_locations[slot.input], source);
+    }
+    emitMoves(moves);
+    for (const auto& [target, number] : constants) {
+        if (target.kind == Location::Register) {
+            loadNumber(static_cast<A::Xmm>(target.reg), number);
+        } else {
+            loadNumber(A::XMM1, number);
+            m_asm.movsdStore(A::RBP, target.offset, A::XMM1);
+        }
+    }
+    m_asm.jmp(head);
+
+    m_asm.bind(m_finish);
+    m_asm.xorEax();
+    m_asm.jmp(done);
+    for (size_t k = 0; k < m_sideExits.size(); ++k) {
+        m_asm.bind(m_sideExits[k]);
+        m_asm.movEax(static_cast<uint32_t>(k + 1));
+        m_asm.jmp(done);
+    }
+    m_asm.bind(done);
+    m_asm.movLoad(A::RCX, A::RBP, kValuesPointer);
+    for (uint32_t s = 0; s < slots; ++s) {
+        const Slot& slot = m_rec.slots[s];
+        if (!slot.written) continue;
+        A::Xmm reg = use(slot.input, A::XMM0);
+        m_asm.movsdStore(A::RCX, 8 * static_cast<int32_t>(s), reg);
+    }
+    m_asm.movLoad(A::RDX, A::RBP, kIterations);
+    m_asm.movStore(A::RCX, 8 * static_cast<int32_t>(slots), A::RDX);
+#ifdef _WIN32
+    for (int reg = 6; reg < 16; ++reg) {
+        if (!m_usedRegister[reg]) continue;
+        m_asm.movupdLoad(static_cast<A::Xmm>(reg), A::RBP, calleeSaveSlot(reg));
+    }
+#endif
+    m_asm.leave();
+    m_asm.ret();
+    m_asm.finish();
+
+    if (!trace.code.assign(m_asm.code())) return false;
+    trace.entry = reinterpret_cast<Trace::Entry>(trace.code.data());
+    trace.variables = m_rec.variables;
+    trace.counted = m_rec.counted;
+    trace.ascending = m_rec.ascending;
+    trace.exits = m_exitBranches;
+    trace.exitCounts.assign(m_exitBranches.size(), 0);
+    return true;
+}
+
+} // namespace
+
+static std::unique_ptr<Trace> recordTrace(const Ast& ast, const Stmt& loop, Environment& globals,
+                                          Environment& frame, const RangeCounter* counter,
+                                          const std::vector<NodeIndex>& merged) {
+    Recording recording;
+    if (!Recorder(ast, globals, frame, merged).record(loop, counter, recording)) return nullptr;
+    auto trace = std::make_unique<Trace>();
+    if (!Generator(recording).generate(*trace)) return nullptr;
+    return trace;
+}
+
+#else
+
+static std::unique_ptr<Trace> recordTrace(const Ast&, const Stmt&, Environment&, Environment&,
+                                          const RangeCounter*, const std::vector<NodeIndex>&) {
+    return nullptr;
+}
+
+#endif // JIT_X86_64
+
+bool Tracer::available() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Whether a loop body may be traced at all: it must not hold a loop of its
+// own (that one gets traced instead) or define a function.
+static bool traceable(const Ast& ast, NodeList statements) {
+    for (NodeIndex index : ast.statementList(statements)) {
+        const Stmt& stmt = ast.stmt(index);
+        switch (stmt.kind) {
+        case StmtKind::While:
+        case StmtKind::For:
+        case StmtKind::FunctionDef:
+            return false;
+        case StmtKind::If:
+            if (!traceable(ast, stmt.body) || !traceable(ast, stmt.orelse)) return false;
+            break;
+        case StmtKind::Block:
+            if (!traceable(ast, stmt.body)) return false;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+void Tracer::attach(Ast& ast) {
+    for (Stmt& stmt : ast.statements) {
+        if (stmt.kind != StmtKind::While && stmt.kind != StmtKind::For) continue;
+        if (stmt.jit || !traceable(ast, stmt.body)) continue;
+        m_loops.push_back(std::make_unique<TraceLoop>(ast, stmt));
+        stmt.trace = m_loops.back().get();
+    }
+}
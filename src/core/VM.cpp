@@ -0,0 +1,447 @@
+#include <stdexcept>
+#include "core/VM.h"
+#include "core/Builtins.h"
+#include "core/Jit.h"
+#include "core/Tracer.h"
+#include "core/Operations.h"
+#include "objects/ListObject.h"
+#include "objects/IteratorObject.h"
+#include "objects/RangeObject.h"
+#include "objects/FunctionObject.h"
+#include "objects/ObjectPool.h"
+
+// GCC and Clang support taking the address of a label, which lets every
+// instruction jump straight to the handler of the next one instead of going
+// back through a single switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_USE_COMPUTED_GOTO 1
+#else
+#define VM_USE_COMPUTED_GOTO 0
+#endif
+
+static inline uint32_t readOperand(const uint8_t* at) {
+    uint32_t operand;
+    std::memcpy(&operand, at, sizeof(uint32_t));
+    return operand;
+}
+
+VM::VM() {
+    m_global_env = makePooled<Environment>();
+    registerBuiltins(*m_global_env);
+}
+
+void VM::run(const Program& program) {
+    m_program = &program;
+    m_stack.clear();
+    m_frames.clear();
+    m_memoCalls.clear();
+    m_frames.push_back({&program.main, program.main.code.data(), 0, m_global_env, false});
+    execute();
+}
+
+// Calls a builtin with the arguments above calleeSlot and leaves its result
+// in place of the callee.
+void VM::callBuiltin(const FunctionObject& func, size_t calleeSlot) {
+    std::vector<Value> arguments(std::make_move_iterator(m_stack.begin() + calleeSlot + 1),
+                                 std::make_move_iterator(m_stack.end()));
+    Value result = func.get_builtin()(arguments);
+    m_stack.resize(calleeSlot);
+    m_stack.push_back(std::move(result));
+}
+
+// Replaces the callee and its arguments with a cached result and returns
+// true, or returns false after noting the call whose frame is about to be
+// pushed, for Return to record its result. A tail call in that frame
+// returns the same result, so the note stays with the frame.
+bool VM::lookupMemo(const FunctionObject& func, size_t calleeSlot) {
+    std::string key;
+    if (!MemoTable::makeKey(&m_stack[calleeSlot + 1], m_stack.size() - calleeSlot - 1, key)) return false;
+    if (const Value* cached = func.get_memo()->find(key)) {
+        Value result = *cached;
+        m_stack.resize(calleeSlot);
+        m_stack.push_back(std::move(result));
+        return true;
+    }
+    m_memoCalls.push_back({m_frames.size(), func.get_memo_table(), std::move(key)});
+    return false;
+}
+
+// Runs a user function's native code on the arguments above calleeSlot and
+// replaces them and the callee with the result, recording it for a memoized
+// call noted by lookupMemo. Returns false, with nothing changed, if the
+// native code declined.
+bool VM::callNative(const FunctionObject& func, size_t calleeSlot) {
+    Value result;
+    if (!func.get_decl().jit->call(*m_global_env, &m_stack[calleeSlot + 1], m_stack.size() - calleeSlot - 1, result)) {
+        return false;
+    }
+    if (!m_memoCalls.empty() && m_memoCalls.back().frame == m_frames.size()) {
+        m_memoCalls.back().table->store(m_memoCalls.back().key, result);
+        m_memoCalls.pop_back();
+    }
+    m_stack.resize(calleeSlot);
+    m_stack.push_back(std::move(result));
+    return true;
+}
+
+void VM::execute() {
+    CallFrame* frame = &m_frames.back();
+    const Chunk* chunk = frame->chunk;
+    const uint8_t* code = chunk->code.data();
+    const uint8_t* ip = frame->ip;
+    Environment* env = frame->env.get();
+
+#define VM_OPERAND() (ip += sizeof(uint32_t), readOperand(ip - sizeof(uint32_t)))
+#define VM_POP() (m_stack.pop_back())
+
+#if VM_USE_COMPUTED_GOTO
+    // Must list the handlers in OpCode declaration order.
+    static void* const dispatchTable[] = {
+        &&op_Constant, &&op_LoadGlobal, &&op_StoreGlobal, &&op_LoadLocal, &&op_StoreLocal,
+        &&op_LoadEnclosing, &&op_UpdateName, &&op_Pop,
+        &&op_Add, &&op_Subtract, &&op_Multiply, &&op_Divide, &&op_Modulo, &&op_Power,
+        &&op_Equal, &&op_NotEqual, &&op_Less, &&op_Greater, &&op_LessEqual,
+        &&op_GreaterEqual, &&op_And, &&op_Or,
+        &&op_Negate, &&op_Not,
+        &&op_Jump, &&op_JumpIfFalse, &&op_GetIter, &&op_ForIter, &&op_BuildList,
+        &&op_Index, &&op_IndexRow, &&op_IndexElement, &&op_Member, &&op_Call, &&op_TailCall, &&op_MakeFunction, &&op_NativeLoop,
+        &&op_TraceLoop, &&op_Return, &&op_Halt,
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) ==
+                  static_cast<size_t>(OpCode::Halt) + 1, "dispatch table out of sync with OpCode");
+#define VM_CASE(name) op_##name
+#define VM_DISPATCH() goto *dispatchTable[*ip++]
+    VM_DISPATCH();
+#else
+#define VM_CASE(name) case OpCode::name
+#define VM_DISPATCH() continue
+    for (;;) {
+        switch (static_cast<OpCode>(*ip++)) {
+#endif
+
+    VM_CASE(Constant): {
+        m_stack.push_back(chunk->constants[VM_OPERAND()]);
+        VM_DISPATCH();
+    }
+    VM_CASE(LoadGlobal): {
+        uint32_t name = VM_OPERAND();
+        m_stack.push_back(chunk->globalCaches[name].read(*m_global_env, chunk->names[name]));
+        VM_DISPATCH();
+    }
+    VM_CASE(StoreGlobal): {
+        uint32_t name = VM_OPERAND();
+        chunk->globalStores[name].store(*m_global_env, chunk->names[name], std::move(m_stack.back()));
+        VM_POP();
+        VM_DISPATCH();
+    }
+    VM_CASE(LoadLocal): {
+        int slot = static_cast<int>(VM_OPERAND());
+        const Value& value = env->slot(slot);
+        // A local read before its first assignment resolves dynamically outward
+        m_stack.push_back(value.is_undefined() ? env->enclosing()->get(env->slotName(slot)) : value);
+        VM_DISPATCH();
+    }
+    VM_CASE(StoreLocal): {
+        env->slot(static_cast<int>(VM_OPERAND())) = std::move(m_stack.back());
+        VM_POP();
+        VM_DISPATCH();
+    }
+    VM_CASE(LoadEnclosing): {
+        uint32_t operand = VM_OPERAND();
+        Environment* scope = env->ancestor(static_cast<int>(operand >> 24));
+        int slot = static_cast<int>(operand & 0xFFFFFF);
+        const Value& value = scope->slot(slot);
+        m_stack.push_back(value.is_undefined() ? scope->enclosing()->get(scope->slotName(slot)) : value);
+        VM_DISPATCH();
+    }
+    VM_CASE(UpdateName): {
+        env->update(chunk->names[VM_OPERAND()], m_stack.back());
+        VM_DISPATCH();
+    }
+    VM_CASE(Pop): {
+        VM_POP();
+        VM_DISPATCH();
+    }
+
+// Numbers are computed inline; everything else goes through the shared
+// runtime so that error messages match the tree walker.
+#define VM_BINARY(name, op)                                                     \
+    VM_CASE(name): {                                                            \
+        Value right = std::move(m_stack.back());                                \
+        VM_POP();                                                               \
+        Value& left = m_stack.back();                                           \
+        if (left.is_number() && right.is_number()) {                            \
+            left = NumberKernel<op>::apply(left.as_number(), right.as_number()); \
+        } else {                                                                \
+            left = evaluateBinaryOperation(left, right, op);                    \
+        }                                                                       \
+        VM_DISPATCH();                                                          \
+    }
+
+    VM_BINARY(Add, TokenType::Plus)
+    VM_BINARY(Subtract, TokenType::Minus)
+    VM_BINARY(Multiply, TokenType::Star)
+    VM_BINARY(Divide, TokenType::Slash)
+    VM_BINARY(Modulo, TokenType::Percent)
+    VM_BINARY(Power, TokenType::Power)
+    VM_BINARY(Equal, TokenType::Equal)
+    VM_BINARY(NotEqual, TokenType::NotEqual)
+    VM_BINARY(Less, TokenType::Less)
+    VM_BINARY(Greater, TokenType::Greater)
+    VM_BINARY(LessEqual, TokenType::LessEqual)
+    VM_BINARY(GreaterEqual, TokenType::GreaterEqual)
+    VM_BINARY(And, TokenType::And)
+    VM_BINARY(Or, TokenType::Or)
+#undef VM_BINARY
+
+    VM_CASE(Negate): {
+        Value& operand = m_stack.back();
+        if (operand.is_number()) operand = -operand.as_number();
+        else operand = evaluateUnaryOperation(operand, TokenType::Minus);
+        VM_DISPATCH();
+    }
+    VM_CASE(Not): {
+        Value& operand = m_stack.back();
+        operand = Value::boolean(!isTruthy(operand));
+        VM_DISPATCH();
+    }
+    VM_CASE(Jump): {
+        ip = code + readOperand(ip);
+        VM_DISPATCH();
+    }
+    VM_CASE(JumpIfFalse): {
+        uint32_t target = VM_OPERAND();
+        bool truthy = isTruthy(m_stack.back());
+        VM_POP();
+        if (!truthy) ip = code + target;
+        VM_DISPATCH();
+    }
+    VM_CASE(GetIter): {
+        // The iterable stays on the stack below its iterator: list and
+        // string iterators only reference the underlying storage. A range
+        // is counted in place instead: the range goes on top and the slot
+        // below holds the next value, a number where an iterable never is.
+        if (auto range = m_stack.back().as<RangeObject>()) {
+            Value rangeValue = std::move(m_stack.back());
+            m_stack.back() = range->start;
+            m_stack.push_back(std::move(rangeValue));
+        } else {
+            Value iterator = makeIterator(m_stack.back());
+            m_stack.push_back(std::move(iterator));
+        }
+        VM_DISPATCH();
+    }
+    VM_CASE(ForIter): {
+        uint32_t target = VM_OPERAND();
+        Value& state = m_stack[m_stack.size() - 2];
+        if (state.is_number()) {
+            auto* range = static_cast<RangeObject*>(m_stack.back().as_object().get());
+            RangeCounter counter(state.as_number(), range->stop, range->step);
+            if (counter.has_next()) {
+                double value = counter.next();
+                state = counter.current;
+                m_stack.push_back(value);
+            } else {
+                VM_POP();
+                VM_POP();
+                ip = code + target;
+            }
+            VM_DISPATCH();
+        }
+        auto* iterator = static_cast<IteratorObject*>(m_stack.back().as_object().get());
+        if (iterator->has_next()) {
+            m_stack.push_back(iterator->next());
+        } else {
+            VM_POP();
+            VM_POP();
+            ip = code + target;
+        }
+        VM_DISPATCH();
+    }
+    VM_CASE(BuildList): {
+        uint32_t count = VM_OPERAND();
+        std::vector<Value> items(std::make_move_iterator(m_stack.end() - count),
+                                 std::make_move_iterator(m_stack.end()));
+        m_stack.resize(m_stack.size() - count);
+        m_stack.push_back(makePooled<ListObject>(std::move(items)));
+        VM_DISPATCH();
+    }
+    VM_CASE(Index): {
+        Value index = std::move(m_stack.back());
+        VM_POP();
+        Value& collection = m_stack.back();
+        collection = evaluateIndex(collection, index);
+        VM_DISPATCH();
+    }
+    VM_CASE(IndexRow): {
+        Value& index = m_stack.back();
+        Value& collection = m_stack[m_stack.size() - 2];
+        size_t row;
+        if (matrixRow(collection, index, row)) {
+            index = static_cast<double>(row);
+        } else {
+            collection = evaluateIndex(collection, index);
+            index = Value::undefined();
+        }
+        VM_DISPATCH();
+    }
+    VM_CASE(IndexElement): {
+        Value index = std::move(m_stack.back());
+        VM_POP();
+        Value row = std::move(m_stack.back());
+        VM_POP();
+        Value& collection = m_stack.back();
+        if (row.is_undefined()) {
+            collection = evaluateIndex(collection, index);
+        } else {
+            auto matrix = static_cast<const ArrayObject*>(collection.as_object().get());
+            collection = matrixElement(*matrix, static_cast<size_t>(row.as_number()), index);
+        }
+        VM_DISPATCH();
+    }
+    VM_CASE(Member): {
+        Value& object = m_stack.back();
+        object = evaluateMemberAccess(object, chunk->names[VM_OPERAND()].text());
+        VM_DISPATCH();
+    }
+    VM_CASE(Call): {
+        CallSite& site = chunk->callSites[VM_OPERAND()];
+        uint32_t argc = site.argc;
+        size_t calleeSlot = m_stack.size() - argc - 1;
+        FunctionObject* func = site.cache.resolve(m_stack[calleeSlot]);
+        if (!func) throw std::runtime_error("Can only call functions");
+
+        if (func->get_type() == FunctionObject::FunctionType::BUILTIN) {
+            callBuiltin(*func, calleeSlot);
+            VM_DISPATCH();
+        }
+
+        const auto& parameters = func->get_parameters();
+        if (argc != parameters.size()) {
+            throw std::runtime_error("Function expects " + std::to_string(parameters.size()) +
+                                   " arguments, got " + std::to_string(argc));
+        }
+        const FunctionProto* proto = func->get_proto();
+        if (!proto) throw std::runtime_error("Function has no bytecode");
+        if (func->get_memo() && lookupMemo(*func, calleeSlot)) VM_DISPATCH();
+        if (func->get_decl().jit && callNative(*func, calleeSlot)) VM_DISPATCH();
+
+        // Bind parameters to the first slots of a fresh frame chained to the closure
+        std::shared_ptr<Environment> function_env;
+        bool onStack = false;
+        m_frameStack.enter(*func, function_env, onStack);
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            function_env->slot(static_cast<int>(i)) = std::move(m_stack[calleeSlot + 1 + i]);
+        }
+        m_stack.resize(calleeSlot);
+
+        frame->ip = ip;
+        m_frames.push_back({&proto->chunk, proto->chunk.code.data(), calleeSlot, std::move(function_env), onStack});
+        frame = &m_frames.back();
+        chunk = frame->chunk;
+        code = chunk->code.data();
+        ip = frame->ip;
+        env = frame->env.get();
+        VM_DISPATCH();
+    }
+    VM_CASE(TailCall): {
+        CallSite& site = chunk->callSites[VM_OPERAND()];
+        uint32_t argc = site.argc;
+        size_t calleeSlot = m_stack.size() - argc - 1;
+        FunctionObject* func = site.cache.resolve(m_stack[calleeSlot]);
+        if (!func) throw std::runtime_error("Can only call functions");
+
+        // The Return after this instruction hands a builtin's result back
+        if (func->get_type() == FunctionObject::FunctionType::BUILTIN) {
+            callBuiltin(*func, calleeSlot);
+            VM_DISPATCH();
+        }
+
+        const auto& parameters = func->get_parameters();
+        if (argc != parameters.size()) {
+            throw std::runtime_error("Function expects " + std::to_string(parameters.size()) +
+                                   " arguments, got " + std::to_string(argc));
+        }
+        const FunctionProto* proto = func->get_proto();
+        if (!proto) throw std::runtime_error("Function has no bytecode");
+        // Its result goes to the Return after this instruction
+        if (func->get_decl().jit && callNative(*func, calleeSlot)) VM_DISPATCH();
+
+        // The callee takes over the current frame, and its environment too
+        // unless a closure captured it
+        m_frameStack.enter(*func, frame->env, frame->onStack);
+        env = frame->env.get();
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            env->slot(static_cast<int>(i)) = std::move(m_stack[calleeSlot + 1 + i]);
+        }
+        m_stack.resize(frame->stackBase);
+
+        frame->chunk = &proto->chunk;
+        chunk = frame->chunk;
+        code = chunk->code.data();
+        ip = code;
+        VM_DISPATCH();
+    }
+    VM_CASE(MakeFunction): {
+        const FunctionProto* proto = m_program->functions[VM_OPERAND()].get();
+        m_stack.push_back(makePooled<FunctionObject>(*proto->definition, frame->env, proto));
+        VM_DISPATCH();
+    }
+    VM_CASE(NativeLoop): {
+        const NativeLoopSite& site = chunk->nativeLoops[VM_OPERAND()];
+        if (site.loop->run(*m_global_env)) ip = code + site.exit;
+        VM_DISPATCH();
+    }
+    VM_CASE(TraceLoop): {
+        const TraceLoopSite& site = chunk->traceLoops[VM_OPERAND()];
+        if (!site.isFor) {
+            if (site.loop->tick() && site.loop->run(*m_global_env, *env, nullptr)) ip = code + site.exit;
+            VM_DISPATCH();
+        }
+        // Only a range loop, whose state is its next value, is traced
+        Value& state = m_stack[m_stack.size() - 2];
+        if (state.is_number() && site.loop->tick()) {
+            auto* range = static_cast<RangeObject*>(m_stack.back().as_object().get());
+            RangeCounter counter(state.as_number(), range->stop, range->step);
+            bool finished = site.loop->run(*m_global_env, *env, &counter);
+            state = counter.current;
+            if (finished) {
+                VM_POP();
+                VM_POP();
+                ip = code + site.exit;
+            }
+        }
+        VM_DISPATCH();
+    }
+    VM_CASE(Return): {
+        Value result = std::move(m_stack.back());
+        m_stack.resize(frame->stackBase);
+        if (frame->onStack) m_frameStack.leave();
+        if (!m_memoCalls.empty() && m_memoCalls.back().frame == m_frames.size() - 1) {
+            m_memoCalls.back().table->store(m_memoCalls.back().key, result);
+            m_memoCalls.pop_back();
+        }
+        m_frames.pop_back();
+        frame = &m_frames.back();
+        chunk = frame->chunk;
+        code = chunk->code.data();
+        ip = frame->ip;
+        env = frame->env.get();
+        m_stack.push_back(std::move(result));
+        VM_DISPATCH();
+    }
+    VM_CASE(Halt): {
+        frame->ip = ip;
+        return;
+    }
+
+#if !VM_USE_COMPUTED_GOTO
+        }
+    }
+#endif
+
+#undef VM_CASE
+#undef VM_DISPATCH
+#undef VM_POP
+#undef VM_OPERAND
+}
@@ -0,0 +1,71 @@
+#include "objects/ArrayObject.h"
+#include <utility>
+#include "objects/ObjectPool.h"
+
+ArrayObject::ArrayObject(std::shared_ptr<const Buffer> buffer, size_t rows, size_t cols)
+    : m_buffer(std::move(buffer)), m_dims(2), m_shape{rows, cols},
+      m_strides{static_cast<std::ptrdiff_t>(cols), 1} {
+    m_data = m_buffer->data();
+}
+
+ArrayObject::ArrayObject(std::shared_ptr<const Buffer> buffer)
+    : m_buffer(std::move(buffer)), m_dims(1), m_shape{m_buffer->size(), 1}, m_strides{1, 1} {
+    m_data = m_buffer->data();
+}
+
+ArrayObject::ArrayObject(std::shared_ptr<const Buffer> buffer, const double* data, int dims, const size_t shape[2],
+                         const std::ptrdiff_t strides[2])
+    : m_buffer(std::move(buffer)), m_data(data), m_dims(dims), m_shape{shape[0], shape[1]},
+      m_strides{strides[0], strides[1]} {}
+
+std::string ArrayObject::type_name() const {
+    return "array";
+}
+
+std::shared_ptr<IteratorObject> ArrayObject::iter() const {
+    return makePooled<ArrayIterator>(*this);
+}
+
+Value ArrayObject::item(size_t i) const {
+    if (m_dims == 1) return at(i);
+    size_t shape[2] = {m_shape[1], 1};
+    std::ptrdiff_t strides[2] = {m_strides[1], 1};
+    return makePooled<ArrayObject>(m_buffer, m_data + static_cast<std::ptrdiff_t>(i) * m_strides[0], 1, shape,
+                                   strides);
+}
+
+std::shared_ptr<ArrayObject> ArrayObject::transposed() const {
+    size_t shape[2] = {m_shape[0], m_shape[1]};
+    std::ptrdiff_t strides[2] = {m_strides[0], m_strides[1]};
+    if (m_dims == 2) {
+        std::swap(shape[0], shape[1]);
+        std::swap(strides[0], strides[1]);
+    }
+    return makePooled<ArrayObject>(m_buffer, m_data, m_dims, shape, strides);
+}
+
+const double* ArrayObject::rowMajor(Buffer& scratch) const {
+    if (contiguous()) return m_data;
+    scratch.resize(size());
+    double* out = scratch.data();
+    for (size_t i = 0; i < m_shape[0]; ++i) {
+        for (size_t j = 0; j < m_shape[1]; ++j) *out++ = at(i, j);
+    }
+    return scratch.data();
+}
+
+
+ArrayIterator::ArrayIterator(const ArrayObject& array) : array(array), index(0) {}
+
+std::string ArrayIterator::type_name() const {
+    return "array_iterator";
+}
+
+bool ArrayIterator::has_next() const {
+    return index < array.rows();
+}
+
+Value ArrayIterator::next() {
+    if (!has_next()) return Value();
+    return array.item(index++);
+}
@@ -1,30 +1,49 @@
 #include "objects/ListObject.h"
 #include "objects/IteratorObject.h"
 #include <memory>
+#include "objects/ObjectPool.h"
 
 ListObject::ListObject() {}
-ListObject::ListObject(const std::vector<ObjectPtr>& items) : items(items) {}
+
+ListObject::ListObject(std::vector<Value> items) {
+    for (const Value& item : items) {
+        if (!item.is_number()) {
+            m_packed = false;
+            m_items = std::move(items);
+            return;
+        }
+    }
+    m_numbers.reserve(items.size());
+    for (const Value& item : items) m_numbers.push_back(item.as_number());
+}
+
+ListObject::ListObject(std::vector<double> numbers) : m_numbers(std::move(numbers)) {}
 
 std::string ListObject::type_name() const {
     return "list";
 }
 
 std::shared_ptr<IteratorObject> ListObject::iter() const {
-    return std::make_shared<ListIterator>(items);
+    return makePooled<ListIterator>(*this);
 }
 
 
-ListIterator::ListIterator(const std::vector<ObjectPtr>& items) : items(items), index(0) {}
+ListIterator::ListIterator(const ListObject& list)
+    : numbers(list.packed() ? list.numbers().data() : nullptr),
+      items(list.packed() ? nullptr : list.values().data()),
+      size(list.size()),
+      index(0) {}
 
 std::string ListIterator::type_name() const {
     return "list_iterator";
 }
 
 bool ListIterator::has_next() const {
-    return index < items.size();
+    return index < size;
 }
 
-ObjectPtr ListIterator::next() {
-    if (!has_next()) return nullptr;
+Value ListIterator::next() {
+    if (!has_next()) return Value();
+    if (numbers) return numbers[index++];
     return items[index++];
 }
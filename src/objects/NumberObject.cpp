@@ -1,7 +0,0 @@
-#include "objects/NumberObject.h"
-
-NumberObject::NumberObject(double v) : value(v) {}
-
-std::string NumberObject::type_name() const {
-    return "number";
-}
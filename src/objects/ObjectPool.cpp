@@ -0,0 +1,20 @@
+#include "objects/ObjectPool.h"
+
+thread_local ObjectPool* ObjectPool::s_current = nullptr;
+
+ObjectPool::~ObjectPool() {
+    for (void* slab : m_slabs) ::operator delete(slab);
+}
+
+// Carves a fresh slab into blocks of one size class.
+void ObjectPool::refill(size_t sizeClass) {
+    size_t blockSize = (sizeClass + 1) * kGranularity;
+    char* slab = static_cast<char*>(::operator new(kSlabSize));
+    m_slabs.push_back(slab);
+
+    FreeBlock* head = m_freeLists[sizeClass];
+    for (size_t offset = kSlabSize - kSlabSize % blockSize; offset >= blockSize; offset -= blockSize) {
+        head = new (slab + offset - blockSize) FreeBlock{head};
+    }
+    m_freeLists[sizeClass] = head;
+}
@@ -1,5 +1,5 @@
 #include "objects/RangeObject.h"
-#include "objects/NumberObject.h"
+#include "objects/ObjectPool.h"
 
 RangeObject::RangeObject(double start, double stop, double step)
     : start(start), stop(stop), step(step) {}
@@ -9,24 +9,22 @@ std::string RangeObject::type_name() const {
 }
 
 std::shared_ptr<IteratorObject> RangeObject::iter() const {
-    return std::make_shared<RangeIterator>(start, stop, step);
+    return makePooled<RangeIterator>(start, stop, step);
 }
 
 
 RangeIterator::RangeIterator(double start, double stop, double step)
-    : current(start), stop(stop), step(step), forward(step > 0) {}
+    : counter(start, stop, step) {}
 
 std::string RangeIterator::type_name() const {
     return "range_iterator";
 }
 
 bool RangeIterator::has_next() const {
-    return forward ? (current < stop) : (current > stop);
+    return counter.has_next();
 }
 
-ObjectPtr RangeIterator::next() {
-    if (!has_next()) return nullptr;
-    double val = current;
-    current += step;
-    return std::make_shared<NumberObject>(val);
+Value RangeIterator::next() {
+    if (!counter.has_next()) return Value();
+    return counter.next();
 }
@@ -1,6 +1,7 @@
 #include <memory>
 #include "objects/StringObject.h"
 #include "objects/IteratorObject.h"
+#include "objects/ObjectPool.h"
 
 StringObject::StringObject(const std::string& v) : value(v) {}
 
@@ -9,7 +10,7 @@ std::string StringObject::type_name() const {
 }
 
 std::shared_ptr<IteratorObject> StringObject::iter() const {
-    return std::make_shared<StringIterator>(value);
+    return makePooled<StringIterator>(value);
 }
 
 
@@ -19,10 +20,10 @@ bool StringIterator::has_next() const {
     return index < str.size(); 
 }
 
-ObjectPtr StringIterator::next() {
-    if (!has_next()) return nullptr;
+Value StringIterator::next() {
+    if (!has_next()) return Value();
     char c = str[index++];
-    return std::make_shared<StringObject>(std::string(1, c));
+    return makePooled<StringObject>(std::string(1, c));
 }
 
 std::string StringIterator::type_name() const { 